@@ -0,0 +1,323 @@
+#include "common/asset_pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Layout of the start of a pack, the entries and then the ranges follow it
+struct asset_pack_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t rangeCount;
+    uint64_t fileSize;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(asset_pack_header) == 32, "asset_pack_header must match the file layout");
+static_assert(sizeof(asset_pack_entry) == 96, "asset_pack_entry must match the file layout");
+static_assert(sizeof(asset_pack_range) == 16, "asset_pack_range must match the file layout");
+
+static const char packMagic[4] = {'A', 'P', 'A', 'K'};
+static const uint32_t packVersion = 1;
+static const size_t packAlignment = 64;
+
+static size_t alignUp(size_t value) {
+    return (value + packAlignment - 1) / packAlignment * packAlignment;
+}
+
+asset_pack::~asset_pack() {
+    close();
+}
+
+bool asset_pack::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(handle, &fileSize);
+    HANDLE mappingHandle = fileSize.QuadPart > 0 ? CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr)
+                                                 : nullptr;
+    void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "Failed to map " << path << std::endl;
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(handle);
+        return false;
+    }
+    file = handle;
+    fileMapping = mappingHandle;
+    mapping = static_cast<const unsigned char*>(view);
+    mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    void* view = MAP_FAILED;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    // The mapping keeps the file alive on its own
+    ::close(descriptor);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << std::endl;
+        return false;
+    }
+    mapping = static_cast<const unsigned char*>(view);
+    mappingSize = static_cast<size_t>(status.st_size);
+#endif
+
+    // Check the table of contents once, the accessors trust it afterwards
+    asset_pack_header header;
+    bool valid = mappingSize >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, mapping, sizeof(header));
+        size_t tableEnd = sizeof(header) + static_cast<size_t>(header.entryCount) * sizeof(asset_pack_entry) +
+                          static_cast<size_t>(header.rangeCount) * sizeof(asset_pack_range);
+        valid = std::memcmp(header.magic, packMagic, sizeof(packMagic)) == 0 && header.version == packVersion &&
+                header.fileSize == mappingSize && tableEnd <= mappingSize;
+    }
+    if (valid) {
+        entries = reinterpret_cast<const asset_pack_entry*>(mapping + sizeof(header));
+        ranges = reinterpret_cast<const asset_pack_range*>(entries + header.entryCount);
+        entryCount = header.entryCount;
+        for (uint32_t i = 0; i < header.rangeCount && valid; ++i) {
+            valid = ranges[i].offset <= mappingSize && ranges[i].size <= mappingSize - ranges[i].offset;
+        }
+        for (uint32_t i = 0; i < entryCount && valid; ++i) {
+            valid = entries[i].name[sizeof(entries[i].name) - 1] == '\0' &&
+                    entries[i].firstRange <= header.rangeCount &&
+                    entries[i].rangeCount <= header.rangeCount - entries[i].firstRange;
+        }
+    }
+
+    if (!valid) {
+        std::cerr << "Invalid asset pack " << path << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void asset_pack::close() {
+    if (mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping);
+        CloseHandle(static_cast<HANDLE>(fileMapping));
+        CloseHandle(static_cast<HANDLE>(file));
+        file = nullptr;
+        fileMapping = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(mapping), mappingSize);
+#endif
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    entries = nullptr;
+    ranges = nullptr;
+    entryCount = 0;
+}
+
+bool asset_pack::isOpen() const {
+    return mapping != nullptr;
+}
+
+size_t asset_pack::size() const {
+    return entryCount;
+}
+
+const asset_pack_entry& asset_pack::entry(size_t index) const {
+    return entries[index];
+}
+
+const asset_pack_entry* asset_pack::find(const std::string& name) const {
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        if (name == entries[i].name) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+const unsigned char* asset_pack::range(const asset_pack_entry& entry, uint32_t index, size_t* size) const {
+    if (index >= entry.rangeCount) {
+        if (size) {
+            *size = 0;
+        }
+        return nullptr;
+    }
+    const asset_pack_range& r = ranges[entry.firstRange + index];
+    if (size) {
+        *size = static_cast<size_t>(r.size);
+    }
+    return mapping + r.offset;
+}
+
+void asset_pack::prefetch(const asset_pack_entry& entry) const {
+#ifndef _WIN32
+    // madvise wants a page aligned start
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (uint32_t i = 0; i < entry.rangeCount; ++i) {
+        const asset_pack_range& r = ranges[entry.firstRange + i];
+        size_t start = static_cast<size_t>(r.offset) / page * page;
+        madvise(const_cast<unsigned char*>(mapping) + start, static_cast<size_t>(r.offset + r.size) - start,
+                MADV_WILLNEED);
+    }
+#else
+    (void)entry;
+#endif
+}
+
+size_t asset_pack::mappedBytes() const {
+    return mappingSize;
+}
+
+asset_pack_writer::pending_asset* asset_pack_writer::add(const std::string& name, asset_kind kind) {
+    pending_asset asset = {};
+    if (name.empty() || name.size() >= sizeof(asset.entry.name)) {
+        std::cerr << "Asset name \"" << name << "\" must have 1 to " << sizeof(asset.entry.name) - 1 << " bytes"
+                  << std::endl;
+        return nullptr;
+    }
+    for (const pending_asset& other : assets) {
+        if (name == other.entry.name) {
+            std::cerr << "Asset name \"" << name << "\" is used twice" << std::endl;
+            return nullptr;
+        }
+    }
+
+    std::memcpy(asset.entry.name, name.c_str(), name.size());
+    asset.entry.kind = static_cast<uint32_t>(kind);
+    assets.push_back(std::move(asset));
+    return &assets.back();
+}
+
+bool asset_pack_writer::addTexture(const std::string& name, const mip_chain& chain) {
+    pending_asset* asset = add(name, asset_kind::texture);
+    if (!asset) {
+        return false;
+    }
+    asset->entry.format = static_cast<uint32_t>(chain.channels);
+    asset->entry.flags = chain.srgb ? assetPackSrgb : 0;
+    asset->entry.width = static_cast<uint32_t>(chain.width);
+    asset->entry.height = static_cast<uint32_t>(chain.height);
+    for (const mip_level& level : chain.levels) {
+        const unsigned char* data = chain.data.data() + level.offset;
+        asset->ranges.emplace_back(data, data + level.size);
+    }
+    return true;
+}
+
+bool asset_pack_writer::addCompressedTexture(const std::string& name, const compressed_texture& texture) {
+    pending_asset* asset = add(name, asset_kind::compressed_texture);
+    if (!asset) {
+        return false;
+    }
+    asset->entry.format = static_cast<uint32_t>(texture.format);
+    asset->entry.flags = texture.srgb ? assetPackSrgb : 0;
+    asset->entry.width = static_cast<uint32_t>(texture.width);
+    asset->entry.height = static_cast<uint32_t>(texture.height);
+    for (const mip_level& level : texture.levels) {
+        const unsigned char* data = texture.data.data() + level.offset;
+        asset->ranges.emplace_back(data, data + level.size);
+    }
+    return true;
+}
+
+bool asset_pack_writer::addMesh(const std::string& name, const void* vertices, size_t vertexCount, size_t stride,
+                                const uint32_t* indices, size_t indexCount) {
+    pending_asset* asset = add(name, asset_kind::mesh);
+    if (!asset) {
+        return false;
+    }
+    asset->entry.format = static_cast<uint32_t>(stride);
+    asset->entry.width = static_cast<uint32_t>(vertexCount);
+    asset->entry.height = static_cast<uint32_t>(indexCount);
+    const unsigned char* vertexBytes = static_cast<const unsigned char*>(vertices);
+    const unsigned char* indexBytes = reinterpret_cast<const unsigned char*>(indices);
+    asset->ranges.emplace_back(vertexBytes, vertexBytes + vertexCount * stride);
+    asset->ranges.emplace_back(indexBytes, indexBytes + indexCount * sizeof(uint32_t));
+    return true;
+}
+
+bool asset_pack_writer::write(const std::string& path) const {
+    std::vector<asset_pack_entry> table;
+    std::vector<asset_pack_range> rangeTable;
+    for (const pending_asset& asset : assets) {
+        asset_pack_entry entry = asset.entry;
+        entry.firstRange = static_cast<uint32_t>(rangeTable.size());
+        entry.rangeCount = static_cast<uint32_t>(asset.ranges.size());
+        table.push_back(entry);
+        for (const std::vector<unsigned char>& data : asset.ranges) {
+            rangeTable.push_back({0, data.size()});
+        }
+    }
+
+    // The data follows the tables, every range starts on an aligned offset
+    size_t offset = sizeof(asset_pack_header) + table.size() * sizeof(asset_pack_entry) +
+                    rangeTable.size() * sizeof(asset_pack_range);
+    for (asset_pack_range& r : rangeTable) {
+        offset = alignUp(offset);
+        r.offset = offset;
+        offset += static_cast<size_t>(r.size);
+    }
+
+    asset_pack_header header = {};
+    std::memcpy(header.magic, packMagic, sizeof(packMagic));
+    header.version = packVersion;
+    header.entryCount = static_cast<uint32_t>(table.size());
+    header.rangeCount = static_cast<uint32_t>(rangeTable.size());
+    header.fileSize = offset;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(asset_pack_entry));
+    file.write(reinterpret_cast<const char*>(rangeTable.data()), rangeTable.size() * sizeof(asset_pack_range));
+
+    size_t written = sizeof(asset_pack_header) + table.size() * sizeof(asset_pack_entry) +
+                     rangeTable.size() * sizeof(asset_pack_range);
+    size_t index = 0;
+    static const char padding[packAlignment] = {};
+    for (const pending_asset& asset : assets) {
+        for (const std::vector<unsigned char>& data : asset.ranges) {
+            const asset_pack_range& r = rangeTable[index++];
+            file.write(padding, static_cast<std::streamsize>(r.offset - written));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            written = static_cast<size_t>(r.offset + r.size);
+        }
+    }
+
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+size_t asset_pack_writer::size() const {
+    return assets.size();
+}
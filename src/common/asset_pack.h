@@ -0,0 +1,122 @@
+// Packed assets mapped into memory.
+//
+// An asset pack holds textures and meshes in the form the GPU takes them:
+// every texture level already decoded to 8-bit pixels or BCn blocks, and
+// vertex and index buffers as they are drawn. A table of contents at the
+// start of the file names each asset and points at its ranges, which start
+// at 64-byte boundaries.
+//
+// asset_pack maps the whole file (mmap, MapViewOfFile on Windows) and
+// hands out pointers into the mapping, so loading an asset is one
+// glTexSubImage2D or glBufferData per range straight from the page cache:
+// nothing is read into a heap buffer, inflated or decoded, and pages are
+// only touched when they are uploaded. prefetch() asks the kernel to read
+// the ranges of an asset ahead.
+//
+// asset_pack_writer builds packs, pack_assets writes them from images,
+// cooked .mips files, DDS/KTX2 files and OBJ meshes.
+
+#ifndef OPENGL_TASKS_ASSET_PACK_H
+#define OPENGL_TASKS_ASSET_PACK_H
+
+#include "common/compressed_texture.h"
+#include "common/mip_chain.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class asset_kind : uint32_t { texture = 1, compressed_texture = 2, mesh = 3 };
+
+// Table of contents entry as stored in the file
+struct asset_pack_entry {
+    char name[64];
+    uint32_t kind;
+    uint32_t format;     // channels of a texture, block_format of a compressed one, vertex stride of a mesh
+    uint32_t flags;      // assetPackSrgb
+    uint32_t width;      // vertex count of a mesh
+    uint32_t height;     // index count of a mesh
+    uint32_t firstRange; // levels of a texture, vertices then 32-bit indices of a mesh
+    uint32_t rangeCount;
+    uint32_t reserved;
+};
+
+struct asset_pack_range {
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+};
+
+static const uint32_t assetPackSrgb = 1;
+
+class asset_pack {
+public:
+    asset_pack() = default;
+
+    // Unmaps the file
+    ~asset_pack();
+
+    asset_pack(const asset_pack&) = delete;
+    asset_pack& operator=(const asset_pack&) = delete;
+
+    // Function to map a pack, returns false if it is missing or invalid
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const;
+
+    // Number of assets and the entry of each one
+    size_t size() const;
+    const asset_pack_entry& entry(size_t index) const;
+
+    // The entry of a named asset, nullptr if there is none
+    const asset_pack_entry* find(const std::string& name) const;
+
+    // Pointer to a range of an asset in the mapping, size receives its bytes
+    const unsigned char* range(const asset_pack_entry& entry, uint32_t index, size_t* size = nullptr) const;
+
+    // Function to ask the kernel to start reading the ranges of an asset
+    void prefetch(const asset_pack_entry& entry) const;
+
+    size_t mappedBytes() const;
+
+private:
+    const unsigned char* mapping = nullptr;
+    size_t mappingSize = 0;
+    const asset_pack_entry* entries = nullptr;
+    const asset_pack_range* ranges = nullptr;
+    uint32_t entryCount = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* fileMapping = nullptr;
+#endif
+};
+
+// Collects assets and writes them as a pack
+class asset_pack_writer {
+public:
+    // Functions to add an asset, return false if the name is taken or longer than 63 bytes
+    bool addTexture(const std::string& name, const mip_chain& chain);
+    bool addCompressedTexture(const std::string& name, const compressed_texture& texture);
+    bool addMesh(const std::string& name, const void* vertices, size_t vertexCount, size_t stride,
+                 const uint32_t* indices, size_t indexCount);
+
+    // Function to write every asset added so far, returns false on failure
+    bool write(const std::string& path) const;
+
+    size_t size() const;
+
+private:
+    struct pending_asset {
+        asset_pack_entry entry;
+        std::vector<std::vector<unsigned char>> ranges;
+    };
+
+    // Function to start an entry, returns nullptr if the name cannot be used
+    pending_asset* add(const std::string& name, asset_kind kind);
+
+    std::vector<pending_asset> assets;
+};
+
+#endif // OPENGL_TASKS_ASSET_PACK_H
@@ -0,0 +1,938 @@
+#include "common/block_compression.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+// One 4x4 block as RGBA8, pixels row by row
+typedef unsigned char block_pixels[16][4];
+
+// Interpolation weights of the 4-bit and 2-bit BC7 indices, out of 64
+static const int bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+static const int bc7Weights2[4] = {0, 21, 43, 64};
+
+int blockBytes(block_format format) {
+    return format == block_format::bc1 ? 8 : 16;
+}
+
+size_t compressedSize(block_format format, int width, int height) {
+    return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * blockBytes(format);
+}
+
+const char* blockFormatName(block_format format) {
+    switch (format) {
+    case block_format::bc1:
+        return "BC1";
+    case block_format::bc3:
+        return "BC3";
+    case block_format::bc5:
+        return "BC5";
+    default:
+        return "BC7";
+    }
+}
+
+// Function to split rows into contiguous ranges, one per thread
+static void parallelRows(int rows, int threads, const std::function<void(int, int)>& work) {
+    threads = std::min(threads, rows);
+    if (threads <= 1) {
+        work(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        int begin = rows * t / threads, end = rows * (t + 1) / threads;
+        workers.emplace_back(work, begin, end);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Function to read a block, pixels past the right and bottom edges repeat the last column and row
+static void loadBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, block_pixels block) {
+    for (int y = 0; y < 4; ++y) {
+        int sourceY = std::min(blockY * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sourceX = std::min(blockX * 4 + x, width - 1);
+            std::memcpy(block[y * 4 + x], rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+        }
+    }
+}
+
+// Function to write the pixels of a block that lie inside the image
+static void storeBlock(const block_pixels block, int width, int height, int blockX, int blockY, unsigned char* rgba) {
+    for (int y = 0; y < 4 && blockY * 4 + y < height; ++y) {
+        for (int x = 0; x < 4 && blockX * 4 + x < width; ++x) {
+            size_t pixel = static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x;
+            std::memcpy(rgba + pixel * 4, block[y * 4 + x], 4);
+        }
+    }
+}
+
+// Function to find the mean of points and their principal axis, by power iteration on the covariance
+static void principalAxis(const float points[][4], int count, int channels, float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; ++c) {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (int i = 0; i < count; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            mean[c] += points[i][c] / static_cast<float>(count);
+        }
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < count; ++i) {
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // Start from the column of the widest channel, it is never orthogonal to the axis
+    int widest = 0;
+    for (int c = 1; c < channels; ++c) {
+        if (covariance[c][c] > covariance[widest][widest]) {
+            widest = c;
+        }
+    }
+    for (int c = 0; c < channels; ++c) {
+        axis[c] = covariance[c][widest];
+    }
+
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length += next[a] * next[a];
+        }
+        if (length <= 0.0f) {
+            break;
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < channels; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+}
+
+// Function to place the endpoints at the extreme projections of the points on the axis
+static void axisEndpoints(const float points[][4], int count, int channels, const float mean[4], const float axis[4],
+                          float low[4], float high[4]) {
+    float lowest = 0.0f, highest = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            t += (points[i][c] - mean[c]) * axis[c];
+        }
+        lowest = std::min(lowest, t);
+        highest = std::max(highest, t);
+    }
+    for (int c = 0; c < 4; ++c) {
+        low[c] = c < channels ? std::clamp(mean[c] + lowest * axis[c], 0.0f, 255.0f) : 255.0f;
+        high[c] = c < channels ? std::clamp(mean[c] + highest * axis[c], 0.0f, 255.0f) : 255.0f;
+    }
+}
+
+// Function to fit the endpoints that minimize the squared error of the points at their weights, 0 being low
+// and 1 high. Returns false when the weights cannot separate the endpoints.
+static bool fitEndpoints(const float points[][4], const float weights[], int count, int channels, float low[4],
+                         float high[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ap[4] = {}, bp[4] = {};
+    for (int i = 0; i < count; ++i) {
+        float t = weights[i], s = 1.0f - t;
+        aa += s * s;
+        ab += s * t;
+        bb += t * t;
+        for (int c = 0; c < channels; ++c) {
+            ap[c] += s * points[i][c];
+            bp[c] += t * points[i][c];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (std::fabs(determinant) < 1e-6f) {
+        return false;
+    }
+    for (int c = 0; c < channels; ++c) {
+        low[c] = std::clamp((ap[c] * bb - bp[c] * ab) / determinant, 0.0f, 255.0f);
+        high[c] = std::clamp((bp[c] * aa - ap[c] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// BC1 colors
+
+static uint16_t packColor565(const float color[4]) {
+    int r = std::clamp(static_cast<int>(std::lround(color[0] * 31.0f / 255.0f)), 0, 31);
+    int g = std::clamp(static_cast<int>(std::lround(color[1] * 63.0f / 255.0f)), 0, 63);
+    int b = std::clamp(static_cast<int>(std::lround(color[2] * 31.0f / 255.0f)), 0, 31);
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static void unpackColor565(uint16_t color, int rgb[3]) {
+    int r = color >> 11 & 31, g = color >> 5 & 63, b = color & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+}
+
+// Function to build the four colors of a block. BC1 switches to three colors and transparent black when
+// color0 <= color1, the color of a BC3 block always has four.
+static void colorPalette(uint16_t color0, uint16_t color1, bool alwaysFour, int palette[4][4]) {
+    int a[3], b[3];
+    unpackColor565(color0, a);
+    unpackColor565(color1, b);
+    bool four = alwaysFour || color0 > color1;
+    for (int c = 0; c < 3; ++c) {
+        palette[0][c] = a[c];
+        palette[1][c] = b[c];
+        palette[2][c] = four ? (2 * a[c] + b[c]) / 3 : (a[c] + b[c]) / 2;
+        palette[3][c] = four ? (a[c] + 2 * b[c]) / 3 : 0;
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = four ? 255 : 0;
+}
+
+struct color_block {
+    uint16_t color0 = 0;
+    uint16_t color1 = 0;
+    uint32_t indices = 0;
+    int error = INT_MAX;
+};
+
+// Function to quantize the endpoints and index every pixel, keeps the result in best if its error is lower.
+// weights receive the position of each opaque pixel between the endpoints for the next fit.
+static void tryColorEndpoints(const block_pixels block, bool bc1, bool threeColors, const float low[4],
+                              const float high[4], color_block& best, float weights[16]) {
+    uint16_t a = packColor565(low), b = packColor565(high);
+    color_block candidate;
+    if (!bc1) {
+        candidate.color0 = a;
+        candidate.color1 = b;
+    } else if (threeColors) {
+        candidate.color0 = std::min(a, b);
+        candidate.color1 = std::max(a, b);
+    } else {
+        candidate.color0 = std::max(a, b);
+        candidate.color1 = std::min(a, b);
+    }
+
+    int palette[4][4];
+    colorPalette(candidate.color0, candidate.color1, !bc1, palette);
+    int selectable = !bc1 || candidate.color0 > candidate.color1 ? 4 : 3;
+    static const float fourWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    static const float threeWeights[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+    const float* indexWeights = selectable == 4 ? fourWeights : threeWeights;
+
+    candidate.error = 0;
+    int opaque = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint32_t index = 3;
+        if (!bc1 || block[i][3] >= 128) {
+            int nearest = INT_MAX;
+            for (int p = 0; p < selectable; ++p) {
+                int dr = palette[p][0] - block[i][0], dg = palette[p][1] - block[i][1];
+                int db = palette[p][2] - block[i][2];
+                int error = dr * dr + dg * dg + db * db;
+                if (error < nearest) {
+                    nearest = error;
+                    index = static_cast<uint32_t>(p);
+                }
+            }
+            candidate.error += nearest;
+            weights[opaque++] = indexWeights[index];
+        }
+        candidate.indices |= index << (2 * i);
+    }
+
+    if (candidate.error < best.error) {
+        best = candidate;
+    }
+}
+
+// Function to encode the color of a block, BC1 blocks with pixels below half alpha use three colors and
+// transparent black
+static void encodeColorBlock(const block_pixels block, bool bc1, block_quality quality, unsigned char out[8]) {
+    float points[16][4];
+    int count = 0;
+    bool transparent = false;
+    for (int i = 0; i < 16; ++i) {
+        if (bc1 && block[i][3] < 128) {
+            transparent = true;
+            continue;
+        }
+        for (int c = 0; c < 4; ++c) {
+            points[count][c] = block[i][c];
+        }
+        count++;
+    }
+
+    color_block best;
+    if (count == 0) {
+        // Every pixel takes the transparent entry
+        best.indices = 0xFFFFFFFFu;
+        best.error = 0;
+    } else {
+        float mean[4], axis[4], low[4], high[4];
+        principalAxis(points, count, 3, mean, axis);
+        axisEndpoints(points, count, 3, mean, axis, low, high);
+        int refinements = quality == block_quality::fast ? 0 : quality == block_quality::normal ? 2 : 8;
+
+        // Transparent pixels need three colors, the best quality also tries them on opaque blocks
+        for (int mode = 0; mode < 2; ++mode) {
+            bool threeColors = mode == 1;
+            if (bc1 ? (threeColors ? !transparent && quality != block_quality::high : transparent) : threeColors) {
+                continue;
+            }
+
+            float l[4], h[4], weights[16];
+            std::memcpy(l, low, sizeof(l));
+            std::memcpy(h, high, sizeof(h));
+            for (int iteration = 0;; ++iteration) {
+                tryColorEndpoints(block, bc1, threeColors, l, h, best, weights);
+                if (iteration == refinements || !fitEndpoints(points, weights, count, 3, l, h)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(best.color0 & 0xFF);
+    out[1] = static_cast<unsigned char>(best.color0 >> 8);
+    out[2] = static_cast<unsigned char>(best.color1 & 0xFF);
+    out[3] = static_cast<unsigned char>(best.color1 >> 8);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = static_cast<unsigned char>(best.indices >> (8 * i));
+    }
+}
+
+// Single channel blocks, the alpha of BC3 and each channel of BC5
+
+// Function to build the eight values of a channel block, six interpolated ones plus 0 and 255 when
+// value0 <= value1
+static void channelPalette(int value0, int value1, int palette[8]) {
+    palette[0] = value0;
+    palette[1] = value1;
+    if (value0 > value1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Function to index every value of a channel block, returns the squared error
+static int channelIndices(const unsigned char values[16], int value0, int value1, uint64_t& indices) {
+    int palette[8];
+    channelPalette(value0, value1, palette);
+    int error = 0;
+    indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        int nearest = INT_MAX;
+        uint64_t index = 0;
+        for (int p = 0; p < 8; ++p) {
+            int d = palette[p] - values[i];
+            if (d * d < nearest) {
+                nearest = d * d;
+                index = static_cast<uint64_t>(p);
+            }
+        }
+        error += nearest;
+        indices |= index << (3 * i);
+    }
+    return error;
+}
+
+static void encodeChannelBlock(const unsigned char values[16], block_quality quality, unsigned char out[8]) {
+    int lowest = 255, highest = 0;
+    int innerLowest = 255, innerHighest = 0;
+    for (int i = 0; i < 16; ++i) {
+        lowest = std::min(lowest, static_cast<int>(values[i]));
+        highest = std::max(highest, static_cast<int>(values[i]));
+        if (values[i] != 0 && values[i] != 255) {
+            innerLowest = std::min(innerLowest, static_cast<int>(values[i]));
+            innerHighest = std::max(innerHighest, static_cast<int>(values[i]));
+        }
+    }
+
+    // Endpoints are moved inwards by up to search steps, clustered values often sit closer to the middle
+    int search = quality == block_quality::fast ? 0 : quality == block_quality::normal ? 2 : 4;
+    int bestError = INT_MAX, best0 = highest, best1 = lowest;
+    uint64_t bestIndices = 0;
+    auto tryEndpoints = [&](int value0, int value1) {
+        uint64_t indices;
+        int error = channelIndices(values, value0, value1, indices);
+        if (error < bestError) {
+            bestError = error;
+            best0 = value0;
+            best1 = value1;
+            bestIndices = indices;
+        }
+    };
+
+    // Eight interpolated values need value0 > value1
+    for (int d0 = 0; d0 <= search; ++d0) {
+        for (int d1 = 0; d1 <= search; ++d1) {
+            if (highest - d0 > lowest + d1 || (d0 == 0 && d1 == 0)) {
+                tryEndpoints(highest - d0, lowest + d1);
+            }
+        }
+    }
+
+    // Six values between the inner extremes, with exact 0 and 255 for the rest
+    if (quality == block_quality::high && innerLowest <= innerHighest) {
+        for (int d0 = 0; d0 <= search; ++d0) {
+            for (int d1 = 0; d1 <= search; ++d1) {
+                if (innerLowest + d0 <= innerHighest - d1) {
+                    tryEndpoints(innerLowest + d0, innerHighest - d1);
+                }
+            }
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(best0);
+    out[1] = static_cast<unsigned char>(best1);
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<unsigned char>(bestIndices >> (8 * i));
+    }
+}
+
+// BC7 mode 6: 7-bit RGBA endpoints, one p-bit each as their lowest bit, 4-bit indices shared by color and alpha
+
+struct bc7_block {
+    int endpoints[2][4] = {};
+    int pbits[2] = {};
+    int indices[16] = {};
+    int error = INT_MAX;
+};
+
+// Function to quantize an endpoint to 7 bits per channel below the given p-bit
+static void quantizeBc7(const float endpoint[4], int pbit, int quantized[4]) {
+    for (int c = 0; c < 4; ++c) {
+        quantized[c] = std::clamp(static_cast<int>(std::lround((endpoint[c] - pbit) / 2.0f)), 0, 127);
+    }
+}
+
+// Function to index every pixel against the expanded endpoints, returns the squared error
+static int bc7Indices(const block_pixels block, const bc7_block& candidate, int indices[16]) {
+    int palette[16][4];
+    for (int w = 0; w < 16; ++w) {
+        for (int c = 0; c < 4; ++c) {
+            int e0 = candidate.endpoints[0][c] << 1 | candidate.pbits[0];
+            int e1 = candidate.endpoints[1][c] << 1 | candidate.pbits[1];
+            palette[w][c] = ((64 - bc7Weights[w]) * e0 + bc7Weights[w] * e1 + 32) >> 6;
+        }
+    }
+
+    int error = 0;
+    for (int i = 0; i < 16; ++i) {
+        int nearest = INT_MAX;
+        for (int w = 0; w < 16; ++w) {
+            int distance = 0;
+            for (int c = 0; c < 4; ++c) {
+                int d = palette[w][c] - block[i][c];
+                distance += d * d;
+            }
+            if (distance < nearest) {
+                nearest = distance;
+                indices[i] = w;
+            }
+        }
+        error += nearest;
+    }
+    return error;
+}
+
+// Function to choose the p-bit that quantizes an endpoint with the least error
+static int bestPbit(const float endpoint[4]) {
+    float errors[2] = {};
+    for (int pbit = 0; pbit < 2; ++pbit) {
+        int quantized[4];
+        quantizeBc7(endpoint, pbit, quantized);
+        for (int c = 0; c < 4; ++c) {
+            float d = static_cast<float>(quantized[c] << 1 | pbit) - endpoint[c];
+            errors[pbit] += d * d;
+        }
+    }
+    return errors[1] < errors[0] ? 1 : 0;
+}
+
+// Appends values to a block from its lowest bit up
+struct bit_writer {
+    unsigned char* out;
+    int position = 0;
+
+    void write(int value, int bits) {
+        for (int i = 0; i < bits; ++i, ++position) {
+            out[position >> 3] |= static_cast<unsigned char>((value >> i & 1) << (position & 7));
+        }
+    }
+};
+
+struct bit_reader {
+    const unsigned char* in;
+    int position = 0;
+
+    int read(int bits) {
+        int value = 0;
+        for (int i = 0; i < bits; ++i, ++position) {
+            value |= (in[position >> 3] >> (position & 7) & 1) << i;
+        }
+        return value;
+    }
+};
+
+// Function to encode a block in mode 6, returns the squared error
+static int encodeBc7Mode6(const block_pixels block, block_quality quality, unsigned char out[16]) {
+    float points[16][4];
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            points[i][c] = block[i][c];
+        }
+    }
+
+    float mean[4], axis[4], low[4], high[4];
+    principalAxis(points, 16, 4, mean, axis);
+    axisEndpoints(points, 16, 4, mean, axis, low, high);
+    int refinements = quality == block_quality::fast ? 0 : quality == block_quality::normal ? 1 : 4;
+
+    bc7_block best;
+    for (int iteration = 0;; ++iteration) {
+        // The fast quality takes the p-bits that suit each endpoint, the others try all four pairs
+        int lowPbit = bestPbit(low), highPbit = bestPbit(high);
+        bc7_block round;
+        for (int pair = 0; pair < 4; ++pair) {
+            bc7_block candidate;
+            candidate.pbits[0] = pair & 1;
+            candidate.pbits[1] = pair >> 1;
+            if (quality == block_quality::fast && (candidate.pbits[0] != lowPbit || candidate.pbits[1] != highPbit)) {
+                continue;
+            }
+            quantizeBc7(low, candidate.pbits[0], candidate.endpoints[0]);
+            quantizeBc7(high, candidate.pbits[1], candidate.endpoints[1]);
+            candidate.error = bc7Indices(block, candidate, candidate.indices);
+            if (candidate.error < round.error) {
+                round = candidate;
+            }
+        }
+        if (round.error < best.error) {
+            best = round;
+        }
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = static_cast<float>(bc7Weights[round.indices[i]]) / 64.0f;
+        }
+        if (iteration == refinements || best.error == 0 || !fitEndpoints(points, weights, 16, 4, low, high)) {
+            break;
+        }
+    }
+
+    // The first index is stored without its top bit, which has to be 0
+    if (best.indices[0] >= 8) {
+        for (int c = 0; c < 4; ++c) {
+            std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+        }
+        std::swap(best.pbits[0], best.pbits[1]);
+        for (int& index : best.indices) {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(out, 0, 16);
+    bit_writer writer{out};
+    writer.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(best.endpoints[0][c], 7);
+        writer.write(best.endpoints[1][c], 7);
+    }
+    writer.write(best.pbits[0], 1);
+    writer.write(best.pbits[1], 1);
+    writer.write(best.indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(best.indices[i], 4);
+    }
+    return best.error;
+}
+
+// BC7 mode 5: 7-bit RGB and 8-bit alpha endpoints, each with its own 2-bit indices
+
+struct bc7_mode5_block {
+    int color[2][3] = {};
+    int alpha[2] = {};
+    int colorIndices[16] = {};
+    int alphaIndices[16] = {};
+    int error = INT_MAX;
+};
+
+// Function to index channels first to first + channels - 1 of every pixel against two expanded endpoints with
+// the 2-bit weights, returns the squared error
+static int bc7Indices2(const block_pixels block, int first, int channels, const int e0[], const int e1[],
+                       int indices[16]) {
+    int palette[4][3];
+    for (int w = 0; w < 4; ++w) {
+        for (int c = 0; c < channels; ++c) {
+            palette[w][c] = ((64 - bc7Weights2[w]) * e0[c] + bc7Weights2[w] * e1[c] + 32) >> 6;
+        }
+    }
+
+    int error = 0;
+    for (int i = 0; i < 16; ++i) {
+        int nearest = INT_MAX;
+        for (int w = 0; w < 4; ++w) {
+            int distance = 0;
+            for (int c = 0; c < channels; ++c) {
+                int d = palette[w][c] - block[i][first + c];
+                distance += d * d;
+            }
+            if (distance < nearest) {
+                nearest = distance;
+                indices[i] = w;
+            }
+        }
+        error += nearest;
+    }
+    return error;
+}
+
+// Function to encode a block in mode 5, returns the squared error. A rotation above 0 swaps alpha with red, green
+// or blue first, so that channel gets the separate indices.
+static int encodeBc7Mode5(const block_pixels source, int rotation, block_quality quality, unsigned char out[16]) {
+    block_pixels block;
+    std::memcpy(block, source, sizeof(block));
+    if (rotation > 0) {
+        for (int i = 0; i < 16; ++i) {
+            std::swap(block[i][rotation - 1], block[i][3]);
+        }
+    }
+
+    float colors[16][4], alphas[16][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            colors[i][c] = block[i][c];
+        }
+        alphas[i][0] = block[i][3];
+    }
+    int refinements = quality == block_quality::normal ? 1 : 4;
+    bc7_mode5_block best;
+
+    // Color along its principal axis, refined like mode 6
+    float mean[4], axis[4], low[4], high[4];
+    principalAxis(colors, 16, 3, mean, axis);
+    axisEndpoints(colors, 16, 3, mean, axis, low, high);
+    int colorError = INT_MAX;
+    for (int iteration = 0;; ++iteration) {
+        int quantized[2][3], expanded[2][3], indices[16];
+        for (int c = 0; c < 3; ++c) {
+            quantized[0][c] = std::clamp(static_cast<int>(std::lround(low[c] * 127.0f / 255.0f)), 0, 127);
+            quantized[1][c] = std::clamp(static_cast<int>(std::lround(high[c] * 127.0f / 255.0f)), 0, 127);
+            for (int e = 0; e < 2; ++e) {
+                expanded[e][c] = quantized[e][c] << 1 | quantized[e][c] >> 6;
+            }
+        }
+        int error = bc7Indices2(block, 0, 3, expanded[0], expanded[1], indices);
+        if (error < colorError) {
+            colorError = error;
+            std::memcpy(best.color, quantized, sizeof(quantized));
+            std::memcpy(best.colorIndices, indices, sizeof(indices));
+        }
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = static_cast<float>(bc7Weights2[indices[i]]) / 64.0f;
+        }
+        if (iteration == refinements || colorError == 0 || !fitEndpoints(colors, weights, 16, 3, low, high)) {
+            break;
+        }
+    }
+
+    // Alpha between its extremes, refined the same way with exact 8-bit endpoints
+    float alphaLow[4] = {255.0f}, alphaHigh[4] = {0.0f};
+    for (int i = 0; i < 16; ++i) {
+        alphaLow[0] = std::min(alphaLow[0], alphas[i][0]);
+        alphaHigh[0] = std::max(alphaHigh[0], alphas[i][0]);
+    }
+    int alphaError = INT_MAX;
+    for (int iteration = 0;; ++iteration) {
+        int endpoints[2] = {static_cast<int>(std::lround(alphaLow[0])), static_cast<int>(std::lround(alphaHigh[0]))};
+        int indices[16];
+        int error = bc7Indices2(block, 3, 1, &endpoints[0], &endpoints[1], indices);
+        if (error < alphaError) {
+            alphaError = error;
+            std::memcpy(best.alpha, endpoints, sizeof(endpoints));
+            std::memcpy(best.alphaIndices, indices, sizeof(indices));
+        }
+
+        float weights[16];
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = static_cast<float>(bc7Weights2[indices[i]]) / 64.0f;
+        }
+        if (iteration == refinements || alphaError == 0 ||
+            !fitEndpoints(alphas, weights, 16, 1, alphaLow, alphaHigh)) {
+            break;
+        }
+    }
+    best.error = colorError + alphaError;
+
+    // The first index of each set is stored without its top bit, which has to be 0
+    if (best.colorIndices[0] >= 2) {
+        for (int c = 0; c < 3; ++c) {
+            std::swap(best.color[0][c], best.color[1][c]);
+        }
+        for (int& index : best.colorIndices) {
+            index = 3 - index;
+        }
+    }
+    if (best.alphaIndices[0] >= 2) {
+        std::swap(best.alpha[0], best.alpha[1]);
+        for (int& index : best.alphaIndices) {
+            index = 3 - index;
+        }
+    }
+
+    std::memset(out, 0, 16);
+    bit_writer writer{out};
+    writer.write(1 << 5, 6);
+    writer.write(rotation, 2);
+    for (int c = 0; c < 3; ++c) {
+        writer.write(best.color[0][c], 7);
+        writer.write(best.color[1][c], 7);
+    }
+    writer.write(best.alpha[0], 8);
+    writer.write(best.alpha[1], 8);
+    for (int i = 0; i < 16; ++i) {
+        writer.write(best.colorIndices[i], i == 0 ? 1 : 2);
+    }
+    for (int i = 0; i < 16; ++i) {
+        writer.write(best.alphaIndices[i], i == 0 ? 1 : 2);
+    }
+    return best.error;
+}
+
+// Function to encode a BC7 block in mode 6, or in mode 5 when the alpha of the block varies and separate indices
+// for it give a lower error. Mode 6 shares its indices between color and alpha, so alpha that does not follow the
+// color costs it both. The high quality also tries giving the separate indices to red, green or blue instead.
+static void encodeBc7Block(const block_pixels block, block_quality quality, unsigned char out[16]) {
+    int error = encodeBc7Mode6(block, quality, out);
+    bool alphaVaries = false;
+    for (int i = 1; i < 16; ++i) {
+        alphaVaries = alphaVaries || block[i][3] != block[0][3];
+    }
+    if (quality == block_quality::fast || !alphaVaries || error == 0) {
+        return;
+    }
+
+    int rotations = quality == block_quality::high ? 4 : 1;
+    for (int rotation = 0; rotation < rotations; ++rotation) {
+        unsigned char candidate[16];
+        int candidateError = encodeBc7Mode5(block, rotation, quality, candidate);
+        if (candidateError < error) {
+            error = candidateError;
+            std::memcpy(out, candidate, 16);
+        }
+    }
+}
+
+// Function to encode one block in the given format
+static void encodeBlock(const block_pixels block, block_format format, block_quality quality, unsigned char* out) {
+    unsigned char channel[16];
+    switch (format) {
+    case block_format::bc1:
+        encodeColorBlock(block, true, quality, out);
+        break;
+    case block_format::bc3:
+        for (int i = 0; i < 16; ++i) {
+            channel[i] = block[i][3];
+        }
+        encodeChannelBlock(channel, quality, out);
+        encodeColorBlock(block, false, quality, out + 8);
+        break;
+    case block_format::bc5:
+        for (int c = 0; c < 2; ++c) {
+            for (int i = 0; i < 16; ++i) {
+                channel[i] = block[i][c];
+            }
+            encodeChannelBlock(channel, quality, out + 8 * c);
+        }
+        break;
+    case block_format::bc7:
+        encodeBc7Block(block, quality, out);
+        break;
+    }
+}
+
+std::vector<unsigned char> compressBlocks(const unsigned char* rgba, int width, int height, block_format format,
+                                          block_quality quality, int threads) {
+    std::vector<unsigned char> blocks(compressedSize(format, width, height));
+    if (!rgba || width <= 0 || height <= 0) {
+        return blocks;
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    int bytes = blockBytes(format);
+
+    parallelRows(blocksHigh, threads, [&](int begin, int end) {
+        block_pixels block;
+        for (int blockY = begin; blockY < end; ++blockY) {
+            for (int blockX = 0; blockX < blocksWide; ++blockX) {
+                loadBlock(rgba, width, height, blockX, blockY, block);
+                size_t index = static_cast<size_t>(blockY) * blocksWide + blockX;
+                encodeBlock(block, format, quality, blocks.data() + index * bytes);
+            }
+        }
+    });
+    return blocks;
+}
+
+// Function to decode the color half of a BC1 or BC3 block
+static void decodeColorBlock(const unsigned char* in, bool bc1, block_pixels block) {
+    uint16_t color0 = static_cast<uint16_t>(in[0] | in[1] << 8);
+    uint16_t color1 = static_cast<uint16_t>(in[2] | in[3] << 8);
+    int palette[4][4];
+    colorPalette(color0, color1, !bc1, palette);
+    uint32_t indices = static_cast<uint32_t>(in[4]) | static_cast<uint32_t>(in[5]) << 8 |
+                       static_cast<uint32_t>(in[6]) << 16 | static_cast<uint32_t>(in[7]) << 24;
+    for (int i = 0; i < 16; ++i) {
+        const int* color = palette[indices >> (2 * i) & 3];
+        for (int c = 0; c < (bc1 ? 4 : 3); ++c) {
+            block[i][c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+}
+
+// Function to decode a channel block into one channel of the pixels
+static void decodeChannelBlock(const unsigned char* in, int channel, block_pixels block) {
+    int palette[8];
+    channelPalette(in[0], in[1], palette);
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < 16; ++i) {
+        block[i][channel] = static_cast<unsigned char>(palette[indices >> (3 * i) & 7]);
+    }
+}
+
+// Function to decode a BC7 block in mode 5, alpha is swapped with the channel its rotation names
+static void decodeBc7Mode5(const unsigned char* in, block_pixels block) {
+    bit_reader reader{in, 6};
+    int rotation = reader.read(2);
+    int color[2][3];
+    for (int c = 0; c < 3; ++c) {
+        color[0][c] = reader.read(7);
+        color[1][c] = reader.read(7);
+    }
+    int alpha[2];
+    alpha[0] = reader.read(8);
+    alpha[1] = reader.read(8);
+    int colorIndices[16], alphaIndices[16];
+    for (int i = 0; i < 16; ++i) {
+        colorIndices[i] = reader.read(i == 0 ? 1 : 2);
+    }
+    for (int i = 0; i < 16; ++i) {
+        alphaIndices[i] = reader.read(i == 0 ? 1 : 2);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        int weight = bc7Weights2[colorIndices[i]];
+        for (int c = 0; c < 3; ++c) {
+            int e0 = color[0][c] << 1 | color[0][c] >> 6, e1 = color[1][c] << 1 | color[1][c] >> 6;
+            block[i][c] = static_cast<unsigned char>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+        }
+        weight = bc7Weights2[alphaIndices[i]];
+        block[i][3] = static_cast<unsigned char>(((64 - weight) * alpha[0] + weight * alpha[1] + 32) >> 6);
+        if (rotation > 0) {
+            std::swap(block[i][rotation - 1], block[i][3]);
+        }
+    }
+}
+
+// Function to decode a BC7 block in mode 6
+static void decodeBc7Mode6(const unsigned char* in, block_pixels block) {
+    bit_reader reader{in, 7};
+    int endpoints[2][4];
+    for (int c = 0; c < 4; ++c) {
+        endpoints[0][c] = reader.read(7);
+        endpoints[1][c] = reader.read(7);
+    }
+    int pbits[2];
+    pbits[0] = reader.read(1);
+    pbits[1] = reader.read(1);
+    for (int i = 0; i < 16; ++i) {
+        int weight = bc7Weights[reader.read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c) {
+            int e0 = endpoints[0][c] << 1 | pbits[0], e1 = endpoints[1][c] << 1 | pbits[1];
+            block[i][c] = static_cast<unsigned char>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+        }
+    }
+}
+
+// Function to decode a BC7 block, returns false if it is not in mode 5 or 6. The mode is the number of zero
+// bits before the first set one.
+static bool decodeBc7Block(const unsigned char* in, block_pixels block) {
+    if ((in[0] & 0x3F) == 0x20) {
+        decodeBc7Mode5(in, block);
+        return true;
+    }
+    if ((in[0] & 0x7F) == 0x40) {
+        decodeBc7Mode6(in, block);
+        return true;
+    }
+    return false;
+}
+
+bool decompressBlocks(const unsigned char* blocks, int width, int height, block_format format, unsigned char* rgba) {
+    int blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    int bytes = blockBytes(format);
+
+    for (int blockY = 0; blockY < blocksHigh; ++blockY) {
+        for (int blockX = 0; blockX < blocksWide; ++blockX) {
+            const unsigned char* in = blocks + (static_cast<size_t>(blockY) * blocksWide + blockX) * bytes;
+            block_pixels block;
+            std::memset(block, 255, sizeof(block));
+            switch (format) {
+            case block_format::bc1:
+                decodeColorBlock(in, true, block);
+                break;
+            case block_format::bc3:
+                decodeChannelBlock(in, 3, block);
+                decodeColorBlock(in + 8, false, block);
+                break;
+            case block_format::bc5:
+                decodeChannelBlock(in, 0, block);
+                decodeChannelBlock(in + 8, 1, block);
+                for (int i = 0; i < 16; ++i) {
+                    block[i][2] = 0;
+                }
+                break;
+            case block_format::bc7:
+                if (!decodeBc7Block(in, block)) {
+                    return false;
+                }
+                break;
+            }
+            storeBlock(block, width, height, blockX, blockY, rgba);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// Block compression of 8-bit images into the BCn formats GPUs sample directly.
+//
+// Every format stores 4x4 pixel blocks in a fixed number of bytes, so a
+// texture keeps its size on the GPU instead of being expanded to RGBA8:
+//   BC1: RGB with 1-bit alpha, 8 bytes per block (4 bits per pixel)
+//   BC3: BC1 color plus interpolated alpha, 16 bytes per block
+//   BC5: two independent channels (normal maps), 16 bytes per block
+//   BC7: RGBA with 4-bit indices, 16 bytes per block
+//
+// The encoder fits each block's endpoints along the principal axis of its
+// colors and, at higher quality, refines them by least squares, tries more
+// modes and more endpoint candidates. BC7 uses mode 6 (one subset, 7-bit
+// RGBA endpoints with p-bits), which handles smooth color and alpha well
+// without the partition search of the other modes. Its indices are shared
+// by color and alpha, so at normal and high quality blocks whose alpha
+// varies also try mode 5 (7-bit color and 8-bit alpha endpoints, separate
+// 2-bit indices) and keep it when its error is lower. Rows of blocks are
+// split across threads.
+//
+// The decoder reads what the encoder writes, BC7 blocks in modes other
+// than 5 and 6 are rejected. It is meant for measuring the error of a
+// compression.
+
+#ifndef OPENGL_TASKS_BLOCK_COMPRESSION_H
+#define OPENGL_TASKS_BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <vector>
+
+enum class block_format { bc1, bc3, bc5, bc7 };
+
+enum class block_quality { fast, normal, high };
+
+// Bytes of one 4x4 block
+int blockBytes(block_format format);
+
+// Bytes of an image in blocks, partial blocks at the edges count as whole ones
+size_t compressedSize(block_format format, int width, int height);
+
+const char* blockFormatName(block_format format);
+
+// Function to compress tightly packed RGBA8 pixels, threads 0 uses all hardware threads. BC5 keeps red and green.
+std::vector<unsigned char> compressBlocks(const unsigned char* rgba, int width, int height, block_format format,
+                                          block_quality quality, int threads = 0);
+
+// Function to decode blocks into tightly packed RGBA8 pixels, returns false on a BC7 mode other than 5 or 6
+bool decompressBlocks(const unsigned char* blocks, int width, int height, block_format format, unsigned char* rgba);
+
+#endif // OPENGL_TASKS_BLOCK_COMPRESSION_H
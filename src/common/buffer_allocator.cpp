@@ -0,0 +1,264 @@
+#include "common/buffer_allocator.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+// Function to round value up to a multiple of alignment, which need not be a power of two
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+buffer_allocator::buffer_allocator(GLenum target, size_t blockSize, GLenum usage)
+    : target(target), usage(usage), blockSize(blockSize) {
+    GLint alignment = 0;
+    if (target == GL_UNIFORM_BUFFER) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    } else if (target == GL_SHADER_STORAGE_BUFFER && GLAD_GL_VERSION_4_3) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    }
+    if (alignment > 0) {
+        minimumAlignment = static_cast<size_t>(alignment);
+    }
+}
+
+buffer_allocator::~buffer_allocator() {
+    for (const block& entry : blocks) {
+        glDeleteBuffers(1, &entry.buffer);
+    }
+}
+
+int buffer_allocator::addBlock(size_t size) {
+    block entry;
+    entry.size = std::max(size, blockSize);
+    glGenBuffers(1, &entry.buffer);
+    if (entry.buffer == 0) {
+        std::cerr << "Failed to create a buffer block of " << entry.size << " bytes" << std::endl;
+        return -1;
+    }
+
+    // Allocate through the copy binding, so the element array binding of a bound VAO stays untouched
+    glBindBuffer(GL_COPY_WRITE_BUFFER, entry.buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, entry.size, nullptr, usage);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    entry.freeRanges[0] = entry.size;
+    blocks.push_back(entry);
+    return static_cast<int>(blocks.size() - 1);
+}
+
+bool buffer_allocator::allocateFrom(int blockIndex, size_t size, size_t alignment, size_t& offset) {
+    std::map<size_t, size_t>& freeRanges = blocks[blockIndex].freeRanges;
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        size_t start = it->first, end = it->first + it->second;
+        size_t aligned = alignUp(start, alignment);
+        if (aligned + size > end) {
+            continue;
+        }
+
+        // Keep the padding before and the rest after the allocation as free ranges
+        freeRanges.erase(it);
+        if (aligned > start) {
+            freeRanges[start] = aligned - start;
+        }
+        if (aligned + size < end) {
+            freeRanges[aligned + size] = end - aligned - size;
+        }
+        blocks[blockIndex].used += size;
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+int buffer_allocator::allocate(size_t size, size_t alignment) {
+    if (size == 0) {
+        std::cerr << "Can't allocate an empty buffer range" << std::endl;
+        return -1;
+    }
+    alignment = std::lcm(std::max<size_t>(alignment, 1), minimumAlignment);
+
+    int blockIndex = -1;
+    size_t offset = 0;
+    for (size_t i = 0; i < blocks.size() && blockIndex < 0; ++i) {
+        if (allocateFrom(static_cast<int>(i), size, alignment, offset)) {
+            blockIndex = static_cast<int>(i);
+        }
+    }
+    if (blockIndex < 0) {
+        blockIndex = addBlock(size);
+        if (blockIndex < 0 || !allocateFrom(blockIndex, size, alignment, offset)) {
+            return -1;
+        }
+    }
+
+    int id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<int>(allocations.size());
+        allocations.emplace_back();
+    }
+    allocation_record& record = allocations[id];
+    record.block = blockIndex;
+    record.alignment = alignment;
+    record.range = buffer_range{blocks[blockIndex].buffer, offset, size};
+    return id;
+}
+
+void buffer_allocator::free(int allocation) {
+    if (allocation < 0 || allocation >= static_cast<int>(allocations.size()) || allocations[allocation].block < 0) {
+        std::cerr << "Freeing unknown buffer allocation " << allocation << std::endl;
+        return;
+    }
+    allocation_record& record = allocations[allocation];
+    block& owner = blocks[record.block];
+    owner.used -= record.range.size;
+
+    // Merge with the free ranges right before and right after
+    size_t start = record.range.offset, end = start + record.range.size;
+    auto next = owner.freeRanges.lower_bound(start);
+    if (next != owner.freeRanges.end() && next->first == end) {
+        end += next->second;
+        next = owner.freeRanges.erase(next);
+    }
+    if (next != owner.freeRanges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == start) {
+            start = previous->first;
+            owner.freeRanges.erase(previous);
+        }
+    }
+    owner.freeRanges[start] = end - start;
+
+    record = allocation_record();
+    freeIds.push_back(allocation);
+    fragmented = true;
+}
+
+void buffer_allocator::upload(int allocation, const void* data, size_t size, size_t offset) {
+    const buffer_range& target = allocations[allocation].range;
+    if (offset + size > target.size) {
+        std::cerr << "Upload of " << size << " bytes doesn't fit buffer allocation " << allocation << std::endl;
+        return;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, target.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, target.offset + offset, size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+const buffer_range& buffer_allocator::range(int allocation) const {
+    return allocations[allocation].range;
+}
+
+size_t buffer_allocator::defragment() {
+    // Allocations only ever take the first range that fits, holes come from free()
+    if (!fragmented) {
+        return 0;
+    }
+
+    // Live allocations in the order they are stored, so each copy reads the old blocks front to back
+    std::vector<int> live;
+    for (size_t id = 0; id < allocations.size(); ++id) {
+        if (allocations[id].block >= 0) {
+            live.push_back(static_cast<int>(id));
+        }
+    }
+    std::sort(live.begin(), live.end(), [this](int a, int b) {
+        const allocation_record& first = allocations[a];
+        const allocation_record& second = allocations[b];
+        return first.block != second.block ? first.block < second.block : first.range.offset < second.range.offset;
+    });
+
+    // Pack them into fresh blocks, filling one before starting the next. Source and destination would
+    // overlap within one buffer, so everything is copied out of the old blocks and those are released.
+    // A copy of the records lets a failure put every range back.
+    std::vector<block> oldBlocks;
+    oldBlocks.swap(blocks);
+    std::vector<allocation_record> oldAllocations = allocations;
+
+    bool failed = false;
+    size_t copied = 0;
+    size_t end = 0;
+    int current = -1;
+    for (int id : live) {
+        allocation_record& record = allocations[id];
+        size_t offset = current >= 0 ? alignUp(end, record.alignment) : 0;
+        if (current < 0 || offset + record.range.size > blocks[current].size) {
+            current = addBlock(record.range.size);
+            if (current < 0) {
+                failed = true;
+                break;
+            }
+            offset = 0;
+            end = 0;
+        }
+
+        // The free range after the previous allocation shrinks to the padding before this one
+        block& target = blocks[current];
+        target.freeRanges.erase(end);
+        if (offset > end) {
+            target.freeRanges[end] = offset - end;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, oldBlocks[record.block].buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, target.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, record.range.offset, offset, record.range.size);
+        copied += record.range.size;
+
+        record.block = current;
+        record.range.buffer = target.buffer;
+        record.range.offset = offset;
+        target.used += record.range.size;
+        end = offset + record.range.size;
+        if (end < target.size) {
+            target.freeRanges[end] = target.size - end;
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    // The old blocks were only read, so dropping the new ones leaves every range where it was
+    if (failed) {
+        for (const block& entry : blocks) {
+            glDeleteBuffers(1, &entry.buffer);
+        }
+        blocks.swap(oldBlocks);
+        allocations.swap(oldAllocations);
+        std::cerr << "Defragmentation stopped, the buffer ranges stay where they are" << std::endl;
+        return 0;
+    }
+
+    for (const block& entry : oldBlocks) {
+        glDeleteBuffers(1, &entry.buffer);
+    }
+
+    fragmented = false;
+    rangeGeneration++;
+    defragmentations++;
+    movedBytes += copied;
+    return copied;
+}
+
+unsigned int buffer_allocator::generation() const {
+    return rangeGeneration;
+}
+
+buffer_allocator_stats buffer_allocator::stats() const {
+    buffer_allocator_stats result;
+    result.blocks = blocks.size();
+    for (const block& entry : blocks) {
+        result.reservedBytes += entry.size;
+        result.usedBytes += entry.used;
+        result.freeRanges += entry.freeRanges.size();
+        for (const auto& [offset, size] : entry.freeRanges) {
+            result.freeBytes += size;
+            result.largestFreeRange = std::max(result.largestFreeRange, size);
+        }
+    }
+    result.allocations = allocations.size() - freeIds.size();
+    result.defragmentations = defragmentations;
+    result.movedBytes = movedBytes;
+    return result;
+}
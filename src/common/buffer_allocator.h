@@ -0,0 +1,115 @@
+// Sub-allocation of many small GPU buffers from a few large ones.
+//
+// buffer_allocator reserves blocks of blockSize bytes as GL buffers and
+// hands out ranges of them, so thousands of small meshes or uniform blocks
+// cost a handful of buffer objects instead of one each. Every block keeps
+// its free ranges in a map ordered by offset: allocate() takes the first
+// range that fits with the requested alignment, free() puts the range back
+// and merges it with its free neighbours. Requests larger than a block get
+// a block of their own.
+//
+// The alignment never drops below what the target requires for offsets,
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform buffers and
+// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT for storage buffers.
+//
+// defragment() copies all live ranges back to back into as few fresh
+// blocks as they fit in and releases the old ones. Ranges move to a
+// different buffer and offset, so code that caches them has to look them
+// up again when generation() changes.
+
+#ifndef OPENGL_TASKS_BUFFER_ALLOCATOR_H
+#define OPENGL_TASKS_BUFFER_ALLOCATOR_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// Where an allocation lives: bind buffer and use offset
+struct buffer_range {
+    unsigned int buffer = 0;
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+// Usage of the reserved blocks
+struct buffer_allocator_stats {
+    size_t blocks = 0;
+    size_t reservedBytes = 0;
+    size_t usedBytes = 0;
+    size_t freeBytes = 0;
+    size_t largestFreeRange = 0;
+    size_t freeRanges = 0;
+    size_t allocations = 0;
+    long defragmentations = 0;
+    size_t movedBytes = 0;
+};
+
+class buffer_allocator {
+public:
+    // Blocks are created on first use with the given usage hint
+    buffer_allocator(GLenum target, size_t blockSize = 1 << 20, GLenum usage = GL_STATIC_DRAW);
+    ~buffer_allocator();
+
+    buffer_allocator(const buffer_allocator&) = delete;
+    buffer_allocator& operator=(const buffer_allocator&) = delete;
+
+    // Reserves size bytes at a multiple of alignment, returns the allocation id or -1
+    int allocate(size_t size, size_t alignment = 4);
+
+    // Returns the range to the free list of its block
+    void free(int allocation);
+
+    // Writes size bytes at offset bytes into the allocation
+    void upload(int allocation, const void* data, size_t size, size_t offset = 0);
+
+    const buffer_range& range(int allocation) const;
+
+    // Repacks the live ranges into fresh blocks if anything was freed since the last time, returns the bytes copied
+    size_t defragment();
+
+    // Changes whenever defragment() moves ranges
+    unsigned int generation() const;
+
+    buffer_allocator_stats stats() const;
+
+private:
+    struct block {
+        unsigned int buffer = 0;
+        size_t size = 0;
+        size_t used = 0;
+
+        // Offset to size of every free range
+        std::map<size_t, size_t> freeRanges;
+    };
+
+    struct allocation_record {
+        int block = -1;
+        size_t alignment = 0;
+        buffer_range range;
+    };
+
+    // Function to take a range from a block, returns false if none fits
+    bool allocateFrom(int blockIndex, size_t size, size_t alignment, size_t& offset);
+
+    // Function to reserve a new block of at least size bytes, returns its index or -1
+    int addBlock(size_t size);
+
+    GLenum target, usage;
+    size_t blockSize;
+    size_t minimumAlignment = 4;
+
+    std::vector<block> blocks;
+    std::vector<allocation_record> allocations;
+    std::vector<int> freeIds;
+
+    // Set by free(), cleared by defragment()
+    bool fragmented = false;
+
+    unsigned int rangeGeneration = 0;
+    long defragmentations = 0;
+    size_t movedBytes = 0;
+};
+
+#endif // OPENGL_TASKS_BUFFER_ALLOCATOR_H
@@ -0,0 +1,370 @@
+#include "common/compressed_texture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// DDS layout, all fields little-endian
+struct dds_pixel_format {
+    uint32_t size;
+    uint32_t flags;
+    char fourCC[4];
+    uint32_t rgbBitCount;
+    uint32_t masks[4];
+};
+
+struct dds_header {
+    char magic[4];
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    dds_pixel_format pixelFormat;
+    uint32_t caps[4];
+    uint32_t reserved2;
+};
+
+struct dds_header_dx10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+// KTX2 layout, the level index follows the header
+struct ktx2_header {
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct ktx2_level {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(dds_header) == 128, "dds_header must match the file layout");
+static_assert(sizeof(dds_header_dx10) == 20, "dds_header_dx10 must match the file layout");
+static_assert(sizeof(ktx2_header) == 80, "ktx2_header must match the file layout");
+static_assert(sizeof(ktx2_level) == 24, "ktx2_level must match the file layout");
+
+static const unsigned char ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const uint32_t ddsFourCC = 0x4;
+static const uint32_t ddsFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;  // caps, size, format, mips, linear size
+static const uint32_t ddsCaps = 0x1000 | 0x8 | 0x400000;                        // texture, complex, mipmap
+static const uint32_t ddsTexture2D = 3;
+static const int maxLevels = 32;
+
+// DXGI and Vulkan codes of each block format, linear then sRGB. BC5 has no sRGB variant.
+struct format_codes {
+    block_format format;
+    uint32_t dxgi[2];
+    uint32_t vulkan[2];
+    uint8_t colorModel;
+};
+
+static const format_codes formatCodes[] = {
+    {block_format::bc1, {71, 72}, {133, 134}, 128},
+    {block_format::bc3, {77, 78}, {137, 138}, 130},
+    {block_format::bc5, {83, 83}, {141, 141}, 132},
+    {block_format::bc7, {98, 99}, {145, 146}, 134},
+};
+
+static const format_codes& codesOf(block_format format) {
+    for (const format_codes& codes : formatCodes) {
+        if (codes.format == format) {
+            return codes;
+        }
+    }
+    return formatCodes[0];
+}
+
+// Function to find the format of a DXGI or Vulkan code, which selects codes.dxgi or codes.vulkan
+static bool formatOfCode(uint32_t code, bool vulkan, compressed_texture& texture) {
+    for (const format_codes& codes : formatCodes) {
+        const uint32_t* values = vulkan ? codes.vulkan : codes.dxgi;
+        for (int srgb = 0; srgb < 2; ++srgb) {
+            if (values[srgb] == code) {
+                texture.format = codes.format;
+                texture.srgb = srgb == 1 && codes.format != block_format::bc5;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static std::string lowercaseExtension(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return std::string();
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+bool isCompressedTexturePath(const std::string& path) {
+    std::string extension = lowercaseExtension(path);
+    return extension == "dds" || extension == "ktx2";
+}
+
+// Function to add a level of the given size, read from the file bytes at offset, returns false if it does not fit
+static bool addLevel(const std::vector<unsigned char>& file, uint64_t offset, uint64_t size, int index,
+                     compressed_texture& texture) {
+    int width = std::max(texture.width >> index, 1), height = std::max(texture.height >> index, 1);
+    if (size != compressedSize(texture.format, width, height) || offset > file.size() || size > file.size() - offset) {
+        return false;
+    }
+    texture.levels.push_back({width, height, texture.data.size(), static_cast<size_t>(size)});
+    texture.data.insert(texture.data.end(), file.begin() + static_cast<std::ptrdiff_t>(offset),
+                        file.begin() + static_cast<std::ptrdiff_t>(offset + size));
+    return true;
+}
+
+static bool readDds(const std::vector<unsigned char>& file, compressed_texture& texture) {
+    dds_header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.size != 124 || !(header.pixelFormat.flags & ddsFourCC)) {
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    if (std::memcmp(header.pixelFormat.fourCC, "DX10", 4) == 0) {
+        dds_header_dx10 dx10;
+        if (file.size() < offset + sizeof(dx10)) {
+            return false;
+        }
+        std::memcpy(&dx10, file.data() + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+        if (dx10.resourceDimension != ddsTexture2D || dx10.arraySize > 1 ||
+            !formatOfCode(dx10.dxgiFormat, false, texture)) {
+            return false;
+        }
+    } else if (std::memcmp(header.pixelFormat.fourCC, "DXT1", 4) == 0) {
+        texture.format = block_format::bc1;
+    } else if (std::memcmp(header.pixelFormat.fourCC, "DXT5", 4) == 0) {
+        texture.format = block_format::bc3;
+    } else if (std::memcmp(header.pixelFormat.fourCC, "ATI2", 4) == 0 ||
+               std::memcmp(header.pixelFormat.fourCC, "BC5U", 4) == 0) {
+        texture.format = block_format::bc5;
+    } else {
+        return false;
+    }
+
+    texture.width = static_cast<int>(header.width);
+    texture.height = static_cast<int>(header.height);
+    int levels = std::clamp(static_cast<int>(header.mipMapCount), 1, maxLevels);
+    for (int level = 0; level < levels; ++level) {
+        int width = std::max(texture.width >> level, 1), height = std::max(texture.height >> level, 1);
+        size_t size = compressedSize(texture.format, width, height);
+        if (!addLevel(file, offset, size, level, texture)) {
+            return false;
+        }
+        offset += size;
+    }
+    return true;
+}
+
+static bool readKtx2(const std::vector<unsigned char>& file, compressed_texture& texture) {
+    ktx2_header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 ||
+        header.supercompressionScheme != 0 || !formatOfCode(header.vkFormat, true, texture)) {
+        return false;
+    }
+
+    // A level count of 0 asks the loader to generate the mipmaps, only the base level is stored
+    int levels = std::max(static_cast<int>(header.levelCount), 1);
+    if (levels > maxLevels || file.size() < sizeof(header) + levels * sizeof(ktx2_level)) {
+        return false;
+    }
+
+    texture.width = static_cast<int>(header.pixelWidth);
+    texture.height = static_cast<int>(header.pixelHeight);
+    for (int level = 0; level < levels; ++level) {
+        ktx2_level entry;
+        std::memcpy(&entry, file.data() + sizeof(header) + level * sizeof(ktx2_level), sizeof(entry));
+        if (!addLevel(file, entry.byteOffset, entry.byteLength, level, texture)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readCompressedTexture(const std::string& path, compressed_texture& texture) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    texture = compressed_texture();
+    bool valid = false;
+    if (file.size() >= sizeof(dds_header) && std::memcmp(file.data(), "DDS ", 4) == 0) {
+        valid = readDds(file, texture);
+    } else if (file.size() >= sizeof(ktx2_header) && std::memcmp(file.data(), ktx2Identifier, 12) == 0) {
+        valid = readKtx2(file, texture);
+    }
+
+    if (!valid || texture.width <= 0 || texture.height <= 0) {
+        std::cerr << "Invalid or unsupported compressed texture " << path << " (BC1, BC3, BC5 and BC7 in DDS or KTX2)"
+                  << std::endl;
+        texture = compressed_texture();
+        return false;
+    }
+    return true;
+}
+
+static bool writeDds(std::ofstream& file, const compressed_texture& texture) {
+    dds_header header = {};
+    std::memcpy(header.magic, "DDS ", 4);
+    header.size = 124;
+    header.flags = ddsFlags;
+    header.height = static_cast<uint32_t>(texture.height);
+    header.width = static_cast<uint32_t>(texture.width);
+    header.pitchOrLinearSize = static_cast<uint32_t>(texture.levels[0].size);
+    header.mipMapCount = static_cast<uint32_t>(texture.levels.size());
+    header.pixelFormat.size = 32;
+    header.pixelFormat.flags = ddsFourCC;
+    std::memcpy(header.pixelFormat.fourCC, "DX10", 4);
+    header.caps[0] = ddsCaps;
+
+    dds_header_dx10 dx10 = {};
+    dx10.dxgiFormat = codesOf(texture.format).dxgi[texture.srgb ? 1 : 0];
+    dx10.resourceDimension = ddsTexture2D;
+    dx10.arraySize = 1;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    for (const mip_level& level : texture.levels) {
+        file.write(reinterpret_cast<const char*>(texture.data.data() + level.offset), level.size);
+    }
+    return static_cast<bool>(file);
+}
+
+// Function to build the basic data format descriptor of a block format, as KTX2 requires
+static std::vector<uint32_t> ktx2Descriptor(const compressed_texture& texture) {
+    // One sample per 64 bits of block: the channel id, where it starts and how long it is minus one
+    struct sample {
+        uint32_t channel;
+        uint32_t bitOffset;
+        uint32_t bitLength;
+    };
+    std::vector<sample> samples;
+    switch (texture.format) {
+    case block_format::bc1:
+        samples = {{1, 0, 63}};  // color with punch-through alpha
+        break;
+    case block_format::bc3:
+        samples = {{15, 0, 63}, {0, 64, 63}};  // alpha, then color
+        break;
+    case block_format::bc5:
+        samples = {{0, 0, 63}, {1, 64, 63}};  // red, then green
+        break;
+    case block_format::bc7:
+        samples = {{0, 0, 127}};
+        break;
+    }
+
+    uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    std::vector<uint32_t> words;
+    words.push_back(4 + blockSize);
+    words.push_back(0);                  // Khronos vendor, basic descriptor type
+    words.push_back(2 | blockSize << 16); // version 2
+    uint32_t transfer = texture.srgb ? 2 : 1;
+    words.push_back(codesOf(texture.format).colorModel | 1 << 8 | transfer << 16);  // BT.709 primaries, straight alpha
+    words.push_back(3 | 3 << 8);          // 4x4 texel blocks
+    words.push_back(static_cast<uint32_t>(blockBytes(texture.format)));
+    words.push_back(0);
+    for (const sample& s : samples) {
+        words.push_back(s.bitOffset | s.bitLength << 16 | s.channel << 24);
+        words.push_back(0);
+        words.push_back(0);
+        words.push_back(0xFFFFFFFFu);
+    }
+    return words;
+}
+
+static bool writeKtx2(std::ofstream& file, const compressed_texture& texture) {
+    std::vector<uint32_t> descriptor = ktx2Descriptor(texture);
+    size_t levelCount = texture.levels.size();
+
+    ktx2_header header = {};
+    std::memcpy(header.identifier, ktx2Identifier, sizeof(ktx2Identifier));
+    header.vkFormat = codesOf(texture.format).vulkan[texture.srgb ? 1 : 0];
+    header.typeSize = 1;
+    header.pixelWidth = static_cast<uint32_t>(texture.width);
+    header.pixelHeight = static_cast<uint32_t>(texture.height);
+    header.faceCount = 1;
+    header.levelCount = static_cast<uint32_t>(levelCount);
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levelCount * sizeof(ktx2_level));
+    header.dfdByteLength = static_cast<uint32_t>(descriptor.size() * sizeof(uint32_t));
+
+    // Levels go from the smallest to the largest, each aligned to its block size
+    size_t alignment = static_cast<size_t>(blockBytes(texture.format));
+    size_t offset = header.dfdByteOffset + header.dfdByteLength;
+    std::vector<ktx2_level> index(levelCount);
+    for (size_t level = levelCount; level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        index[level] = {offset, texture.levels[level].size, texture.levels[level].size};
+        offset += texture.levels[level].size;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ktx2_level));
+    file.write(reinterpret_cast<const char*>(descriptor.data()), descriptor.size() * sizeof(uint32_t));
+    size_t written = header.dfdByteOffset + header.dfdByteLength;
+    for (size_t level = levelCount; level-- > 0;) {
+        static const char padding[16] = {};
+        file.write(padding, static_cast<std::streamsize>(index[level].byteOffset - written));
+        file.write(reinterpret_cast<const char*>(texture.data.data() + texture.levels[level].offset),
+                   texture.levels[level].size);
+        written = index[level].byteOffset + index[level].byteLength;
+    }
+    return static_cast<bool>(file);
+}
+
+bool writeCompressedTexture(const std::string& path, const compressed_texture& texture) {
+    if (texture.levels.empty()) {
+        std::cerr << "No levels to write to " << path << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    bool written = lowercaseExtension(path) == "ktx2" ? writeKtx2(file, texture) : writeDds(file, texture);
+    if (!written) {
+        std::cerr << "Failed to write " << path << std::endl;
+    }
+    return written;
+}
@@ -0,0 +1,37 @@
+// Block compressed textures in DDS and KTX2 files.
+//
+// readCompressedTexture() accepts both containers holding BC1, BC3, BC5 or
+// BC7 levels (block_compression.h): DDS with the legacy DXT1, DXT5 and
+// ATI2 codes or a DX10 header, and KTX2 without supercompression. The
+// levels are kept as stored, ready for glCompressedTexSubImage2D.
+// writeCompressedTexture() writes KTX2 for a .ktx2 path and DDS with a
+// DX10 header otherwise.
+
+#ifndef OPENGL_TASKS_COMPRESSED_TEXTURE_H
+#define OPENGL_TASKS_COMPRESSED_TEXTURE_H
+
+#include "common/block_compression.h"
+#include "common/mip_chain.h"
+
+#include <string>
+#include <vector>
+
+struct compressed_texture {
+    block_format format = block_format::bc1;
+    bool srgb = false;
+    int width = 0;
+    int height = 0;
+    std::vector<mip_level> levels;
+    std::vector<unsigned char> data;
+};
+
+// True for paths ending in .dds or .ktx2, in any case
+bool isCompressedTexturePath(const std::string& path);
+
+// Function to read a DDS or KTX2 file, returns false if it is missing, invalid or not in a supported format
+bool readCompressedTexture(const std::string& path, compressed_texture& texture);
+
+// Function to write a texture as KTX2 or DDS depending on the extension, returns false on failure
+bool writeCompressedTexture(const std::string& path, const compressed_texture& texture);
+
+#endif // OPENGL_TASKS_COMPRESSED_TEXTURE_H
@@ -0,0 +1,9 @@
+// Copies of the .glsl files of the tasks, embedded when the build is configured.
+
+#ifndef OPENGL_TASKS_EMBEDDED_SHADERS_H
+#define OPENGL_TASKS_EMBEDDED_SHADERS_H
+
+// Returns the source of a shader named relative to the shader directory, nullptr if it was not embedded
+const char* findEmbeddedShader(const char* name);
+
+#endif // OPENGL_TASKS_EMBEDDED_SHADERS_H
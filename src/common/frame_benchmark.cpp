@@ -0,0 +1,262 @@
+#include "common/frame_benchmark.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+// Summary of one series of per-frame timings, in milliseconds
+struct timing_stats {
+    double min = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+};
+
+// Statistics of one finished run
+struct benchmark_run {
+    std::string task;
+    std::string renderer;
+    long warmupFrames = 0;
+    long measuredFrames = 0;
+    timing_stats frameMs;
+    timing_stats cpuMs;
+    timing_stats gpuMs;
+};
+
+// State of the run in progress
+struct benchmark_state {
+    bool active = false;
+    bool started = false;
+    long frame = 0;
+    benchmark_clock::time_point frameStart;
+    std::vector<double> frameMs;
+    std::vector<double> cpuMs;
+    std::vector<unsigned int> queries;
+};
+
+static benchmark_state state;
+static std::vector<benchmark_run> runs;
+
+benchmark_options& benchmarkOptions() {
+    static benchmark_options options;
+    return options;
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+static timing_stats computeStats(std::vector<double> values) {
+    timing_stats stats;
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+    stats.min = values.front();
+    stats.median = percentile(values, 0.50);
+    stats.p95 = percentile(values, 0.95);
+    stats.p99 = percentile(values, 0.99);
+    stats.max = values.back();
+
+    double sum = 0.0;
+    for (double value : values) {
+        sum += value;
+    }
+    stats.mean = sum / values.size();
+
+    return stats;
+}
+
+// True while the current frame belongs to the measured part of the run
+static bool measuring() {
+    return state.frame >= benchmarkOptions().warmupFrames;
+}
+
+void benchmarkBegin() {
+    if (!benchmarkOptions().enabled) {
+        return;
+    }
+
+    const benchmark_options& options = benchmarkOptions();
+
+    state = benchmark_state();
+    state.active = true;
+    state.frameMs.reserve(options.measuredFrames);
+    state.cpuMs.reserve(options.measuredFrames);
+
+    // One query per measured frame, they are only read back when the run is over
+    state.queries.resize(options.measuredFrames);
+    if (!state.queries.empty()) {
+        glGenQueries(static_cast<GLsizei>(state.queries.size()), state.queries.data());
+    }
+
+}
+
+void benchmarkBeforeSwap() {
+    if (!state.started || !measuring()) {
+        return;
+    }
+
+    size_t index = state.frame - benchmarkOptions().warmupFrames;
+    if (index < state.queries.size()) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    auto now = benchmark_clock::now();
+    state.cpuMs.push_back(std::chrono::duration<double, std::milli>(now - state.frameStart).count());
+}
+
+void benchmarkAfterSwap() {
+    if (!state.active) {
+        return;
+    }
+
+    // The first frame also runs the setup of the task, timing starts at its end
+    auto now = benchmark_clock::now();
+    if (!state.started) {
+        state.started = true;
+        state.frameStart = now;
+        if (measuring() && !state.queries.empty()) {
+            glBeginQuery(GL_TIME_ELAPSED, state.queries[0]);
+        }
+        return;
+    }
+
+    if (measuring()) {
+        state.frameMs.push_back(std::chrono::duration<double, std::milli>(now - state.frameStart).count());
+    }
+
+    state.frame++;
+    state.frameStart = now;
+
+    // Start timing the GPU work of the next frame if it is measured
+    if (measuring()) {
+        size_t index = state.frame - benchmarkOptions().warmupFrames;
+        if (index < state.queries.size()) {
+            glBeginQuery(GL_TIME_ELAPSED, state.queries[index]);
+        }
+    }
+}
+
+long benchmarkFrameLimit() {
+    if (!benchmarkOptions().enabled) {
+        return 0;
+    }
+    // One more for the setup frame
+    return 1 + benchmarkOptions().warmupFrames + benchmarkOptions().measuredFrames;
+}
+
+void benchmarkEnd() {
+    if (!state.active) {
+        return;
+    }
+
+    const benchmark_options& options = benchmarkOptions();
+
+    // A query is still running if the task stopped in the middle of the measured frames
+    size_t measured = state.frameMs.size();
+    if (state.started && measuring() && measured < state.queries.size()) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    // Blocking is fine now, the frames are over
+    std::vector<double> gpuMs;
+    gpuMs.reserve(measured);
+    for (size_t i = 0; i < measured && i < state.queries.size(); ++i) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(state.queries[i], GL_QUERY_RESULT, &elapsed);
+        gpuMs.push_back(elapsed * 1e-6);
+    }
+
+    if (!state.queries.empty()) {
+        glDeleteQueries(static_cast<GLsizei>(state.queries.size()), state.queries.data());
+    }
+
+    benchmark_run run;
+    run.task = options.taskName;
+    run.renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    run.warmupFrames = options.warmupFrames;
+    run.measuredFrames = static_cast<long>(measured);
+    run.frameMs = computeStats(state.frameMs);
+    run.cpuMs = computeStats(state.cpuMs);
+    run.gpuMs = computeStats(gpuMs);
+    runs.push_back(run);
+
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3)
+              << "Benchmark " << run.task << ": " << measured << " frames, median frame "
+              << run.frameMs.median << " ms, p99 " << run.frameMs.p99 << " ms, median GPU "
+              << run.gpuMs.median << " ms" << std::defaultfloat << std::setprecision(precision) << std::endl;
+
+    state = benchmark_state();
+}
+
+// Function to escape a string for JSON output
+static std::string jsonString(const std::string& value) {
+    std::string escaped = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+static void writeStats(std::ostream& out, const char* name, const timing_stats& stats, bool last) {
+    out << "      " << jsonString(name) << ": {"
+        << "\"min\": " << stats.min
+        << ", \"median\": " << stats.median
+        << ", \"p95\": " << stats.p95
+        << ", \"p99\": " << stats.p99
+        << ", \"max\": " << stats.max
+        << ", \"mean\": " << stats.mean
+        << "}" << (last ? "\n" : ",\n");
+}
+
+bool writeBenchmarkResults(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"runs\": [\n";
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const benchmark_run& run = runs[i];
+        out << "    {\n"
+            << "      \"task\": " << jsonString(run.task) << ",\n"
+            << "      \"renderer\": " << jsonString(run.renderer) << ",\n"
+            << "      \"warmup_frames\": " << run.warmupFrames << ",\n"
+            << "      \"frames\": " << run.measuredFrames << ",\n";
+        writeStats(out, "frame_ms", run.frameMs, false);
+        writeStats(out, "cpu_ms", run.cpuMs, false);
+        writeStats(out, "gpu_ms", run.gpuMs, true);
+        out << "    }" << (i + 1 < runs.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+
+    std::cout << "Benchmark results written to " << path << std::endl;
+    return static_cast<bool>(out);
+}
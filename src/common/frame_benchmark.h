@@ -0,0 +1,53 @@
+// Frame benchmark harness.
+//
+// With benchmarking enabled, the window backend runs a task for a fixed number
+// of warmup frames followed by a fixed number of measured frames with VSync
+// off. The first frame, which also runs the setup of the task, is never
+// counted. For every measured frame it records the frame time, the CPU time spent
+// before presenting and the GPU time (GL_TIME_ELAPSED queries, read back once
+// the run is over so they never stall the pipeline). The statistics of all
+// runs are written to a JSON file that bench_compare can diff.
+
+#ifndef OPENGL_TASKS_FRAME_BENCHMARK_H
+#define OPENGL_TASKS_FRAME_BENCHMARK_H
+
+#include <string>
+
+struct benchmark_options {
+    bool enabled = false;
+
+    // Frames rendered before measuring starts
+    long warmupFrames = 60;
+
+    // Frames measured after the warmup
+    long measuredFrames = 600;
+
+    // JSON file receiving the results of all runs
+    std::string outputPath = "benchmark.json";
+
+    // Name of the task being run, set by main.cpp
+    std::string taskName;
+};
+
+// Global options for the benchmark harness
+benchmark_options& benchmarkOptions();
+
+// Starts a run for the task in benchmarkOptions(), called once the context is current
+void benchmarkBegin();
+
+// Marks the end of the CPU work of a frame, called right before presenting
+void benchmarkBeforeSwap();
+
+// Marks the end of a frame, called right after presenting
+void benchmarkAfterSwap();
+
+// Number of frames after which the run is over, setup frame included, 0 when benchmarking is disabled
+long benchmarkFrameLimit();
+
+// Collects the GPU timings and computes the statistics of the current run
+void benchmarkEnd();
+
+// Writes the statistics of all finished runs as JSON, returns false on failure
+bool writeBenchmarkResults(const std::string& path);
+
+#endif // OPENGL_TASKS_FRAME_BENCHMARK_H
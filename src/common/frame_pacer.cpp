@@ -0,0 +1,137 @@
+#include "common/frame_pacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")
+#endif
+#endif
+
+// Tells the CPU we are in a spin-wait loop, saving power and yielding to the sibling hyper-thread
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#elif defined(_M_ARM64)
+    __yield();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+static double toMilliseconds(frame_pacer::clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+frame_pacer::frame_pacer(double targetFps, double spinMarginMs) {
+    setTargetRate(targetFps);
+    spinMargin = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(spinMarginMs));
+
+#ifdef _WIN32
+    // The default timer resolution on Windows is 15.6 ms, far coarser than a frame
+    timeBeginPeriod(1);
+#endif
+}
+
+frame_pacer::~frame_pacer() {
+#ifdef _WIN32
+    timeEndPeriod(1);
+#endif
+}
+
+void frame_pacer::setTargetRate(double targetFps) {
+    period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    started = false;
+}
+
+double frame_pacer::targetRate() const {
+    return 1.0 / std::chrono::duration<double>(period).count();
+}
+
+void frame_pacer::waitForNextFrame() {
+    clock::time_point now = clock::now();
+
+    if (!started) {
+        // The first frame only establishes the schedule
+        started = true;
+        deadline = now + period;
+        lastWake = now;
+        return;
+    }
+
+    // Sleep coarsely, then spin for the last stretch
+    if (deadline - now > spinMargin) {
+        std::this_thread::sleep_until(deadline - spinMargin);
+    }
+    while ((now = clock::now()) < deadline) {
+        cpuRelax();
+    }
+
+    // Statistics
+    double errorMs = toMilliseconds(now - deadline);
+    double intervalMs = toMilliseconds(now - lastWake);
+
+    frames++;
+    errorSum += errorMs;
+    maxLate = std::max(maxLate, errorMs);
+
+    intervals++;
+    intervalSum += intervalMs;
+    intervalSquareSum += intervalMs * intervalMs;
+
+    lastWake = now;
+
+    if (errorMs > toMilliseconds(period) / 2.0) {
+        missed++;
+    }
+
+    // Advance on the absolute schedule; when a frame ran so long that the next deadline
+    // has passed too, restart from now instead of rushing several frames to catch up
+    deadline += period;
+    if (now >= deadline) {
+        deadline = now + period;
+    }
+}
+
+pacing_stats frame_pacer::stats() const {
+    pacing_stats result;
+    result.frames = frames;
+    result.missedDeadlines = missed;
+    result.maxLateMs = maxLate;
+
+    if (frames > 0) {
+        result.meanErrorMs = errorSum / frames;
+    }
+
+    if (intervals > 0) {
+        double mean = intervalSum / intervals;
+        double variance = std::max(0.0, intervalSquareSum / intervals - mean * mean);
+        result.meanIntervalMs = mean;
+        result.intervalStdDevMs = std::sqrt(variance);
+    }
+
+    return result;
+}
+
+void frame_pacer::resetStats() {
+    frames = 0;
+    intervals = 0;
+    missed = 0;
+    errorSum = 0.0;
+    maxLate = 0.0;
+    intervalSum = 0.0;
+    intervalSquareSum = 0.0;
+}
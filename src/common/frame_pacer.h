@@ -0,0 +1,70 @@
+// Frame pacer for fixed frame rates.
+//
+// Frames are scheduled on absolute deadlines (start + n * period), so the
+// time spent rendering and sleeping never accumulates as drift. Waiting is
+// hybrid: the thread sleeps until a safety margin before the deadline, then
+// spin-waits with a pause instruction for the rest, because sleeping alone
+// routinely overshoots by a millisecond or more.
+
+#ifndef OPENGL_TASKS_FRAME_PACER_H
+#define OPENGL_TASKS_FRAME_PACER_H
+
+#include <chrono>
+
+// Pacing accuracy since the last reset, in milliseconds
+struct pacing_stats {
+    long frames = 0;
+
+    // Wake-up time relative to the deadline (positive = late)
+    double meanErrorMs = 0.0;
+    double maxLateMs = 0.0;
+
+    // Standard deviation of the frame interval, the jitter seen by the viewer
+    double intervalStdDevMs = 0.0;
+    double meanIntervalMs = 0.0;
+
+    // Frames that woke more than half a period after their deadline
+    long missedDeadlines = 0;
+};
+
+class frame_pacer {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // spinMarginMs is how long before a deadline sleeping stops and spinning starts
+    explicit frame_pacer(double targetFps, double spinMarginMs = 2.0);
+    ~frame_pacer();
+
+    frame_pacer(const frame_pacer&) = delete;
+    frame_pacer& operator=(const frame_pacer&) = delete;
+
+    // Changes the target rate, the schedule restarts at the next frame
+    void setTargetRate(double targetFps);
+
+    double targetRate() const;
+
+    // Blocks until the deadline of the next frame
+    void waitForNextFrame();
+
+    pacing_stats stats() const;
+
+    void resetStats();
+
+private:
+    clock::duration period;
+    clock::duration spinMargin;
+    clock::time_point deadline;
+    clock::time_point lastWake;
+    bool started = false;
+
+    // Running sums for the statistics
+    long frames = 0;
+    long intervals = 0;
+    long missed = 0;
+    double errorSum = 0.0;
+    double maxLate = 0.0;
+    double intervalSum = 0.0;
+    double intervalSquareSum = 0.0;
+};
+
+#endif // OPENGL_TASKS_FRAME_PACER_H
@@ -0,0 +1,262 @@
+#include "common/gpu_profiler.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock profiler_clock;
+
+// One execution of a zone within a frame
+struct zone_record {
+    int zone;
+    bool gpu;
+    unsigned int beginQuery;
+    unsigned int endQuery;
+    profiler_clock::time_point cpuStart;
+};
+
+// Queries and zone records of one frame in flight
+struct frame_slot {
+    std::vector<zone_record> records;
+    std::vector<unsigned int> queryPool;
+    size_t queriesUsed = 0;
+};
+
+// Accumulated timings of a zone since the last report
+struct zone_totals {
+    std::string name;
+    double cpuMs = 0.0;
+    double gpuMs = 0.0;
+    long calls = 0;
+};
+
+struct profiler_state {
+    bool active = false;
+    int currentSlot = 0;
+    frame_slot slots[profilerSlots];
+
+    // Record of the frame zone in the current slot
+    int frameRecord = -1;
+
+    // Report bookkeeping
+    long framesRecorded = 0;
+    long framesResolved = 0;
+    long framesDropped = 0;
+    profiler_clock::time_point lastReport;
+};
+
+static profiler_state state;
+static std::vector<zone_totals> zones;
+
+// Id of the zone spanning a whole frame
+static const int frameZone = profilerRegisterZone("frame");
+
+profiler_options& profilerOptions() {
+    static profiler_options options;
+    return options;
+}
+
+int profilerRegisterZone(const char* name) {
+    for (size_t i = 0; i < zones.size(); ++i) {
+        if (zones[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    zones.push_back(zone_totals{name});
+    return static_cast<int>(zones.size() - 1);
+}
+
+// Function to take a query object from the pool of the current slot
+static unsigned int acquireQuery(frame_slot& slot) {
+    if (slot.queriesUsed == slot.queryPool.size()) {
+        // Grow in batches to keep glGenQueries out of the steady state
+        size_t grow = slot.queryPool.empty() ? 32 : slot.queryPool.size();
+        slot.queryPool.resize(slot.queryPool.size() + grow);
+        glGenQueries(static_cast<GLsizei>(grow), slot.queryPool.data() + slot.queriesUsed);
+    }
+    return slot.queryPool[slot.queriesUsed++];
+}
+
+// Function to open a zone record in the current slot, returns its index
+static int openRecord(int zone, bool gpu) {
+    frame_slot& slot = state.slots[state.currentSlot];
+
+    zone_record record{zone, gpu, 0, 0, profiler_clock::now()};
+    if (gpu) {
+        record.beginQuery = acquireQuery(slot);
+        record.endQuery = acquireQuery(slot);
+        glQueryCounter(record.beginQuery, GL_TIMESTAMP);
+    }
+
+    slot.records.push_back(record);
+    return static_cast<int>(slot.records.size() - 1);
+}
+
+// Function to close a zone record, CPU time is known immediately
+static void closeRecord(int index) {
+    zone_record& record = state.slots[state.currentSlot].records[index];
+    if (record.gpu) {
+        glQueryCounter(record.endQuery, GL_TIMESTAMP);
+    }
+
+    zone_totals& totals = zones[record.zone];
+    totals.cpuMs += std::chrono::duration<double, std::milli>(profiler_clock::now() - record.cpuStart).count();
+    totals.calls++;
+}
+
+// Function to read the GPU timings of a slot recorded profilerLatency frames ago
+static void resolveSlot(frame_slot& slot) {
+    if (slot.records.empty()) {
+        return;
+    }
+
+    // Timestamps complete in order, so the last query tells whether the whole slot is ready
+    const zone_record* last = nullptr;
+    for (const zone_record& record : slot.records) {
+        if (record.gpu) {
+            last = &record;
+        }
+    }
+
+    GLint available = GL_TRUE;
+    if (last) {
+        glGetQueryObjectiv(last->endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+
+    if (available) {
+        for (const zone_record& record : slot.records) {
+            if (!record.gpu) {
+                continue;
+            }
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(record.beginQuery, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(record.endQuery, GL_QUERY_RESULT, &end);
+            zones[record.zone].gpuMs += (end - begin) * 1e-6;
+        }
+        state.framesResolved++;
+    } else {
+        // Never wait for the GPU, drop the sample instead
+        state.framesDropped++;
+    }
+
+    slot.records.clear();
+    slot.queriesUsed = 0;
+}
+
+// Function to print the average timings per frame and reset the totals
+static void printReport() {
+    if (state.framesRecorded == 0) {
+        return;
+    }
+
+    double cpuFrames = static_cast<double>(state.framesRecorded);
+    double gpuFrames = static_cast<double>(state.framesResolved > 0 ? state.framesResolved : 1);
+
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3)
+              << "Profile: " << state.framesRecorded << " frames, GPU results " << profilerLatency
+              << " frames late (" << state.framesDropped << " dropped)" << std::endl;
+
+    for (const zone_totals& totals : zones) {
+        if (totals.calls == 0) {
+            continue;
+        }
+        std::cout << "  " << std::left << std::setw(24) << totals.name << std::right
+                  << " CPU " << std::setw(8) << totals.cpuMs / cpuFrames << " ms"
+                  << "  GPU " << std::setw(8) << totals.gpuMs / gpuFrames << " ms"
+                  << "  calls/frame " << std::setprecision(1) << totals.calls / cpuFrames << std::setprecision(3);
+
+        // Whichever side takes longer per frame limits the frame rate
+        if (&totals == &zones[frameZone]) {
+            std::cout << (totals.gpuMs / gpuFrames > totals.cpuMs / cpuFrames ? "  -> GPU-bound" : "  -> CPU-bound");
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(precision);
+
+    for (zone_totals& totals : zones) {
+        totals.cpuMs = 0.0;
+        totals.gpuMs = 0.0;
+        totals.calls = 0;
+    }
+    state.framesRecorded = 0;
+    state.framesResolved = 0;
+    state.framesDropped = 0;
+}
+
+void profilerBegin() {
+    if (!profilerOptions().enabled) {
+        return;
+    }
+
+    state.active = true;
+    state.currentSlot = 0;
+    state.lastReport = profiler_clock::now();
+    state.frameRecord = openRecord(frameZone, true);
+}
+
+void profilerBeforeSwap() {
+    if (!state.active) {
+        return;
+    }
+
+    closeRecord(state.frameRecord);
+    state.frameRecord = -1;
+    state.framesRecorded++;
+}
+
+void profilerAfterSwap() {
+    if (!state.active) {
+        return;
+    }
+
+    // The next slot was recorded profilerLatency frames before the one that just ended, its results should be ready
+    state.currentSlot = (state.currentSlot + 1) % profilerSlots;
+    resolveSlot(state.slots[state.currentSlot]);
+
+    auto now = profiler_clock::now();
+    if (std::chrono::duration<double>(now - state.lastReport).count() >= profilerOptions().reportInterval) {
+        printReport();
+        state.lastReport = now;
+    }
+
+    state.frameRecord = openRecord(frameZone, true);
+}
+
+void profilerEnd() {
+    if (!state.active) {
+        return;
+    }
+
+    if (state.frameRecord >= 0) {
+        closeRecord(state.frameRecord);
+    }
+
+    // The context is about to go away, so waiting for the remaining results is fine
+    glFinish();
+    for (int i = 1; i <= profilerSlots; ++i) {
+        resolveSlot(state.slots[(state.currentSlot + i) % profilerSlots]);
+    }
+    printReport();
+
+    for (frame_slot& slot : state.slots) {
+        if (!slot.queryPool.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(slot.queryPool.size()), slot.queryPool.data());
+        }
+    }
+    state = profiler_state();
+}
+
+profile_zone::profile_zone(int zone, bool gpu) {
+    record = state.active ? openRecord(zone, gpu) : -1;
+}
+
+profile_zone::~profile_zone() {
+    if (record >= 0 && state.active) {
+        closeRecord(record);
+    }
+}
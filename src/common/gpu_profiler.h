@@ -0,0 +1,72 @@
+// CPU and GPU zone profiler.
+//
+// PROFILE_ZONE("name") measures the enclosing scope on the CPU with a clock
+// and on the GPU with a pair of GL_TIMESTAMP queries. Queries are recorded
+// into a ring of frame slots and only read back when their slot comes round
+// again, profilerLatency frames later, so reading them never stalls the
+// pipeline. The window backend times every frame as the "frame" zone and
+// prints the per-zone averages once per report interval, together with
+// whether the frame is CPU-bound or GPU-bound.
+
+#ifndef OPENGL_TASKS_GPU_PROFILER_H
+#define OPENGL_TASKS_GPU_PROFILER_H
+
+// Number of frames between recording a query and reading its result
+const int profilerLatency = 4;
+
+// Slots in the ring: the frame being recorded plus the profilerLatency frames still in flight
+const int profilerSlots = profilerLatency + 1;
+
+struct profiler_options {
+    bool enabled = false;
+
+    // Seconds between two printed reports
+    double reportInterval = 1.0;
+};
+
+// Global options for the profiler
+profiler_options& profilerOptions();
+
+// Returns the id of a zone name, registering it on first use
+int profilerRegisterZone(const char* name);
+
+// Starts the profiler for a new context, called once the context is current
+void profilerBegin();
+
+// Closes the frame zone, called right before presenting
+void profilerBeforeSwap();
+
+// Reads back the oldest frame slot and opens the next frame zone, called right after presenting
+void profilerAfterSwap();
+
+// Prints the last report and releases the queries, called before the context is destroyed
+void profilerEnd();
+
+// Scope timed on the CPU, and on the GPU unless it was created as CPU-only
+class profile_zone {
+public:
+    profile_zone(int zone, bool gpu);
+    ~profile_zone();
+
+    profile_zone(const profile_zone&) = delete;
+    profile_zone& operator=(const profile_zone&) = delete;
+
+private:
+    // Index of the zone record in the current frame slot, -1 if the profiler is off
+    int record;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Times the rest of the enclosing scope on the CPU and the GPU
+#define PROFILE_ZONE(name) \
+    static const int PROFILE_CONCAT(profileZoneId_, __LINE__) = profilerRegisterZone(name); \
+    profile_zone PROFILE_CONCAT(profileZone_, __LINE__)(PROFILE_CONCAT(profileZoneId_, __LINE__), true)
+
+// Times the rest of the enclosing scope on the CPU only
+#define PROFILE_CPU_ZONE(name) \
+    static const int PROFILE_CONCAT(profileZoneId_, __LINE__) = profilerRegisterZone(name); \
+    profile_zone PROFILE_CONCAT(profileZone_, __LINE__)(PROFILE_CONCAT(profileZoneId_, __LINE__), false)
+
+#endif // OPENGL_TASKS_GPU_PROFILER_H
@@ -0,0 +1,132 @@
+#include "common/instanced_mesh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// The mat4 attribute takes the four locations from 2 to 5
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in mat4 aTransform;
+    out vec4 FragColor;
+    void main() {
+        gl_Position = aTransform * vec4(aPos, 1.0);
+        FragColor = aColor;
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec4 FragColor;
+    out vec4 FinalColor;
+    void main() {
+        FinalColor = FragColor;
+    }
+)";
+
+static const GLuint colorLocation = 1;
+static const GLuint transformLocation = 2;
+
+instanced_mesh::instanced_mesh(const float* positions, int vertexCount, int components,
+                               const unsigned int* indices, int indexCount, size_t maxInstancesPerDraw)
+    : vertexCount(vertexCount), indexCount(indices ? indexCount : 0), maxInstancesPerDraw(maxInstancesPerDraw) {
+    // Only submitted here, the first draw waits for the link
+    shaderProgram = queued_program(vertexShaderSource, fragmentShaderSource);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+
+    // Per-vertex positions, a missing z reads as 0
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * components * sizeof(float), positions, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, components, GL_FLOAT, GL_FALSE, components * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+
+    if (this->indexCount > 0) {
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    }
+
+    // Per-instance attributes advance once per instance instead of once per vertex
+    glEnableVertexAttribArray(colorLocation);
+    glVertexAttribDivisor(colorLocation, 1);
+    for (GLuint column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(transformLocation + column);
+        glVertexAttribDivisor(transformLocation + column, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Room for one full draw per frame in flight
+    instanceStream = std::make_unique<stream_buffer>(GL_ARRAY_BUFFER, maxInstancesPerDraw * sizeof(instance_data));
+}
+
+instanced_mesh::~instanced_mesh() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    if (EBO) {
+        glDeleteBuffers(1, &EBO);
+    }
+    glDeleteProgram(shaderProgram.get());
+}
+
+bool instanced_mesh::valid() const {
+    return shaderProgram.submitted() && VAO != 0;
+}
+
+void instanced_mesh::bindInstances(size_t offset) {
+    // Instanced draws without a base instance always start at instance 0, so the attributes move instead
+    glBindBuffer(GL_ARRAY_BUFFER, instanceStream->buffer());
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(instance_data),
+                          (void*)(offset + offsetof(instance_data, color)));
+    for (GLuint column = 0; column < 4; ++column) {
+        glVertexAttribPointer(transformLocation + column, 4, GL_FLOAT, GL_FALSE, sizeof(instance_data),
+                              (void*)(offset + offsetof(instance_data, transform) + column * sizeof(glm::vec4)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void instanced_mesh::draw(const instance_data* instances, size_t count, GLenum mode) {
+    glUseProgram(shaderProgram.get());
+    glBindVertexArray(VAO);
+
+    while (count > 0) {
+        size_t batch = std::min(count, maxInstancesPerDraw);
+        stream_allocation allocation = instanceStream->allocate(batch * sizeof(instance_data), sizeof(instance_data));
+
+        // The region of this frame is full, move on to the next one
+        if (!allocation.data) {
+            instanceStream->endFrame();
+            allocation = instanceStream->allocate(batch * sizeof(instance_data), sizeof(instance_data));
+        }
+
+        std::memcpy(allocation.data, instances, batch * sizeof(instance_data));
+        instanceStream->commit();
+        bindInstances(allocation.offset);
+
+        if (indexCount > 0) {
+            glDrawElementsInstanced(mode, indexCount, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(batch));
+        } else {
+            glDrawArraysInstanced(mode, 0, vertexCount, static_cast<GLsizei>(batch));
+        }
+        draws++;
+
+        instances += batch;
+        count -= batch;
+    }
+
+    glBindVertexArray(0);
+}
+
+void instanced_mesh::endFrame() {
+    instanceStream->endFrame();
+}
+
+long instanced_mesh::drawCalls() const {
+    return draws;
+}
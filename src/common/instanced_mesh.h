@@ -0,0 +1,64 @@
+// Instanced drawing of one mesh with many transforms.
+//
+// instanced_mesh keeps the vertex positions of a mesh in a static buffer
+// and streams the per-instance transform and color of every frame through
+// a stream_buffer. The instance data is read as vertex attributes with a
+// divisor of 1, so a whole span of instances takes one
+// glDrawArraysInstanced or glDrawElementsInstanced call.
+
+#ifndef OPENGL_TASKS_INSTANCED_MESH_H
+#define OPENGL_TASKS_INSTANCED_MESH_H
+
+#include "common/shader.h"
+#include "common/stream_buffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+
+// Per-instance attributes, matching the layout of the instanced vertex shader
+struct instance_data {
+    glm::mat4 transform;
+    glm::vec4 color;
+};
+
+class instanced_mesh {
+public:
+    // positions holds vertexCount vertices of components floats (2 or 3), indices are optional
+    instanced_mesh(const float* positions, int vertexCount, int components = 2,
+                   const unsigned int* indices = nullptr, int indexCount = 0,
+                   size_t maxInstancesPerDraw = 1 << 17);
+    ~instanced_mesh();
+
+    instanced_mesh(const instanced_mesh&) = delete;
+    instanced_mesh& operator=(const instanced_mesh&) = delete;
+
+    // True if the program and the buffers were created
+    bool valid() const;
+
+    // Draws one instance per element, in as few draw calls as the stream buffer allows
+    void draw(const instance_data* instances, size_t count, GLenum mode = GL_TRIANGLES);
+
+    // Closes the frame of the instance stream, call it once per frame after the last draw
+    void endFrame();
+
+    // Number of draw calls issued since the mesh was created
+    long drawCalls() const;
+
+private:
+    // Function to point the instance attributes at the given offset of the stream buffer
+    void bindInstances(size_t offset);
+
+    // Submitted by the constructor, linked by the first draw
+    queued_program shaderProgram;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    int vertexCount;
+    int indexCount;
+    size_t maxInstancesPerDraw;
+    std::unique_ptr<stream_buffer> instanceStream;
+    long draws = 0;
+};
+
+#endif // OPENGL_TASKS_INSTANCED_MESH_H
@@ -0,0 +1,246 @@
+#include "common/mesh_registry.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// The per-draw mat4 takes the four locations from 2 to 5
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec4 aColor;
+    layout (location = 2) in mat4 aTransform;
+    out vec4 FragColor;
+    void main() {
+        gl_Position = aTransform * vec4(aPos, 1.0);
+        FragColor = aColor;
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec4 FragColor;
+    out vec4 FinalColor;
+    void main() {
+        FinalColor = FragColor;
+    }
+)";
+
+static const GLuint colorLocation = 1;
+static const GLuint transformLocation = 2;
+
+mesh_registry::mesh_registry(size_t maxVertices, size_t maxIndices, size_t maxDraws)
+    : maxVertices(maxVertices), maxIndices(maxIndices), maxDraws(maxDraws) {
+    // Only submitted here, the first draw waits for the link
+    shaderProgram = queued_program(vertexShaderSource, fragmentShaderSource);
+
+    // glMultiDrawElementsIndirect and base instances are core in OpenGL 4.3
+    useIndirect = GLAD_GL_VERSION_4_3 != 0;
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, maxVertices * 3 * sizeof(float), nullptr, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, maxIndices * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+    // Per-draw data advances once per instance, the base instance of a command picks the first one
+    glEnableVertexAttribArray(colorLocation);
+    glVertexAttribDivisor(colorLocation, 1);
+    for (GLuint column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(transformLocation + column);
+        glVertexAttribDivisor(transformLocation + column, 1);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    dataStream = std::make_unique<stream_buffer>(GL_ARRAY_BUFFER, maxDraws * sizeof(draw_data));
+    if (useIndirect) {
+        commandStream = std::make_unique<stream_buffer>(GL_DRAW_INDIRECT_BUFFER,
+                                                        maxDraws * sizeof(draw_elements_indirect_command));
+    }
+}
+
+mesh_registry::~mesh_registry() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteProgram(shaderProgram.get());
+}
+
+bool mesh_registry::valid() const {
+    return shaderProgram.submitted() && VAO != 0;
+}
+
+bool mesh_registry::indirect() const {
+    return useIndirect;
+}
+
+int mesh_registry::addMesh(const float* positions, int vertices, const uint32_t* indices, int indexTotal) {
+    if (vertexCount + vertices > maxVertices || indexCount + indexTotal > maxIndices) {
+        std::cerr << "The mesh registry is full, can't add a mesh of " << vertices << " vertices" << std::endl;
+        return -1;
+    }
+
+    // Indices stay relative to the mesh, the base vertex of its commands offsets them
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, vertexCount * 3 * sizeof(float), vertices * 3 * sizeof(float), positions);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(VAO);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(uint32_t), indexTotal * sizeof(uint32_t), indices);
+    glBindVertexArray(0);
+
+    meshes.push_back(mesh_range{static_cast<uint32_t>(indexCount), static_cast<uint32_t>(indexTotal),
+                                static_cast<int32_t>(vertexCount)});
+    vertexCount += vertices;
+    indexCount += indexTotal;
+    return static_cast<int>(meshes.size() - 1);
+}
+
+const mesh_range& mesh_registry::mesh(int id) const {
+    return meshes[id];
+}
+
+unsigned int mesh_registry::vertexArray() const {
+    return VAO;
+}
+
+bool mesh_registry::addDraw(int mesh, const draw_data& data) {
+    if (mesh < 0 || static_cast<size_t>(mesh) >= meshes.size()) {
+        std::cerr << "Can't draw mesh " << mesh << ", the registry has " << meshes.size() << " meshes" << std::endl;
+        return false;
+    }
+
+    if (queuedMeshes.size() == maxDraws) {
+        submit();
+    }
+    queuedMeshes.push_back(mesh);
+    queuedData.push_back(data);
+    return true;
+}
+
+void mesh_registry::bindDrawData(size_t offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, dataStream->buffer());
+    glVertexAttribPointer(colorLocation, 4, GL_FLOAT, GL_FALSE, sizeof(draw_data),
+                          (void*)(offset + offsetof(draw_data, color)));
+    for (GLuint column = 0; column < 4; ++column) {
+        glVertexAttribPointer(transformLocation + column, 4, GL_FLOAT, GL_FALSE, sizeof(draw_data),
+                              (void*)(offset + offsetof(draw_data, transform) + column * sizeof(glm::vec4)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void mesh_registry::submit() {
+    if (queuedMeshes.empty()) {
+        return;
+    }
+
+    // Count the draws of every mesh, the running sum is where its data starts
+    meshDrawCounts.assign(meshes.size(), 0);
+    for (int mesh : queuedMeshes) {
+        meshDrawCounts[mesh]++;
+    }
+
+    commands.clear();
+    uint32_t start = 0;
+    for (size_t mesh = 0; mesh < meshes.size(); ++mesh) {
+        uint32_t count = meshDrawCounts[mesh];
+        if (count == 0) {
+            continue;
+        }
+        const mesh_range& range = meshes[mesh];
+        commands.push_back({range.indexCount, count, range.firstIndex, range.baseVertex, start});
+
+        // From here on the counter is the next free slot of the mesh
+        meshDrawCounts[mesh] = start;
+        start += count;
+    }
+
+    // Scatter the draw data straight into the stream buffer, grouped by mesh
+    size_t dataSize = queuedData.size() * sizeof(draw_data);
+    stream_allocation data = dataStream->allocate(dataSize, sizeof(draw_data));
+    if (!data.data) {
+        dataStream->endFrame();
+        data = dataStream->allocate(dataSize, sizeof(draw_data));
+    }
+    if (!data.data) {
+        std::cerr << "The draw data stream has no room for " << queuedData.size() << " draws" << std::endl;
+        queuedMeshes.clear();
+        queuedData.clear();
+        return;
+    }
+    draw_data* slots = static_cast<draw_data*>(data.data);
+    for (size_t i = 0; i < queuedMeshes.size(); ++i) {
+        slots[meshDrawCounts[queuedMeshes[i]]++] = queuedData[i];
+    }
+    dataStream->commit();
+
+    glUseProgram(shaderProgram.get());
+    glBindVertexArray(VAO);
+    bindDrawData(data.offset);
+
+    if (useIndirect) {
+        size_t commandSize = commands.size() * sizeof(draw_elements_indirect_command);
+        stream_allocation command = commandStream->allocate(commandSize, 4);
+        if (!command.data) {
+            commandStream->endFrame();
+            command = commandStream->allocate(commandSize, 4);
+        }
+        if (!command.data) {
+            std::cerr << "The command stream has no room for " << commands.size() << " commands" << std::endl;
+            queuedMeshes.clear();
+            queuedData.clear();
+            glBindVertexArray(0);
+            return;
+        }
+        std::memcpy(command.data, commands.data(), commandSize);
+        commandStream->commit();
+
+        // The whole pass in one call
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandStream->buffer());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)command.offset,
+                                    static_cast<GLsizei>(commands.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDrawCalls++;
+    } else {
+        // Without base instances the attributes move to the data of each command
+        for (const draw_elements_indirect_command& command : commands) {
+            bindDrawData(data.offset + command.baseInstance * sizeof(draw_data));
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                              (void*)(command.firstIndex * sizeof(uint32_t)),
+                                              command.instanceCount, command.baseVertex);
+            glDrawCalls++;
+        }
+    }
+
+    glBindVertexArray(0);
+
+    submittedDraws += static_cast<long>(queuedMeshes.size());
+    queuedMeshes.clear();
+    queuedData.clear();
+}
+
+void mesh_registry::endFrame() {
+    dataStream->endFrame();
+    if (commandStream) {
+        commandStream->endFrame();
+    }
+}
+
+long mesh_registry::drawCalls() const {
+    return glDrawCalls;
+}
+
+long mesh_registry::draws() const {
+    return submittedDraws;
+}
@@ -0,0 +1,111 @@
+// Shared buffers and indirect submission for many different meshes.
+//
+// mesh_registry packs the vertices and indices of every mesh added to it
+// into one vertex buffer and one index buffer. A pass is described by
+// addDraw() calls that pair a mesh with per-draw data; submit() groups the
+// draws by mesh, writes one DrawElementsIndirectCommand per mesh used and
+// issues the whole pass with a single glMultiDrawElementsIndirect call.
+// Each command covers all draws of its mesh as instances, and its base
+// instance selects where their per-draw data starts in an instanced
+// attribute stream, so the shader needs no extra lookup.
+//
+// Contexts older than 4.3 get the same commands issued one by one with
+// glDrawElementsInstancedBaseVertex.
+
+#ifndef OPENGL_TASKS_MESH_REGISTRY_H
+#define OPENGL_TASKS_MESH_REGISTRY_H
+
+#include "common/shader.h"
+#include "common/stream_buffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Per-draw data, matching the layout of the registry vertex shader
+struct draw_data {
+    glm::mat4 transform;
+    glm::vec4 color;
+};
+
+// Range of a mesh in the shared buffers
+struct mesh_range {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t baseVertex;
+};
+
+// Layout defined by OpenGL for glMultiDrawElementsIndirect
+struct draw_elements_indirect_command {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+class mesh_registry {
+public:
+    // The capacities bound the shared buffers, maxDraws bounds one pass
+    mesh_registry(size_t maxVertices, size_t maxIndices, size_t maxDraws = 1 << 17);
+    ~mesh_registry();
+
+    mesh_registry(const mesh_registry&) = delete;
+    mesh_registry& operator=(const mesh_registry&) = delete;
+
+    // True if the program and the buffers were created
+    bool valid() const;
+
+    // True when passes are submitted with glMultiDrawElementsIndirect
+    bool indirect() const;
+
+    // Adds a mesh of vertexCount xyz positions and triangle indices, returns its id or -1 if it doesn't fit
+    int addMesh(const float* positions, int vertexCount, const uint32_t* indices, int indexCount);
+
+    const mesh_range& mesh(int id) const;
+
+    // The shared buffers, for code that draws the meshes itself
+    unsigned int vertexArray() const;
+
+    // Queues a draw of a mesh for the next submit(), returns false if the id is not a mesh of the registry
+    bool addDraw(int mesh, const draw_data& data);
+
+    // Draws everything queued since the last submit()
+    void submit();
+
+    // Closes the frame of the command and draw data streams, call it once per frame after the last submit()
+    void endFrame();
+
+    // Number of GL draw calls and of draws queued since the registry was created
+    long drawCalls() const;
+    long draws() const;
+
+private:
+    // Function to point the per-draw attributes at the given offset of the data stream
+    void bindDrawData(size_t offset);
+
+    // Submitted by the constructor, linked by the first draw
+    queued_program shaderProgram;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    size_t maxVertices, maxIndices, maxDraws;
+    size_t vertexCount = 0, indexCount = 0;
+    bool useIndirect = false;
+
+    std::vector<mesh_range> meshes;
+
+    // Queued draws, grouped by mesh in submit()
+    std::vector<int> queuedMeshes;
+    std::vector<draw_data> queuedData;
+    std::vector<uint32_t> meshDrawCounts;
+    std::vector<draw_elements_indirect_command> commands;
+
+    std::unique_ptr<stream_buffer> commandStream;
+    std::unique_ptr<stream_buffer> dataStream;
+
+    long glDrawCalls = 0;
+    long submittedDraws = 0;
+};
+
+#endif // OPENGL_TASKS_MESH_REGISTRY_H
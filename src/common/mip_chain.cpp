@@ -0,0 +1,548 @@
+#include "common/mip_chain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define MIP_FILTER_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define MIP_FILTER_SSE2 1
+#endif
+
+// Layout of a .mips file, all fields little-endian
+struct mip_file_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t levels;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t sourceSize;  // of the image the chain was cooked from
+    int64_t sourceTime;
+};
+
+struct mip_file_level {
+    uint64_t offset;  // from the start of the file
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+static_assert(sizeof(mip_file_header) == 48, "mip_file_header must match the file layout");
+static_assert(sizeof(mip_file_level) == 24, "mip_file_level must match the file layout");
+
+static const char mipMagic[4] = {'M', 'I', 'P', 'S'};
+static const uint32_t mipVersion = 2;
+static const uint32_t mipFlagSrgb = 1;
+static const size_t mipAlignment = 16;
+static const int maxMipLevels = 32;
+
+// Pixels of a level in float, always four lanes per pixel whatever the channel count
+struct float_image {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+};
+
+// Separable filter along one axis: output i reads the source pixels 2 * i + first + k when the size halves
+// exactly, a kernel per output pixel reads the source pixels first + k
+struct mip_kernel {
+    int first;
+    std::vector<float> weights;
+};
+
+// Pixels of clamped border added on each side of a row, enough for the widest kernel
+static const int rowPadding = 4;
+
+// Number of levels from width x height down to 1x1
+static uint32_t mipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+static size_t alignUp(size_t value) {
+    return (value + mipAlignment - 1) / mipAlignment * mipAlignment;
+}
+
+static float srgbToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// Modified Bessel function of the first kind and order 0, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Weight of a source pixel at distance d from the output center, in source pixels, for a level scale times smaller
+static double filterWeight(mip_filter filter, double d, double scale) {
+    if (filter == mip_filter::box) {
+        // Overlap of the source pixel with the footprint of the output pixel
+        return std::max(0.0, std::min(d + 0.5, 0.5 * scale) - std::max(d - 0.5, -0.5 * scale));
+    }
+
+    // Sinc of the output band, windowed over two output pixels on each side of the center
+    const double pi = 3.14159265358979323846, alpha = 4.0;
+    double t = d / scale;
+    if (std::abs(t) >= 2.0) {
+        return 0.0;
+    }
+    double sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+    return sinc * besselI0(alpha * std::sqrt(1.0 - 0.25 * t * t)) / besselI0(alpha);
+}
+
+// Kernel of the output pixel centered at source position center, over every source pixel it weighs
+static mip_kernel kernelAt(mip_filter filter, double center, double scale) {
+    // Largest distance between the centers of the output pixel and a source pixel with some weight
+    double support = filter == mip_filter::box ? 0.5 * scale + 0.5 : 2.0 * scale;
+    int from = static_cast<int>(std::floor(center - support - 0.5)) + 1;
+    int to = static_cast<int>(std::ceil(center + support - 0.5)) - 1;
+
+    std::vector<double> weights;
+    double total = 0.0;
+    for (int x = from; x <= to; ++x) {
+        weights.push_back(filterWeight(filter, x + 0.5 - center, scale));
+        total += weights.back();
+    }
+    mip_kernel kernel{from, {}};
+    for (double weight : weights) {
+        kernel.weights.push_back(static_cast<float>(weight / total));
+    }
+    return kernel;
+}
+
+// Kernel of output pixel 0 when a size halves exactly, output i reads the source pixels 2 * i + first + k
+static mip_kernel kernelFor(mip_filter filter) {
+    return kernelAt(filter, 1.0, 2.0);
+}
+
+// Function to build the kernel of every output pixel along an axis. Output i is centered at
+// (i + 0.5) * sourceSize / outSize, so odd sizes get weights that shift from pixel to pixel instead of
+// dropping the last source pixel. Taps past the edges repeat the edge pixels and add to their weights.
+static std::vector<mip_kernel> axisKernels(mip_filter filter, int sourceSize, int outSize) {
+    double scale = static_cast<double>(sourceSize) / outSize;
+    std::vector<mip_kernel> kernels;
+    for (int i = 0; i < outSize; ++i) {
+        mip_kernel kernel = kernelAt(filter, (i + 0.5) * scale, scale);
+        int last = kernel.first + static_cast<int>(kernel.weights.size()) - 1;
+        mip_kernel clamped{std::clamp(kernel.first, 0, sourceSize - 1), {}};
+        clamped.weights.assign(std::clamp(last, 0, sourceSize - 1) - clamped.first + 1, 0.0f);
+        for (size_t k = 0; k < kernel.weights.size(); ++k) {
+            int x = std::clamp(kernel.first + static_cast<int>(k), 0, sourceSize - 1);
+            clamped.weights[x - clamped.first] += kernel.weights[k];
+        }
+        kernels.push_back(clamped);
+    }
+    return kernels;
+}
+
+// Function to split rows into contiguous ranges, one per thread
+static void parallelRows(int rows, int threads, const std::function<void(int, int)>& work) {
+    threads = std::min(threads, rows);
+    if (threads <= 1) {
+        work(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        int begin = rows * t / threads, end = rows * (t + 1) / threads;
+        workers.emplace_back(work, begin, end);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Function to write the weighted sum of rows into out, count floats each
+static void weightedRowSum(float* out, const float* const* rows, const float* weights, int taps, size_t count) {
+    size_t i = 0;
+#if defined(MIP_FILTER_AVX2)
+    for (; i + 8 <= count; i += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        }
+        _mm256_storeu_ps(out + i, sum);
+    }
+#endif
+#if defined(MIP_FILTER_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        }
+        _mm_storeu_ps(out + i, sum);
+    }
+#endif
+    for (; i < count; ++i) {
+        float sum = 0.0f;
+        for (int k = 0; k < taps; ++k) {
+            sum += weights[k] * rows[k][i];
+        }
+        out[i] = sum;
+    }
+}
+
+// Function to halve a padded row, padded points at the first real pixel
+static void filterRow(float* out, const float* padded, int outWidth, const mip_kernel& kernel) {
+    int taps = static_cast<int>(kernel.weights.size());
+    const float* weights = kernel.weights.data();
+    int i = 0;
+#if defined(MIP_FILTER_AVX2)
+    // Two output pixels at once, their taps are two source pixels apart and share the weights
+    for (; i + 2 <= outWidth; i += 2) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            const float* source = padded + 4 * (2 * i + kernel.first + k);
+            __m256 pair = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(source)), _mm_loadu_ps(source + 8), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[k]), pair));
+        }
+        _mm256_storeu_ps(out + 4 * i, sum);
+    }
+#endif
+#if defined(MIP_FILTER_SSE2)
+    for (; i < outWidth; ++i) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(padded + 4 * (2 * i + kernel.first + k))));
+        }
+        _mm_storeu_ps(out + 4 * i, sum);
+    }
+#endif
+    for (; i < outWidth; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            float sum = 0.0f;
+            for (int k = 0; k < taps; ++k) {
+                sum += weights[k] * padded[4 * (2 * i + kernel.first + k) + c];
+            }
+            out[4 * i + c] = sum;
+        }
+    }
+}
+
+// Function to filter a row with a kernel per output pixel, for odd widths
+static void filterRowScaled(float* out, const float* row, const std::vector<mip_kernel>& kernels) {
+    for (size_t i = 0; i < kernels.size(); ++i) {
+        const mip_kernel& kernel = kernels[i];
+        int taps = static_cast<int>(kernel.weights.size());
+        const float* source = row + 4 * kernel.first;
+#if defined(MIP_FILTER_SSE2)
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(source + 4 * k)));
+        }
+        _mm_storeu_ps(out + 4 * i, sum);
+#else
+        for (int c = 0; c < 4; ++c) {
+            float sum = 0.0f;
+            for (int k = 0; k < taps; ++k) {
+                sum += kernel.weights[k] * source[4 * k + c];
+            }
+            out[4 * i + c] = sum;
+        }
+#endif
+    }
+}
+
+// Function to filter the next level, the vertical pass of an output row feeds its horizontal pass
+static float_image downsample(const float_image& source, mip_filter filter, int threads) {
+    float_image result;
+    result.width = std::max(1, source.width / 2);
+    result.height = std::max(1, source.height / 2);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+    // Even widths share one kernel across the row, odd ones and every column get one kernel per output pixel
+    mip_kernel kernel = kernelFor(filter);
+    bool halving = source.width == 2 * result.width;
+    std::vector<mip_kernel> rowKernels;
+    if (!halving) {
+        rowKernels = axisKernels(filter, source.width, result.width);
+    }
+    std::vector<mip_kernel> columnKernels = axisKernels(filter, source.height, result.height);
+    size_t rowFloats = static_cast<size_t>(source.width) * 4;
+
+    parallelRows(result.height, threads, [&](int begin, int end) {
+        std::vector<float> padded((source.width + 2 * rowPadding) * 4);
+        float* row = padded.data() + rowPadding * 4;
+        std::vector<const float*> rows;
+
+        for (int y = begin; y < end; ++y) {
+            const mip_kernel& column = columnKernels[y];
+            int taps = static_cast<int>(column.weights.size());
+            rows.resize(taps);
+            for (int k = 0; k < taps; ++k) {
+                rows[k] = source.pixels.data() + (column.first + k) * rowFloats;
+            }
+            weightedRowSum(row, rows.data(), column.weights.data(), taps, rowFloats);
+
+            float* out = result.pixels.data() + static_cast<size_t>(y) * result.width * 4;
+            if (!halving) {
+                filterRowScaled(out, row, rowKernels);
+                continue;
+            }
+
+            // Repeat the edge pixels into the padding
+            for (int p = 0; p < rowPadding; ++p) {
+                std::memcpy(padded.data() + p * 4, row, 4 * sizeof(float));
+                std::memcpy(row + rowFloats + p * 4, row + rowFloats - 4, 4 * sizeof(float));
+            }
+            filterRow(out, row, result.width, kernel);
+        }
+    });
+    return result;
+}
+
+// Function to round a float level to 8 bits into out, tightly packed
+static void quantize(const float_image& image, int channels, bool gamma, unsigned char* out, int threads) {
+    parallelRows(image.height, threads, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+            for (int x = 0; x < image.width; ++x) {
+                const float* pixel = image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+                unsigned char* target = out + (static_cast<size_t>(y) * image.width + x) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    float value = std::clamp(pixel[c], 0.0f, 1.0f);
+                    if (gamma && c < 3) {
+                        value = linearToSrgb(value);
+                    }
+                    target[c] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    });
+}
+
+mip_chain generateMipChain(const unsigned char* pixels, int width, int height, int channels, bool srgb,
+                           mip_filter filter, int threads) {
+    mip_chain chain;
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        std::cerr << "Invalid image for a mip chain: " << width << "x" << height << " with " << channels
+                  << " channels" << std::endl;
+        return chain;
+    }
+    if (threads <= 0) {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    chain.width = width;
+    chain.height = height;
+    chain.channels = channels;
+    chain.srgb = srgb;
+
+    // Gray images have no sRGB formats, only color channels are averaged in linear light
+    bool gamma = srgb && channels >= 3;
+    float toLinear[256];
+    for (int i = 0; i < 256; ++i) {
+        toLinear[i] = gamma ? srgbToLinear(i / 255.0f) : i / 255.0f;
+    }
+
+    float_image level;
+    level.width = width;
+    level.height = height;
+    level.pixels.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            unsigned char value = pixels[i * channels + c];
+            level.pixels[i * 4 + c] = c < 3 ? toLinear[value] : value / 255.0f;
+        }
+    }
+
+    while (true) {
+        mip_level entry;
+        entry.width = level.width;
+        entry.height = level.height;
+        entry.offset = alignUp(chain.data.size());
+        entry.size = static_cast<size_t>(level.width) * level.height * channels;
+        chain.data.resize(entry.offset + entry.size);
+
+        // The first level is the image itself, untouched by the float round trip
+        if (chain.levels.empty()) {
+            std::memcpy(chain.data.data() + entry.offset, pixels, entry.size);
+        } else {
+            quantize(level, channels, gamma, chain.data.data() + entry.offset, threads);
+        }
+        chain.levels.push_back(entry);
+
+        if (level.width == 1 && level.height == 1) {
+            break;
+        }
+        level = downsample(level, filter, threads);
+    }
+    return chain;
+}
+
+bool writeMipChain(const std::string& path, const mip_chain& chain) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    mip_file_header header;
+    std::memcpy(header.magic, mipMagic, sizeof(mipMagic));
+    header.version = mipVersion;
+    header.width = static_cast<uint32_t>(chain.width);
+    header.height = static_cast<uint32_t>(chain.height);
+    header.channels = static_cast<uint32_t>(chain.channels);
+    header.levels = static_cast<uint32_t>(chain.levels.size());
+    header.flags = chain.srgb ? mipFlagSrgb : 0;
+    header.reserved = 0;
+    header.sourceSize = chain.sourceSize;
+    header.sourceTime = chain.sourceTime;
+
+    size_t dataStart = alignUp(sizeof(header) + chain.levels.size() * sizeof(mip_file_level));
+    std::vector<mip_file_level> table;
+    for (const mip_level& level : chain.levels) {
+        table.push_back({dataStart + level.offset, level.size, static_cast<uint32_t>(level.width),
+                         static_cast<uint32_t>(level.height)});
+    }
+
+    std::vector<char> padding(dataStart - sizeof(header) - table.size() * sizeof(mip_file_level), 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(mip_file_level));
+    file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char*>(chain.data.data()), chain.data.size());
+
+    if (!file) {
+        std::cerr << "Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readMipChain(const std::string& path, mip_chain& chain) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    mip_file_header header;
+    if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, mipMagic, sizeof(mipMagic)) != 0 || header.version != mipVersion ||
+        header.channels < 1 || header.channels > 4 || header.levels < 1 || header.levels > maxMipLevels) {
+        std::cerr << "Invalid mip chain file " << path << std::endl;
+        return false;
+    }
+
+    std::vector<mip_file_level> table(header.levels);
+    size_t dataStart = alignUp(sizeof(header) + table.size() * sizeof(mip_file_level));
+    if (dataStart > fileSize ||
+        !file.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(mip_file_level))) {
+        std::cerr << "Invalid mip chain file " << path << std::endl;
+        return false;
+    }
+
+    // The chain runs from the size of the image down to 1x1, halving each time
+    if (header.width < 1 || header.height < 1 || header.levels != mipLevelCount(header.width, header.height)) {
+        std::cerr << "Mip chain file " << path << " has " << header.levels << " levels for " << header.width << "x"
+                  << header.height << std::endl;
+        return false;
+    }
+
+    chain.width = static_cast<int>(header.width);
+    chain.height = static_cast<int>(header.height);
+    chain.channels = static_cast<int>(header.channels);
+    chain.srgb = (header.flags & mipFlagSrgb) != 0;
+    chain.sourceSize = header.sourceSize;
+    chain.sourceTime = header.sourceTime;
+    chain.levels.clear();
+    uint32_t width = header.width, height = header.height;
+    for (const mip_file_level& entry : table) {
+        if (entry.width != width || entry.height != height || entry.offset < dataStart ||
+            entry.offset + entry.size > fileSize ||
+            entry.size != static_cast<uint64_t>(entry.width) * entry.height * header.channels) {
+            std::cerr << "Invalid level in mip chain file " << path << std::endl;
+            return false;
+        }
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        chain.levels.push_back({static_cast<int>(entry.width), static_cast<int>(entry.height),
+                                static_cast<size_t>(entry.offset - dataStart), static_cast<size_t>(entry.size)});
+    }
+
+    chain.data.resize(fileSize - dataStart);
+    file.seekg(static_cast<std::streamoff>(dataStart));
+    if (!file.read(reinterpret_cast<char*>(chain.data.data()), chain.data.size())) {
+        std::cerr << "Failed to read " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool stampMipChain(const std::string& imagePath, mip_chain& chain) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(imagePath, error);
+    if (error) {
+        return false;
+    }
+    auto time = std::filesystem::last_write_time(imagePath, error);
+    if (error) {
+        return false;
+    }
+    chain.sourceSize = size;
+    chain.sourceTime = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool readCookedTexture(const std::string& imagePath, mip_chain& chain) {
+    std::string path = cookedTexturePath(imagePath);
+    std::error_code error;
+    if (!std::filesystem::exists(path, error) || !readMipChain(path, chain)) {
+        return false;
+    }
+
+    // An image saved after it was cooked would show its old pixels
+    mip_chain image;
+    if (!stampMipChain(imagePath, image) || image.sourceSize != chain.sourceSize ||
+        image.sourceTime != chain.sourceTime) {
+        std::cerr << path << " was cooked from another version of " << imagePath << ", ignoring it" << std::endl;
+        chain = mip_chain();
+        return false;
+    }
+    return true;
+}
+
+std::string cookedTexturePath(const std::string& imagePath) {
+    size_t slash = imagePath.find_last_of("/\\");
+    size_t dot = imagePath.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return imagePath + ".mips";
+    }
+    return imagePath.substr(0, dot) + ".mips";
+}
+
+const char* mipFilterInstructionSet() {
+#if defined(MIP_FILTER_AVX2)
+    return "AVX2";
+#elif defined(MIP_FILTER_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,73 @@
+// Mip chains built on the CPU and stored next to their image.
+//
+// generateMipChain() halves an 8-bit image down to 1x1. Every level is
+// filtered from the one above it in float: a 2x2 box, or an 8-tap Kaiser
+// windowed sinc that keeps more detail without ringing much. An odd size
+// shrinks by a little more than two, so its filter is stretched to match
+// and every source pixel still counts. sRGB color channels are converted
+// to linear light before averaging and back after, so mips don't darken.
+// The filters run on SSE2, or AVX2 when the build enables it, and the rows
+// of each level are split across threads.
+//
+// A .mips file holds the chain as uploaded: a header, one table entry per
+// level and the tightly packed levels, each starting at a 16-byte
+// boundary. texture_cook writes them, and texture_loader uploads the
+// levels of the file next to an image instead of decoding it and calling
+// glGenerateMipmap. The header keeps the size and modification time of the
+// image, so a file cooked from an older version of it is ignored.
+
+#ifndef OPENGL_TASKS_MIP_CHAIN_H
+#define OPENGL_TASKS_MIP_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class mip_filter { box, kaiser };
+
+struct mip_level {
+    int width = 0;
+    int height = 0;
+    size_t offset = 0;
+    size_t size = 0;
+};
+
+struct mip_chain {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    bool srgb = false;
+
+    // Size and modification time of the image the chain was cooked from, 0 if unknown
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+
+    std::vector<mip_level> levels;
+    std::vector<unsigned char> data;
+};
+
+// Function to build every level from tightly packed pixels, threads 0 uses all hardware threads
+mip_chain generateMipChain(const unsigned char* pixels, int width, int height, int channels, bool srgb,
+                           mip_filter filter, int threads = 0);
+
+// Function to write a chain as a .mips file, returns false on failure
+bool writeMipChain(const std::string& path, const mip_chain& chain);
+
+// Function to read a .mips file, returns false if it is missing or invalid
+bool readMipChain(const std::string& path, mip_chain& chain);
+
+// Function to record the size and modification time of the image in the chain, returns false if it is missing
+bool stampMipChain(const std::string& imagePath, mip_chain& chain);
+
+// Function to read the .mips file next to an image, returns false if there is none, if it is invalid or if it
+// was cooked from another version of the image
+bool readCookedTexture(const std::string& imagePath, mip_chain& chain);
+
+// The .mips file next to an image: the image path with its extension replaced
+std::string cookedTexturePath(const std::string& imagePath);
+
+// Name of the instruction set the filters were compiled for
+const char* mipFilterInstructionSet();
+
+#endif // OPENGL_TASKS_MIP_CHAIN_H
@@ -0,0 +1,52 @@
+#include "common/packed_mesh.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <iostream>
+
+bool createPackedMesh(const asset_pack& pack, const asset_pack_entry& entry, packed_mesh& mesh) {
+    if (entry.kind != static_cast<uint32_t>(asset_kind::mesh) || entry.rangeCount != 2 ||
+        entry.format != static_cast<uint32_t>(packed_mesh_layout::stride)) {
+        std::cerr << "Asset " << entry.name << " is not a mesh of " << packed_mesh_layout::stride
+                  << "-byte vertices" << std::endl;
+        return false;
+    }
+
+    // Both ranges must hold exactly the vertices and indices of the entry, glBufferData reads them in place
+    size_t vertexBytes = 0, indexBytes = 0;
+    const unsigned char* vertices = pack.range(entry, 0, &vertexBytes);
+    const unsigned char* indices = pack.range(entry, 1, &indexBytes);
+    if (entry.width == 0 || entry.height == 0 ||
+        vertexBytes != static_cast<size_t>(entry.width) * packed_mesh_layout::stride ||
+        indexBytes != static_cast<size_t>(entry.height) * sizeof(uint32_t)) {
+        std::cerr << "Asset " << entry.name << " has " << vertexBytes << " vertex and " << indexBytes
+                  << " index bytes for " << entry.width << " vertices and " << entry.height << " indices"
+                  << std::endl;
+        return false;
+    }
+
+    mesh = packed_mesh();
+    mesh.vertexCount = static_cast<int>(entry.width);
+    mesh.indexCount = static_cast<int>(entry.height);
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexBytes), indices, GL_STATIC_DRAW);
+    setupVertexLayout<packed_mesh_layout>(mesh.VBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void deletePackedMesh(packed_mesh& mesh) {
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    mesh = packed_mesh();
+}
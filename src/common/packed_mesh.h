@@ -0,0 +1,43 @@
+// Meshes of an asset pack uploaded straight from the mapped file.
+//
+// pack_assets stores an OBJ mesh as two ranges (asset_pack.h): interleaved
+// vertices of float positions, normals and texture coordinates, 32 bytes
+// each, and 32-bit indices. createPackedMesh() hands both ranges of the
+// mapping to glBufferData, so the vertices are never read into a heap
+// buffer or converted, and sets up a vertex array that reads the position
+// at location 0, the normal at 1 and the texture coordinates at 2.
+
+#ifndef OPENGL_TASKS_PACKED_MESH_H
+#define OPENGL_TASKS_PACKED_MESH_H
+
+#include "common/asset_pack.h"
+#include "common/vertex_layout.h"
+
+#include <glm/glm.hpp>
+
+// Vertex of a mesh asset, as written by pack_assets
+struct packed_mesh_vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+typedef vertex_layout<packed_mesh_vertex,
+                      VERTEX_ATTRIBUTE(packed_mesh_vertex, position),
+                      VERTEX_ATTRIBUTE(packed_mesh_vertex, normal),
+                      VERTEX_ATTRIBUTE(packed_mesh_vertex, texCoord)> packed_mesh_layout;
+
+// Buffers of a mesh asset, draw with glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0)
+struct packed_mesh {
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    int vertexCount = 0;
+    int indexCount = 0;
+};
+
+// Function to create the buffers and the vertex array of a mesh asset, returns false if it is not a valid mesh
+bool createPackedMesh(const asset_pack& pack, const asset_pack_entry& entry, packed_mesh& mesh);
+
+// Function to delete the buffers and the vertex array of a mesh
+void deletePackedMesh(packed_mesh& mesh);
+
+#endif // OPENGL_TASKS_PACKED_MESH_H
@@ -0,0 +1,321 @@
+#include "common/polyline_renderer.h"
+
+#include "common/viewport.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// Every instance is a segment from aStart to aEnd, aPrevious and aNext are the points around it.
+// Vertices 0 and 1 are the corners at the start, 2 and 3 those at the end. Local is the position
+// relative to the start of the segment, x along it and y across it.
+static const char* vertexShaderSource = R"(
+    layout (location = 0) in vec2 aPrevious;
+    layout (location = 1) in vec3 aStart;
+    layout (location = 2) in vec4 aStartColor;
+    layout (location = 3) in vec3 aEnd;
+    layout (location = 4) in vec4 aEndColor;
+    layout (location = 5) in vec2 aNext;
+    uniform mat4 transform;
+    uniform int segmentCount;
+    uniform int join;
+    uniform int cap;
+    uniform float miterLimit;
+    out vec2 Local;
+    out float HalfWidth;
+    out vec4 Color;
+    flat out float Length;
+    flat out ivec2 RoundEnds;
+    flat out vec2 FlatEnds;
+
+    vec2 toViewport(vec2 position) {
+        return (transform * vec4(position, 0.0, 1.0)).xy;
+    }
+
+    // Direction from a to b, or the fallback when they are the same point
+    vec2 directionOf(vec2 a, vec2 b, vec2 fallback) {
+        vec2 axis = b - a;
+        float len = length(axis);
+        return len > 0.0 ? axis / len : fallback;
+    }
+
+    void main() {
+        float pixel = 2.0 * viewport.size.z;
+        vec2 start = toViewport(aStart.xy);
+        vec2 end = toViewport(aEnd.xy);
+        vec2 direction = directionOf(start, end, vec2(1.0, 0.0));
+        vec2 normal = vec2(-direction.y, direction.x);
+
+        bool atEnd = gl_VertexID >= 2;
+        float side = (gl_VertexID & 1) == 0 ? -1.0 : 1.0;
+        bool isCap = atEnd ? gl_InstanceID == segmentCount - 1 : gl_InstanceID == 0;
+        bool isRound = isCap ? cap == 2 : join == 1;
+
+        // Half of the width plus one pixel for the anti-aliased edge
+        float halfWidth = 0.5 * (atEnd ? aEnd.z : aStart.z) * pixel;
+        float extent = halfWidth + pixel;
+
+        vec2 offset = normal * side * extent;
+        float along = 0.0;
+        if (isRound) {
+            along = extent;
+        } else if (isCap) {
+            // Butt caps end at the point and square ones half a width later, plus the anti-aliased pixel
+            along = (cap == 1 ? halfWidth : 0.0) + pixel;
+        } else {
+            // Miter join, the corner sits where the edges of this segment and its neighbour meet
+            vec2 neighbour = atEnd ? directionOf(end, toViewport(aNext), direction)
+                                   : directionOf(toViewport(aPrevious), start, direction);
+            vec2 miter = normal + vec2(-neighbour.y, neighbour.x);
+            if (dot(miter, miter) > 1e-6) {
+                miter = normalize(miter);
+                offset = miter * side * extent / max(dot(miter, normal), 1.0 / miterLimit);
+            }
+        }
+
+        vec2 position = (atEnd ? end : start) + offset + direction * (atEnd ? along : -along);
+        gl_Position = viewport.projection * vec4(position, 0.0, 1.0);
+
+        Local = vec2(dot(position - start, direction), dot(position - start, normal));
+        HalfWidth = halfWidth;
+        Color = atEnd ? aEndColor : aStartColor;
+        Length = length(end - start);
+        RoundEnds = ivec2(gl_InstanceID == 0 ? cap == 2 : join == 1,
+                          gl_InstanceID == segmentCount - 1 ? cap == 2 : join == 1);
+
+        // How far butt and square caps reach past their end point, negative at joins and round caps
+        float square = cap == 1 ? 0.5 * pixel : 0.0;
+        FlatEnds = vec2(gl_InstanceID == 0 && cap != 2 ? square * aStart.z : -1.0,
+                        gl_InstanceID == segmentCount - 1 && cap != 2 ? square * aEnd.z : -1.0);
+    }
+)";
+
+// The distance is to the sides of the segment, round ends measure it from the end points and butt and
+// square caps add the distance past the end along the segment
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec2 Local;
+    in float HalfWidth;
+    in vec4 Color;
+    flat in float Length;
+    flat in ivec2 RoundEnds;
+    flat in vec2 FlatEnds;
+    out vec4 FragColor;
+    void main() {
+        float distance = abs(Local.y) - HalfWidth;
+        if (FlatEnds.x >= 0.0) {
+            distance = max(distance, -Local.x - FlatEnds.x);
+        }
+        if (FlatEnds.y >= 0.0) {
+            distance = max(distance, Local.x - Length - FlatEnds.y);
+        }
+        if (RoundEnds.x != 0 && Local.x < 0.0) {
+            distance = length(Local) - HalfWidth;
+        } else if (RoundEnds.y != 0 && Local.x > Length) {
+            distance = length(Local - vec2(Length, 0.0)) - HalfWidth;
+        }
+
+        float coverage = clamp(0.5 - distance / max(fwidth(distance), 1e-6), 0.0, 1.0);
+        FragColor = vec4(Color.rgb, Color.a * coverage);
+    }
+)";
+
+static const size_t pointSize = sizeof(polyline_point);
+
+polyline_renderer::polyline_renderer(size_t blockSize) {
+    // The vertex shader starts with the declaration of the Viewport block
+    std::string vertexShader = std::string("#version 330 core\n") + viewportBlockSource + vertexShaderSource;
+    shaderProgram = queued_program(vertexShader.c_str(), fragmentShaderSource);
+
+    // Every attribute advances once per segment, the pointers are set by bindSegments
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    for (GLuint location = 0; location < 6; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(0);
+
+    // Points are appended while the polylines are drawn
+    storage = std::make_unique<buffer_allocator>(GL_ARRAY_BUFFER, blockSize, GL_DYNAMIC_DRAW);
+}
+
+polyline_renderer::~polyline_renderer() {
+    storage.reset();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(shaderProgram.get());
+}
+
+bool polyline_renderer::valid() const {
+    return shaderProgram.submitted() && VAO != 0;
+}
+
+unsigned int polyline_renderer::program() {
+    // Block binding and uniform locations need the linked program, the first draw waits for it
+    unsigned int linked = shaderProgram.get();
+    if (!programReady && linked != 0) {
+        programReady = true;
+        bindViewportBlock(linked);
+
+        // The reflection reports a missing or mistyped uniform, draws then skip setting it
+        program_reflection reflection(linked);
+        transformUniform = reflection.uniform<glm::mat4>("transform");
+        segmentCountUniform = reflection.uniform<int>("segmentCount");
+        joinUniform = reflection.uniform<int>("join");
+        capUniform = reflection.uniform<int>("cap");
+        miterLimitUniform = reflection.uniform<float>("miterLimit");
+    }
+    return linked;
+}
+
+void polyline_renderer::writePoints(const polyline& line, size_t first, const polyline_point* points, size_t count) {
+    // The points go after the spare point at the start, the last one is repeated as the spare at the end
+    std::vector<polyline_point> data(points, points + count);
+    data.push_back(points[count - 1]);
+    storage->upload(line.allocation, data.data(), data.size() * pointSize, (first + 1) * pointSize);
+    totals.uploadedBytes += data.size() * pointSize;
+}
+
+int polyline_renderer::create(const polyline_point* points, size_t count, const polyline_style& style) {
+    if (count == 0) {
+        std::cerr << "Polyline without points" << std::endl;
+        return -1;
+    }
+
+    polyline line;
+    line.capacity = count;
+    line.style = style;
+    line.used = true;
+    line.allocation = storage->allocate((count + 2) * pointSize, pointSize);
+    if (line.allocation < 0) {
+        return -1;
+    }
+
+    storage->upload(line.allocation, points, pointSize);
+    writePoints(line, 0, points, count);
+    line.count = count;
+
+    // Reuse the slot of a removed polyline
+    for (size_t i = 0; i < polylines.size(); ++i) {
+        if (!polylines[i].used) {
+            polylines[i] = line;
+            return static_cast<int>(i);
+        }
+    }
+    polylines.push_back(line);
+    return static_cast<int>(polylines.size() - 1);
+}
+
+bool polyline_renderer::append(int id, const polyline_point* points, size_t count) {
+    if (id < 0 || id >= static_cast<int>(polylines.size()) || !polylines[id].used) {
+        std::cerr << "Unknown polyline " << id << std::endl;
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+
+    polyline& line = polylines[id];
+    if (line.count + count > line.capacity) {
+        // Move the polyline to a range twice as large, the GPU copies the points it already has
+        size_t capacity = std::max(2 * line.capacity, line.count + count);
+        int allocation = storage->allocate((capacity + 2) * pointSize, pointSize);
+        if (allocation < 0) {
+            return false;
+        }
+
+        const buffer_range& from = storage->range(line.allocation);
+        const buffer_range& to = storage->range(allocation);
+        glBindBuffer(GL_COPY_READ_BUFFER, from.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from.offset, to.offset,
+                            (line.count + 1) * pointSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        storage->free(line.allocation);
+        line.allocation = allocation;
+        line.capacity = capacity;
+        totals.moves++;
+    }
+
+    writePoints(line, line.count, points, count);
+    line.count += count;
+    return true;
+}
+
+void polyline_renderer::setStyle(int id, const polyline_style& style) {
+    if (id >= 0 && id < static_cast<int>(polylines.size()) && polylines[id].used) {
+        polylines[id].style = style;
+    }
+}
+
+void polyline_renderer::remove(int id) {
+    if (id >= 0 && id < static_cast<int>(polylines.size()) && polylines[id].used) {
+        storage->free(polylines[id].allocation);
+        polylines[id] = polyline();
+    }
+}
+
+size_t polyline_renderer::pointCount(int id) const {
+    if (id < 0 || id >= static_cast<int>(polylines.size()) || !polylines[id].used) {
+        return 0;
+    }
+    return polylines[id].count;
+}
+
+void polyline_renderer::setTransform(const glm::mat4& value) {
+    transform = value;
+}
+
+void polyline_renderer::bindSegments(const buffer_range& range) {
+    // Instance i reads the points i to i + 3 of the range, the first one being the spare before the polyline
+    glBindBuffer(GL_ARRAY_BUFFER, range.buffer);
+    size_t offset = range.offset;
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, pointSize, (void*)offset);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, pointSize, (void*)(offset + pointSize));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, pointSize,
+                          (void*)(offset + pointSize + offsetof(polyline_point, color)));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, pointSize, (void*)(offset + 2 * pointSize));
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, pointSize,
+                          (void*)(offset + 2 * pointSize + offsetof(polyline_point, color)));
+    glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, pointSize, (void*)(offset + 3 * pointSize));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void polyline_renderer::draw() {
+    glUseProgram(program());
+    setUniform(transformUniform, transform);
+    glBindVertexArray(VAO);
+
+    // Coverage goes into alpha, blending is turned off again so other draws are not affected
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    for (const polyline& line : polylines) {
+        if (!line.used || line.count < 2) {
+            continue;
+        }
+
+        GLsizei segments = static_cast<GLsizei>(line.count - 1);
+        setUniform(segmentCountUniform, segments);
+        setUniform(joinUniform, static_cast<int>(line.style.join));
+        setUniform(capUniform, static_cast<int>(line.style.cap));
+        setUniform(miterLimitUniform, line.style.miterLimit);
+
+        bindSegments(storage->range(line.allocation));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, segments);
+        totals.drawCalls++;
+        totals.segments += segments;
+    }
+
+    glDisable(GL_BLEND);
+    glBindVertexArray(0);
+}
+
+polyline_stats polyline_renderer::stats() const {
+    return totals;
+}
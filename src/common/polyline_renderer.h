@@ -0,0 +1,127 @@
+// Thick polylines expanded on the GPU.
+//
+// The points of every polyline are uploaded once into ranges of a
+// buffer_allocator and never re-tessellated on the CPU. A polyline is drawn
+// with one instanced call of four vertices per segment: the instance
+// attributes read the segment's two points and their neighbours from the
+// same buffer at consecutive offsets, and the vertex shader places the
+// corners of the segment's quad from gl_VertexID. Miter joins move the
+// corners of neighbouring quads to the intersection of their edges, round
+// joins and caps extend the quads and cut the ends with a signed distance
+// in the fragment shader, which also anti-aliases the sides.
+//
+// A polyline's range keeps a spare point before the first and after the
+// last one, so the first and last segments read valid memory. append()
+// writes the new points over the spare at the end, and only moves the
+// polyline to a range twice as large when it is full.
+//
+// Positions go through setTransform() into the space of the Viewport
+// block (viewport.h), widths are in pixels and colors are RGBA8 as
+// returned by packColor().
+
+#ifndef OPENGL_TASKS_POLYLINE_RENDERER_H
+#define OPENGL_TASKS_POLYLINE_RENDERER_H
+
+#include "common/buffer_allocator.h"
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A point of a polyline as stored in the buffer
+struct polyline_point {
+    glm::vec2 position;
+    float width;  // in pixels
+    uint32_t color;
+};
+
+enum class polyline_join { miter, round };
+enum class polyline_cap { butt, square, round };
+
+struct polyline_style {
+    polyline_join join = polyline_join::miter;
+    polyline_cap cap = polyline_cap::butt;
+
+    // Longest miter as a multiple of the half width, sharper joins are clamped to that length, not beveled
+    float miterLimit = 4.0f;
+};
+
+// Totals since the renderer was created
+struct polyline_stats {
+    long drawCalls = 0;
+    long segments = 0;
+    size_t uploadedBytes = 0;
+    long moves = 0;
+};
+
+class polyline_renderer {
+public:
+    explicit polyline_renderer(size_t blockSize = 1 << 22);
+    ~polyline_renderer();
+
+    polyline_renderer(const polyline_renderer&) = delete;
+    polyline_renderer& operator=(const polyline_renderer&) = delete;
+
+    // True if the program and the vertex array were created
+    bool valid() const;
+
+    // Uploads a polyline, returns its id or -1
+    int create(const polyline_point* points, size_t count, const polyline_style& style = polyline_style());
+
+    // Adds points at the end of a polyline, returns false if the buffer could not grow
+    bool append(int polyline, const polyline_point* points, size_t count);
+
+    void setStyle(int polyline, const polyline_style& style);
+
+    void remove(int polyline);
+
+    size_t pointCount(int polyline) const;
+
+    // Transform from the point positions to the space of the Viewport block, identity by default
+    void setTransform(const glm::mat4& transform);
+
+    // Draws every polyline with one call each
+    void draw();
+
+    polyline_stats stats() const;
+
+private:
+    struct polyline {
+        int allocation = -1;
+        size_t count = 0;
+        size_t capacity = 0;
+        polyline_style style;
+        bool used = false;
+    };
+
+    // Function to get the linked program, the first call waits for it and looks up the uniforms
+    unsigned int program();
+
+    // Function to point the instance attributes at the first segment of a range
+    void bindSegments(const buffer_range& range);
+
+    // Function to write points and the spare point after them, starting at index first of the range
+    void writePoints(const polyline& line, size_t first, const polyline_point* points, size_t count);
+
+    // Submitted by the constructor, linked by the first draw
+    queued_program shaderProgram;
+    bool programReady = false;
+    unsigned int VAO = 0;
+    uniform_handle<glm::mat4> transformUniform;
+    uniform_handle<int> segmentCountUniform;
+    uniform_handle<int> joinUniform;
+    uniform_handle<int> capUniform;
+    uniform_handle<float> miterLimitUniform;
+
+    glm::mat4 transform = glm::mat4(1.0f);
+    std::unique_ptr<buffer_allocator> storage;
+    std::vector<polyline> polylines;
+    polyline_stats totals;
+};
+
+#endif // OPENGL_TASKS_POLYLINE_RENDERER_H
@@ -0,0 +1,283 @@
+#include "common/procedural_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const double pi = 3.14159265358979323846;
+
+int segmentsForRadius(float radiusPixels, float maxErrorPixels) {
+    if (radiusPixels <= maxErrorPixels) {
+        return minProceduralSegments;
+    }
+
+    // A chord over the angle 2 * pi / n stays radius * (1 - cos(pi / n)) away from the arc
+    double halfAngle = std::acos(1.0 - static_cast<double>(maxErrorPixels) / radiusPixels);
+    int segments = static_cast<int>(std::ceil(pi / halfAngle));
+    segments = (segments + 3) / 4 * 4;
+    return std::clamp(segments, minProceduralSegments, maxProceduralSegments);
+}
+
+float projectedRadius(float radius, float distance, float fovY, int viewportHeight) {
+    if (distance <= 0.0f) {
+        return static_cast<float>(viewportHeight);
+    }
+    return radius / (distance * std::tan(0.5f * fovY)) * 0.5f * static_cast<float>(viewportHeight);
+}
+
+// Function to sample the unit circle at segments evenly spaced angles, counter-clockwise from +x
+static std::vector<glm::vec2> unitCircle(int segments) {
+    std::vector<glm::vec2> points(segments);
+
+    // Rotate the previous point, the recurrence runs in double so the last point hasn't drifted
+    double angle = 2.0 * pi / segments;
+    double c = std::cos(angle), s = std::sin(angle);
+    double x = 1.0, y = 0.0;
+    for (int i = 0; i < segments; ++i) {
+        points[i] = glm::vec2(static_cast<float>(x), static_cast<float>(y));
+        double nextX = x * c - y * s;
+        y = x * s + y * c;
+        x = nextX;
+    }
+    return points;
+}
+
+// Point of a profile that is rotated around the y axis
+struct profile_point {
+    float radius, y;
+    float normalRadius, normalY;
+};
+
+// Function to rotate profile strips around the y axis, rows of a strip are joined into quads.
+// A strip goes upwards along the outside of the surface so its triangles face outwards.
+static void lathe(const std::vector<std::vector<profile_point>>& strips, bool closed,
+                  const std::vector<glm::vec2>& around, procedural_mesh& mesh) {
+    uint32_t count = static_cast<uint32_t>(around.size());
+    for (const std::vector<profile_point>& strip : strips) {
+        uint32_t first = static_cast<uint32_t>(mesh.positions.size());
+        for (const profile_point& point : strip) {
+            for (const glm::vec2& direction : around) {
+                mesh.positions.push_back(glm::vec3(point.radius * direction.x, point.y, point.radius * direction.y));
+                mesh.normals.push_back(glm::normalize(
+                    glm::vec3(point.normalRadius * direction.x, point.normalY, point.normalRadius * direction.y)));
+            }
+        }
+
+        size_t rows = strip.size();
+        size_t quads = closed ? rows : rows - 1;
+        for (size_t row = 0; row < quads; ++row) {
+            size_t next = (row + 1) % rows;
+            uint32_t a = first + static_cast<uint32_t>(row) * count;
+            uint32_t b = first + static_cast<uint32_t>(next) * count;
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t j = (i + 1) % count;
+
+                // At a pole one row collapses to a point and one triangle of the quad has no area
+                if (strip[next].radius > 0.0f) {
+                    mesh.indices.insert(mesh.indices.end(), {a + i, b + i, b + j});
+                }
+                if (strip[row].radius > 0.0f) {
+                    mesh.indices.insert(mesh.indices.end(), {a + i, b + j, a + j});
+                }
+            }
+        }
+    }
+}
+
+// Function to add the triangles of a fan around vertex center over the rim vertices from first to first + count
+static void fan(uint32_t center, uint32_t first, uint32_t count, procedural_mesh& mesh) {
+    for (uint32_t i = 0; i < count; ++i) {
+        mesh.indices.insert(mesh.indices.end(), {center, first + i, first + (i + 1) % count});
+    }
+}
+
+// Function to return the radius of the whole shape, used to scale its size on screen
+static float boundingRadius(procedural_shape shape, const procedural_params& params) {
+    switch (shape) {
+    case procedural_shape::ring:
+        return params.b;
+    case procedural_shape::rounded_rect:
+        return 0.5f * std::sqrt(params.a * params.a + params.b * params.b);
+    case procedural_shape::cylinder:
+        return std::max(params.a, 0.5f * params.b);
+    case procedural_shape::torus:
+        return params.a + params.b;
+    case procedural_shape::capsule:
+        return params.a + 0.5f * params.b;
+    default:
+        return params.a;
+    }
+}
+
+// Function to return the radius of the circle the segment count is for
+static float mainRadius(procedural_shape shape, const procedural_params& params) {
+    switch (shape) {
+    case procedural_shape::ring:
+        return params.b;
+    case procedural_shape::rounded_rect:
+        return params.c;
+    case procedural_shape::torus:
+        return params.a + params.b;
+    default:
+        return params.a;
+    }
+}
+
+procedural_mesh generateMesh(procedural_shape shape, const procedural_params& params, int segments) {
+    procedural_mesh mesh;
+    segments = std::clamp((segments + 3) / 4 * 4, minProceduralSegments, maxProceduralSegments);
+    mesh.segments = segments;
+
+    std::vector<glm::vec2> circle = unitCircle(segments);
+    uint32_t count = static_cast<uint32_t>(segments);
+    const glm::vec3 up(0.0f, 0.0f, 1.0f);
+
+    switch (shape) {
+    case procedural_shape::circle:
+        for (const glm::vec2& point : circle) {
+            mesh.positions.push_back(glm::vec3(params.a * point, 0.0f));
+            mesh.normals.push_back(up);
+        }
+        break;
+
+    case procedural_shape::disc:
+        mesh.positions.push_back(glm::vec3(0.0f));
+        for (const glm::vec2& point : circle) {
+            mesh.positions.push_back(glm::vec3(params.a * point, 0.0f));
+        }
+        mesh.normals.assign(mesh.positions.size(), up);
+        fan(0, 1, count, mesh);
+        break;
+
+    case procedural_shape::ring:
+        for (const glm::vec2& point : circle) {
+            mesh.positions.push_back(glm::vec3(params.a * point, 0.0f));
+            mesh.positions.push_back(glm::vec3(params.b * point, 0.0f));
+        }
+        mesh.normals.assign(mesh.positions.size(), up);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t inner = 2 * i, next = 2 * ((i + 1) % count);
+            mesh.indices.insert(mesh.indices.end(), {inner, inner + 1, next + 1, inner, next + 1, next});
+        }
+        break;
+
+    case procedural_shape::rounded_rect: {
+        // Each corner is a quarter of the circle, the straight edges join the ends of neighbouring corners
+        float corner = std::clamp(params.c, 0.0f, 0.5f * std::min(params.a, params.b));
+        glm::vec2 inner(0.5f * params.a - corner, 0.5f * params.b - corner);
+        const glm::vec2 quadrants[4] = {{1.0f, 1.0f}, {-1.0f, 1.0f}, {-1.0f, -1.0f}, {1.0f, -1.0f}};
+        int quarter = segments / 4;
+
+        mesh.positions.push_back(glm::vec3(0.0f));
+        for (int k = 0; k < 4; ++k) {
+            for (int j = 0; j <= quarter; ++j) {
+                glm::vec2 point = circle[(k * quarter + j) % segments];
+                mesh.positions.push_back(glm::vec3(quadrants[k] * inner + corner * point, 0.0f));
+            }
+        }
+        mesh.normals.assign(mesh.positions.size(), up);
+        fan(0, 1, static_cast<uint32_t>(4 * (quarter + 1)), mesh);
+        break;
+    }
+
+    case procedural_shape::sphere:
+    case procedural_shape::capsule: {
+        // Meridian from the south to the north pole, the capsule splits it at the equator
+        int rings = segments / 2;
+        float half = shape == procedural_shape::capsule ? 0.5f * params.b : 0.0f;
+        std::vector<profile_point> meridian;
+        for (int k = 0; k <= rings; ++k) {
+            glm::vec2 point = circle[k % segments];
+            float sine = k == 0 || k == rings ? 0.0f : point.y;
+            float cosine = -point.x;
+            float offset = 2 * k < rings ? -half : half;
+            meridian.push_back({params.a * sine, params.a * cosine + offset, sine, cosine});
+            if (half > 0.0f && 2 * k == rings) {
+                meridian.back().y = -half;
+                meridian.push_back({params.a, half, 1.0f, 0.0f});
+            }
+        }
+        lathe({meridian}, false, circle, mesh);
+        break;
+    }
+
+    case procedural_shape::cylinder: {
+        float half = 0.5f * params.b;
+        lathe({{{0.0f, -half, 0.0f, -1.0f}, {params.a, -half, 0.0f, -1.0f}},
+               {{params.a, -half, 1.0f, 0.0f}, {params.a, half, 1.0f, 0.0f}},
+               {{params.a, half, 0.0f, 1.0f}, {0.0f, half, 0.0f, 1.0f}}},
+              false, circle, mesh);
+        break;
+    }
+
+    case procedural_shape::torus: {
+        // The chord error grows with the square root of the radius, so the tube needs fewer segments
+        int tubeSegments = static_cast<int>(std::ceil(segments * std::sqrt(params.b / (params.a + params.b))));
+        tubeSegments = std::clamp((tubeSegments + 3) / 4 * 4, minProceduralSegments, maxProceduralSegments);
+        std::vector<glm::vec2> tube = unitCircle(tubeSegments);
+
+        std::vector<profile_point> section;
+        for (const glm::vec2& point : tube) {
+            section.push_back({params.a + params.b * point.x, params.b * point.y, point.x, point.y});
+        }
+        lathe({section}, true, circle, mesh);
+        break;
+    }
+    }
+
+    return mesh;
+}
+
+bool procedural_mesh_cache::key::operator==(const key& other) const {
+    return shape == other.shape && segments == other.segments && params.a == other.params.a &&
+           params.b == other.params.b && params.c == other.params.c;
+}
+
+size_t procedural_mesh_cache::key_hash::operator()(const key& value) const {
+    // FNV-1a over the fields
+    uint32_t words[5] = {static_cast<uint32_t>(value.shape), static_cast<uint32_t>(value.segments)};
+    std::memcpy(&words[2], &value.params.a, sizeof(float));
+    std::memcpy(&words[3], &value.params.b, sizeof(float));
+    std::memcpy(&words[4], &value.params.c, sizeof(float));
+
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t word : words) {
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+const procedural_mesh& procedural_mesh_cache::get(procedural_shape shape, const procedural_params& params,
+                                                  float radiusPixels, float maxErrorPixels) {
+    float bounds = boundingRadius(shape, params);
+    float pixelsPerUnit = bounds > 0.0f ? radiusPixels / bounds : 0.0f;
+    return getSegments(shape, params, segmentsForRadius(mainRadius(shape, params) * pixelsPerUnit, maxErrorPixels));
+}
+
+const procedural_mesh& procedural_mesh_cache::getSegments(procedural_shape shape, const procedural_params& params,
+                                                          int segments) {
+    key lookup{shape, params, std::clamp((segments + 3) / 4 * 4, minProceduralSegments, maxProceduralSegments)};
+    auto it = meshes.find(lookup);
+    if (it != meshes.end()) {
+        cacheHits++;
+        return it->second;
+    }
+    cacheMisses++;
+    return meshes.emplace(lookup, generateMesh(shape, params, lookup.segments)).first->second;
+}
+
+void procedural_mesh_cache::clear() {
+    meshes.clear();
+}
+
+size_t procedural_mesh_cache::size() const {
+    return meshes.size();
+}
+
+long procedural_mesh_cache::hits() const {
+    return cacheHits;
+}
+
+long procedural_mesh_cache::misses() const {
+    return cacheMisses;
+}
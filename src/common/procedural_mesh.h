@@ -0,0 +1,97 @@
+// Procedural meshes with a level of detail picked from their size on screen.
+//
+// Circles, discs, rings and rounded rectangles lie in the xy plane around
+// the origin, spheres, cylinders, tori and capsules are centered on it with
+// their axis along y. Every curve is sampled with as many segments as keep
+// the distance between the true curve and its chords below maxErrorPixels
+// at the given radius on screen, rounded up to a multiple of 4 so nearby
+// sizes share a mesh.
+//
+// The points on a circle come from rotating the previous point by a fixed
+// angle, so a mesh costs one sin/cos pair per distinct segment count
+// instead of one per vertex. procedural_mesh_cache keeps every generated
+// mesh keyed by shape, parameters and segment count, and returns the same
+// mesh for repeated requests.
+
+#ifndef OPENGL_TASKS_PROCEDURAL_MESH_H
+#define OPENGL_TASKS_PROCEDURAL_MESH_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+enum class procedural_shape {
+    circle,       // outline, radius = a, draw the positions as GL_LINE_LOOP
+    disc,         // radius = a
+    ring,         // inner radius = a, outer radius = b
+    rounded_rect, // width = a, height = b, corner radius = c
+    sphere,       // radius = a
+    cylinder,     // radius = a, height = b, with caps
+    torus,        // distance from the center to the tube = a, tube radius = b
+    capsule       // radius = a, height of the straight part = b
+};
+
+// Sizes of a shape, see procedural_shape for what each one means
+struct procedural_params {
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+};
+
+// Generated geometry, indices are triangles except for circle outlines which have none
+struct procedural_mesh {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> indices;
+    int segments = 0;
+};
+
+// Range of segment counts of a full circle
+static const int minProceduralSegments = 8;
+static const int maxProceduralSegments = 512;
+
+// Function to pick the segments of a full circle of the given radius in pixels
+int segmentsForRadius(float radiusPixels, float maxErrorPixels = 0.5f);
+
+// Function to project a radius at the given distance from a perspective camera to pixels
+float projectedRadius(float radius, float distance, float fovY, int viewportHeight);
+
+// Function to generate a shape with the given number of segments around its main circle
+procedural_mesh generateMesh(procedural_shape shape, const procedural_params& params, int segments);
+
+// Generated meshes, each one is built once and kept until clear()
+class procedural_mesh_cache {
+public:
+    // Returns the mesh of a shape whose largest radius covers radiusPixels on screen
+    const procedural_mesh& get(procedural_shape shape, const procedural_params& params, float radiusPixels,
+                               float maxErrorPixels = 0.5f);
+
+    // Returns the mesh of a shape with a fixed segment count
+    const procedural_mesh& getSegments(procedural_shape shape, const procedural_params& params, int segments);
+
+    void clear();
+
+    size_t size() const;
+    long hits() const;
+    long misses() const;
+
+private:
+    struct key {
+        procedural_shape shape;
+        procedural_params params;
+        int segments;
+
+        bool operator==(const key& other) const;
+    };
+
+    struct key_hash {
+        size_t operator()(const key& value) const;
+    };
+
+    std::unordered_map<key, procedural_mesh, key_hash> meshes;
+    long cacheHits = 0;
+    long cacheMisses = 0;
+};
+
+#endif // OPENGL_TASKS_PROCEDURAL_MESH_H
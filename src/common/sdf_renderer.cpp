@@ -0,0 +1,192 @@
+#include "common/sdf_renderer.h"
+
+#include "common/viewport.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// The four corners of the quad come from gl_VertexID, so there is no vertex buffer, only instances.
+// Local is the position relative to the center of the shape, x along the segment and y across it.
+static const char* vertexShaderSource = R"(
+    layout (location = 0) in vec2 aFrom;
+    layout (location = 1) in vec2 aTo;
+    layout (location = 2) in vec2 aSize;
+    layout (location = 3) in vec4 aColor;
+    layout (location = 4) in uint aKind;
+    out vec2 Local;
+    flat out vec4 Shape;
+    out vec4 Color;
+    void main() {
+        vec2 axis = aTo - aFrom;
+        float len = length(axis);
+        vec2 direction = len > 0.0 ? axis / len : vec2(1.0, 0.0);
+        vec2 normal = vec2(-direction.y, direction.x);
+
+        // Half of the size across the segment, plus one and a half pixels for the anti-aliased edge
+        float extent = aSize.x + (aKind == 1u ? 0.5 * aSize.y : 0.0);
+        float margin = 3.0 * viewport.size.z;
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+        Local = corner * vec2(0.5 * len + extent + margin, extent + margin);
+
+        vec2 position = 0.5 * (aFrom + aTo) + direction * Local.x + normal * Local.y;
+        gl_Position = viewport.projection * vec4(position, 0.0, 1.0);
+        Shape = vec4(0.5 * len, aSize, float(aKind));
+        Color = aColor;
+    }
+)";
+
+// Signed distances are negative inside the shape, fwidth turns them into pixels
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec2 Local;
+    flat in vec4 Shape;
+    in vec4 Color;
+    out vec4 FragColor;
+    void main() {
+        float halfLength = Shape.x, radius = Shape.y, thickness = Shape.z;
+        int kind = int(Shape.w);
+
+        float distance;
+        if (kind == 0) {
+            distance = length(Local) - radius;
+        } else if (kind == 1) {
+            distance = abs(length(Local) - radius) - 0.5 * thickness;
+        } else if (kind == 2) {
+            distance = length(vec2(max(abs(Local.x) - halfLength, 0.0), Local.y)) - radius;
+        } else {
+            vec2 q = abs(Local) - vec2(halfLength, radius);
+            distance = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+        }
+
+        float coverage = clamp(0.5 - distance / max(fwidth(distance), 1e-6), 0.0, 1.0);
+        FragColor = vec4(Color.rgb, Color.a * coverage);
+    }
+)";
+
+sdf_renderer::sdf_renderer(size_t maxInstances) : maxInstances(maxInstances) {
+    // The vertex shader starts with the declaration of the Viewport block
+    std::string vertexShader = std::string("#version 330 core\n") + viewportBlockSource + vertexShaderSource;
+    shaderProgram = queued_program(vertexShader.c_str(), fragmentShaderSource);
+
+    // Every attribute advances once per instance, the pointers are set by bindInstances
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    for (GLuint location = 0; location < 5; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(0);
+
+    // Room for one full draw per frame in flight
+    instanceStream = std::make_unique<stream_buffer>(GL_ARRAY_BUFFER, maxInstances * sizeof(sdf_instance));
+    instances.reserve(maxInstances);
+}
+
+sdf_renderer::~sdf_renderer() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(shaderProgram.get());
+}
+
+bool sdf_renderer::valid() const {
+    return shaderProgram.submitted() && VAO != 0;
+}
+
+unsigned int sdf_renderer::program() {
+    // The block binding needs the linked program, the first flush waits for it
+    unsigned int linked = shaderProgram.get();
+    if (!programReady && linked != 0) {
+        programReady = true;
+        bindViewportBlock(linked);
+    }
+    return linked;
+}
+
+void sdf_renderer::add(const sdf_instance& instance) {
+    if (instances.size() == maxInstances) {
+        flush();
+    }
+    instances.push_back(instance);
+}
+
+void sdf_renderer::addCircle(glm::vec2 center, float radius, uint32_t color) {
+    add({center, center, radius, 0.0f, color, sdf_kind::circle});
+}
+
+void sdf_renderer::addRing(glm::vec2 center, float radius, float thickness, uint32_t color) {
+    add({center, center, radius, thickness, color, sdf_kind::ring});
+}
+
+void sdf_renderer::addCapsule(glm::vec2 from, glm::vec2 to, float radius, uint32_t color) {
+    add({from, to, radius, 0.0f, color, sdf_kind::capsule});
+}
+
+void sdf_renderer::addLine(glm::vec2 from, glm::vec2 to, float width, uint32_t color) {
+    add({from, to, 0.5f * width, 0.0f, color, sdf_kind::line});
+}
+
+void sdf_renderer::bindInstances(size_t offset) {
+    // Instanced draws without a base instance always start at instance 0, so the attributes move instead
+    glBindBuffer(GL_ARRAY_BUFFER, instanceStream->buffer());
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(sdf_instance), (void*)(offset + offsetof(sdf_instance, from)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(sdf_instance), (void*)(offset + offsetof(sdf_instance, to)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(sdf_instance),
+                          (void*)(offset + offsetof(sdf_instance, radius)));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(sdf_instance),
+                          (void*)(offset + offsetof(sdf_instance, color)));
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(sdf_instance), (void*)(offset + offsetof(sdf_instance, kind)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void sdf_renderer::flush() {
+    if (instances.empty()) {
+        return;
+    }
+
+    size_t size = instances.size() * sizeof(sdf_instance);
+    stream_allocation allocation = instanceStream->allocate(size, sizeof(sdf_instance));
+
+    // The region of this frame is full, move on to the next one
+    if (!allocation.data) {
+        instanceStream->endFrame();
+        allocation = instanceStream->allocate(size, sizeof(sdf_instance));
+    }
+    if (!allocation.data) {
+        std::cerr << "The SDF instance stream has no room for " << instances.size() << " instances" << std::endl;
+        instances.clear();
+        return;
+    }
+
+    std::memcpy(allocation.data, instances.data(), size);
+    instanceStream->commit();
+
+    glUseProgram(program());
+    glBindVertexArray(VAO);
+    bindInstances(allocation.offset);
+
+    // Coverage goes into alpha, blending is turned off again so other draws are not affected
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+    glDisable(GL_BLEND);
+    glBindVertexArray(0);
+
+    draws++;
+    drawn += static_cast<long>(instances.size());
+    instances.clear();
+}
+
+void sdf_renderer::endFrame() {
+    instanceStream->endFrame();
+}
+
+long sdf_renderer::drawCalls() const {
+    return draws;
+}
+
+long sdf_renderer::primitives() const {
+    return drawn;
+}
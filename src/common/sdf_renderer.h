@@ -0,0 +1,89 @@
+// Analytic circles, rings, capsules and thick lines.
+//
+// Every primitive is one instance of a quad that covers it with one and a
+// half pixels of margin. The fragment shader evaluates the signed distance
+// to the exact shape and turns it into coverage over one pixel (fwidth of
+// the distance), which fits inside that margin, so edges stay smooth at any
+// size and zoom while each primitive costs four vertices. Line widths are not limited by glLineWidth, which core
+// profiles clamp to 1.
+//
+// Coordinates are in the space of the Viewport block (viewport.h): x spans
+// [-1, 1] across the window and shapes stay round at any aspect ratio.
+// Colors are RGBA8 as returned by packColor() and are blended with alpha.
+// Instances are appended on the CPU and streamed by flush() through a
+// stream_buffer, one glDrawArraysInstanced call per flush.
+
+#ifndef OPENGL_TASKS_SDF_RENDERER_H
+#define OPENGL_TASKS_SDF_RENDERER_H
+
+#include "common/shader.h"
+#include "common/stream_buffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class sdf_kind : uint32_t { circle, ring, capsule, line };
+
+// Per-instance attributes, matching the layout of the SDF vertex shader
+struct sdf_instance {
+    glm::vec2 from;   // center, or the first end of a segment
+    glm::vec2 to;     // second end of a segment, equal to from for circles and rings
+    float radius;     // radius of circles, rings and capsules, half the width of lines
+    float thickness;  // stroke width of rings
+    uint32_t color;
+    sdf_kind kind;
+};
+
+class sdf_renderer {
+public:
+    explicit sdf_renderer(size_t maxInstances = 1 << 17);
+    ~sdf_renderer();
+
+    sdf_renderer(const sdf_renderer&) = delete;
+    sdf_renderer& operator=(const sdf_renderer&) = delete;
+
+    // True if the program and the vertex array were created
+    bool valid() const;
+
+    void addCircle(glm::vec2 center, float radius, uint32_t color);
+    void addRing(glm::vec2 center, float radius, float thickness, uint32_t color);
+    void addCapsule(glm::vec2 from, glm::vec2 to, float radius, uint32_t color);
+
+    // Straight line with square ends, from and to are the centers of the ends
+    void addLine(glm::vec2 from, glm::vec2 to, float width, uint32_t color);
+
+    // Draws everything added since the last flush
+    void flush();
+
+    // Closes the frame of the instance stream, call it once per frame after the last flush
+    void endFrame();
+
+    // Number of draw calls and of primitives drawn since the renderer was created
+    long drawCalls() const;
+    long primitives() const;
+
+private:
+    void add(const sdf_instance& instance);
+
+    // Function to get the linked program, the first call waits for it and binds the Viewport block
+    unsigned int program();
+
+    // Function to point the instance attributes at the given offset of the stream buffer
+    void bindInstances(size_t offset);
+
+    // Submitted by the constructor, linked by the first draw
+    queued_program shaderProgram;
+    bool programReady = false;
+    unsigned int VAO = 0;
+    size_t maxInstances;
+    std::vector<sdf_instance> instances;
+    std::unique_ptr<stream_buffer> instanceStream;
+    long draws = 0;
+    long drawn = 0;
+};
+
+#endif // OPENGL_TASKS_SDF_RENDERER_H
@@ -0,0 +1,412 @@
+#include "common/shader.h"
+
+#include "common/window.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Header of a cached program binary file
+struct program_binary_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+};
+
+static const uint32_t programBinaryVersion = 1;
+
+// GL_KHR_parallel_shader_compile is not part of the generated loader
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+typedef void (APIENTRYP max_shader_compiler_threads_proc)(GLuint count);
+
+typedef std::chrono::steady_clock shader_clock;
+
+shader_cache_options& shaderCacheOptions() {
+    static shader_cache_options options;
+    return options;
+}
+
+// 64-bit FNV-1a hash, chained over several strings
+static uint64_t hashString(const char* text, uint64_t hash = 14695981039346656037ull) {
+    // Hash the terminator too, so ("ab", "c") and ("a", "bc") differ
+    do {
+        hash ^= static_cast<unsigned char>(*text);
+        hash *= 1099511628211ull;
+    } while (*text++);
+    return hash;
+}
+
+static const char* glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+// Function to compute the cache key of a program
+static uint64_t programKey(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines) {
+    uint64_t hash = hashString(vertexShaderSource);
+    hash = hashString(fragmentShaderSource, hash);
+    hash = hashString(defines, hash);
+    hash = hashString(glString(GL_VENDOR), hash);
+    hash = hashString(glString(GL_RENDERER), hash);
+    hash = hashString(glString(GL_VERSION), hash);
+    return hash;
+}
+
+static std::string cachePath(uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return shaderCacheOptions().directory + "/" + name;
+}
+
+// Program binaries need OpenGL 4.1 (or ARB_get_program_binary) and at least one binary format
+static bool programBinariesSupported() {
+    if (!shaderCacheOptions().enabled || !GLAD_GL_VERSION_4_1) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+// Function to load a cached program, returns 0 if there is no usable binary
+static unsigned int loadProgramBinary(uint64_t key) {
+    std::ifstream file(cachePath(key), std::ios::binary | std::ios::ate);
+    if (!file) {
+        return 0;
+    }
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    // The binary fills the rest of the file, a larger length comes from a damaged file
+    program_binary_header header;
+    if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::string(header.magic, 4) != "GLPB" || header.version != programBinaryVersion || header.key != key ||
+        header.binaryLength == 0 || header.binaryLength != fileSize - sizeof(header)) {
+        return 0;
+    }
+
+    std::vector<char> binary(header.binaryLength);
+    if (!file.read(binary.data(), binary.size())) {
+        return 0;
+    }
+
+    unsigned int shaderProgram = glCreateProgram();
+    glProgramBinary(shaderProgram, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // The driver rejects binaries from other driver builds, compile in that case
+    int success;
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(shaderProgram);
+        std::remove(cachePath(key).c_str());
+        return 0;
+    }
+
+    return shaderProgram;
+}
+
+// Function to store a linked program in the cache
+static void saveProgramBinary(unsigned int shaderProgram, uint64_t key) {
+    GLint length = 0;
+    glGetProgramiv(shaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(shaderProgram, length, &length, &binaryFormat, binary.data());
+
+    program_binary_header header = {{'G', 'L', 'P', 'B'}, programBinaryVersion, key, binaryFormat, static_cast<uint32_t>(length)};
+
+    // Write to a temporary file first, so a crash never leaves a truncated binary behind
+    std::string path = cachePath(key);
+    std::string temporaryPath = path + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(shaderCacheOptions().directory, error);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        if (!file) {
+            std::cerr << "Failed to write the shader cache file " << temporaryPath << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            std::cerr << "Failed to write the shader cache file " << temporaryPath << std::endl;
+            return;
+        }
+    }
+
+    // Replaces the old file in one step, readers see either the old binary or the new one
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::cerr << "Failed to replace the shader cache file " << path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+// Function to insert the defines after the #version line of a shader
+static std::string applyDefines(const char* source, const char* defines) {
+    std::string text = source;
+    if (!defines || !*defines) {
+        return text;
+    }
+
+    size_t version = text.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : text.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return std::string(defines) + "\n" + text;
+    }
+    return text.insert(lineEnd + 1, std::string(defines) + "\n");
+}
+
+// Function to create a shader and start compiling it, the status is checked later
+static unsigned int compileShader(GLenum type, const std::string& text) {
+    const char* source = text.c_str();
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+// Function to print the info log of a shader that failed to compile
+static void checkShader(unsigned int shader, const char* label) {
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << label << " shader compilation failed:\n" << infoLog << std::endl;
+    }
+}
+
+// Totals of all programs built since the last report
+struct shader_build_totals {
+    long programs = 0;
+    long cached = 0;
+    double submitMs = 0.0;
+    double waitMs = 0.0;
+    bool parallel = false;
+};
+
+static shader_build_totals totals;
+
+static double millisecondsSince(shader_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(shader_clock::now() - start).count();
+}
+
+shader_build_queue::shader_build_queue() {
+    // Both extensions share the enums, only the function name differs. hasExtension() reads the
+    // extension list once per context, and there is one queue per context (sharedShaderQueue())
+    max_shader_compiler_threads_proc maxShaderCompilerThreads = nullptr;
+    if (hasExtension("GL_KHR_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<max_shader_compiler_threads_proc>(getProcAddress("glMaxShaderCompilerThreadsKHR"));
+    } else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<max_shader_compiler_threads_proc>(getProcAddress("glMaxShaderCompilerThreadsARB"));
+    }
+
+    if (maxShaderCompilerThreads) {
+        // Let the driver pick the number of threads
+        maxShaderCompilerThreads(0xFFFFFFFFu);
+        parallelCompile = true;
+    }
+}
+
+shader_build_queue::~shader_build_queue() {
+    for (pending_program& pending : programs) {
+        if (pending.vertexShader) {
+            glDeleteShader(pending.vertexShader);
+        }
+        if (pending.fragmentShader) {
+            glDeleteShader(pending.fragmentShader);
+        }
+    }
+}
+
+int shader_build_queue::submit(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines) {
+    auto start = shader_clock::now();
+
+    pending_program pending;
+    pending.cacheable = programBinariesSupported();
+
+    if (pending.cacheable) {
+        pending.key = programKey(vertexShaderSource, fragmentShaderSource, defines);
+        pending.program = loadProgramBinary(pending.key);
+        pending.cached = pending.program != 0;
+    }
+
+    if (!pending.cached) {
+        // No status queries here, any of them would wait for the compiler
+        pending.vertexShader = compileShader(GL_VERTEX_SHADER, applyDefines(vertexShaderSource, defines));
+        pending.fragmentShader = compileShader(GL_FRAGMENT_SHADER, applyDefines(fragmentShaderSource, defines));
+
+        pending.program = glCreateProgram();
+        glAttachShader(pending.program, pending.vertexShader);
+        glAttachShader(pending.program, pending.fragmentShader);
+
+        // Ask the driver to keep the binary around for glGetProgramBinary
+        if (pending.cacheable) {
+            glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        glLinkProgram(pending.program);
+    }
+
+    programs.push_back(pending);
+
+    double elapsed = millisecondsSince(start);
+    submitMs += elapsed;
+    totals.submitMs += elapsed;
+    totals.programs++;
+    totals.cached += pending.cached ? 1 : 0;
+    totals.parallel = totals.parallel || parallelCompile;
+
+    return static_cast<int>(programs.size() - 1);
+}
+
+bool shader_build_queue::ready(int handle) const {
+    const pending_program& pending = programs[handle];
+    if (pending.checked || !parallelCompile) {
+        return true;
+    }
+
+    int completed = GL_FALSE;
+    glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+unsigned int shader_build_queue::program(int handle) {
+    pending_program& pending = programs[handle];
+    if (pending.checked) {
+        return pending.program;
+    }
+    pending.checked = true;
+
+    if (pending.cached) {
+        return pending.program;
+    }
+
+    // The first status query waits for the compile and link of this program only
+    auto start = shader_clock::now();
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &success);
+    if (!success) {
+        checkShader(pending.vertexShader, "Vertex");
+        checkShader(pending.fragmentShader, "Fragment");
+        glGetProgramInfoLog(pending.program, 512, NULL, infoLog);
+        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
+    } else if (pending.cacheable) {
+        saveProgramBinary(pending.program, pending.key);
+    }
+
+    double elapsed = millisecondsSince(start);
+    waitMs += elapsed;
+    totals.waitMs += elapsed;
+
+    // Delete the shaders as they're linked into our program now and no longer necessary
+    glDeleteShader(pending.vertexShader);
+    glDeleteShader(pending.fragmentShader);
+    pending.vertexShader = 0;
+    pending.fragmentShader = 0;
+
+    return pending.program;
+}
+
+bool shader_build_queue::linked(int handle) {
+    int success = GL_FALSE;
+    glGetProgramiv(program(handle), GL_LINK_STATUS, &success);
+    return success == GL_TRUE;
+}
+
+void shader_build_queue::finish() {
+    for (size_t i = 0; i < programs.size(); ++i) {
+        program(static_cast<int>(i));
+    }
+}
+
+bool shader_build_queue::parallel() const {
+    return parallelCompile;
+}
+
+void shader_build_queue::report() const {
+    std::cout << "Shader build queue: " << programs.size() << " programs, submit " << submitMs
+              << " ms, wait " << waitMs << " ms" << (parallelCompile ? " (parallel compile)" : "") << std::endl;
+}
+
+// Queue of the current context, the generation tells handles of an earlier context apart
+static std::unique_ptr<shader_build_queue> sharedQueue;
+static long sharedQueueGeneration = 1;
+
+shader_build_queue& sharedShaderQueue() {
+    if (!sharedQueue) {
+        sharedQueue.reset(new shader_build_queue());
+    }
+    return *sharedQueue;
+}
+
+void releaseSharedShaderQueue() {
+    sharedQueue.reset();
+    sharedQueueGeneration++;
+}
+
+queued_program::queued_program(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines)
+    : handle(sharedShaderQueue().submit(vertexShaderSource, fragmentShaderSource, defines)),
+      queueGeneration(sharedQueueGeneration) {}
+
+bool queued_program::submitted() const {
+    return handle >= 0;
+}
+
+// True while the queue the program was submitted to is still alive
+static bool queueAlive(int handle, long generation) {
+    return handle >= 0 && generation == sharedQueueGeneration && sharedQueue;
+}
+
+bool queued_program::ready() const {
+    return program != 0 || !queueAlive(handle, queueGeneration) || sharedQueue->ready(handle);
+}
+
+unsigned int queued_program::get() {
+    if (program == 0 && queueAlive(handle, queueGeneration)) {
+        program = sharedQueue->program(handle);
+    }
+    return program;
+}
+
+bool queued_program::linked() {
+    int success = GL_FALSE;
+    if (get() != 0) {
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+    }
+    return success == GL_TRUE;
+}
+
+unsigned int initializeShaders(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines) {
+    shader_build_queue& queue = sharedShaderQueue();
+    return queue.program(queue.submit(vertexShaderSource, fragmentShaderSource, defines));
+}
+
+void reportShaderBuildTime() {
+    if (totals.programs == 0) {
+        return;
+    }
+
+    std::cout << "Built " << totals.programs << " shader programs (" << totals.cached << " from the cache) in "
+              << totals.submitMs + totals.waitMs << " ms, submit " << totals.submitMs << " ms, wait "
+              << totals.waitMs << " ms" << (totals.parallel ? ", parallel compile" : "") << std::endl;
+    totals = shader_build_totals();
+}
@@ -0,0 +1,124 @@
+// Shader compilation shared by the tasks.
+//
+// initializeShaders() compiles and links a vertex and a fragment shader. When
+// the driver supports program binaries, linked programs are stored in an
+// on-disk cache keyed by a hash of the sources, the defines and the driver
+// vendor/renderer/version strings, and later launches load them with
+// glProgramBinary instead of compiling. Any mismatch or load failure falls
+// back to compiling from source.
+//
+// shader_build_queue submits the compiles and links of many programs up front
+// and only checks their status when a program is first needed, so the
+// driver can compile them in parallel (GL_KHR_parallel_shader_compile).
+// The tasks and renderers share one queue per context through
+// queued_program: they create their programs before setting up buffers and
+// textures, and the first get() of each program waits for its link.
+
+#ifndef OPENGL_TASKS_SHADER_H
+#define OPENGL_TASKS_SHADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct shader_cache_options {
+    bool enabled = true;
+
+    // Directory holding one file per cached program
+    std::string directory = "shader_cache";
+};
+
+// Global options for the program binary cache
+shader_cache_options& shaderCacheOptions();
+
+// Compiles and links programs without waiting for the driver until they are used
+class shader_build_queue {
+public:
+    // Enables the parallel shader compile extension when the driver has it
+    shader_build_queue();
+
+    // Deletes the shader objects of programs that were never used, not the programs
+    ~shader_build_queue();
+
+    shader_build_queue(const shader_build_queue&) = delete;
+    shader_build_queue& operator=(const shader_build_queue&) = delete;
+
+    // Issues the compile and link of a program (or loads it from the cache), returns its handle
+    int submit(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines = "");
+
+    // True when the program can be used without blocking (always true without the extension)
+    bool ready(int handle) const;
+
+    // Returns the linked program, checking and reporting its status on first use
+    unsigned int program(int handle);
+
+    // True if the program linked, waits for it like program()
+    bool linked(int handle);
+
+    // Checks all programs that were not used yet
+    void finish();
+
+    // True when the driver compiles in parallel
+    bool parallel() const;
+
+    // Prints the number of programs and the time spent submitting and waiting
+    void report() const;
+
+private:
+    struct pending_program {
+        unsigned int program = 0;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        uint64_t key = 0;
+        bool cacheable = false;
+        bool cached = false;
+        bool checked = false;
+    };
+
+    std::vector<pending_program> programs;
+    bool parallelCompile = false;
+    double submitMs = 0.0;
+    double waitMs = 0.0;
+};
+
+// Function to get the build queue of the current context, created on first use
+shader_build_queue& sharedShaderQueue();
+
+// Function to drop the shared queue, terminateWindow() calls it before the context goes away
+void releaseSharedShaderQueue();
+
+// A program submitted to the shared queue when it is created, linked when it is first used
+class queued_program {
+public:
+    queued_program() = default;
+
+    // Submits the compile and link of the program, defines work as in initializeShaders()
+    queued_program(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines = "");
+
+    // True once a program was submitted
+    bool submitted() const;
+
+    // True when get() would not block
+    bool ready() const;
+
+    // Returns the program, the first call waits for its link and reports errors
+    unsigned int get();
+
+    // True if the program linked, waits for it like get()
+    bool linked();
+
+private:
+    int handle = -1;
+    long queueGeneration = 0;
+    unsigned int program = 0;
+};
+
+// Function to initialize shaders, returns the linked program.
+// It waits for the driver right away, queued_program lets the compile overlap the setup.
+// defines is inserted after the #version line of both shaders, e.g. "#define USE_TEXTURE 1\n".
+unsigned int initializeShaders(const char* vertexShaderSource, const char* fragmentShaderSource, const char* defines = "");
+
+// Function to print the number of programs built and the time it took, then reset the totals
+void reportShaderBuildTime();
+
+#endif // OPENGL_TASKS_SHADER_H
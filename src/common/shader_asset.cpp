@@ -0,0 +1,277 @@
+#include "common/shader_asset.h"
+#include "common/embedded_shaders.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Source tree directory of the .glsl files, set by CMake
+#ifndef OPENGL_TASKS_SHADER_DIR
+#define OPENGL_TASKS_SHADER_DIR "src/tasks"
+#endif
+
+// Quiet time after the last change before the files are read again
+static const std::chrono::milliseconds settleTime(100);
+
+// Interval between modification time checks when inotify is not available
+static const std::chrono::milliseconds pollInterval(250);
+
+static std::vector<shader_asset*> assets;
+
+// Function to read a whole text file, returns false if it can't be opened
+static bool readFile(const std::string& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    text = content.str();
+    return true;
+}
+
+static std::string fileName(const std::string& path) {
+    return std::filesystem::path(path).filename().string();
+}
+
+static std::string directoryName(const std::string& path) {
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    return directory.empty() ? "." : directory;
+}
+
+// Function to find the file of a shader, returns an empty path if no shader directory has it
+static std::string resolveShaderPath(const std::string& name) {
+    const shader_asset_options& options = shaderAssetOptions();
+
+    std::vector<std::filesystem::path> directories;
+    if (!options.directory.empty()) {
+        directories.push_back(options.directory);
+    } else {
+        directories.push_back(OPENGL_TASKS_SHADER_DIR);
+        if (!options.executableDirectory.empty()) {
+            directories.push_back(std::filesystem::path(options.executableDirectory) / "shaders");
+        }
+    }
+
+    for (const std::filesystem::path& directory : directories) {
+        std::error_code error;
+        std::filesystem::path path = directory / name;
+        if (std::filesystem::is_regular_file(path, error)) {
+            return path.string();
+        }
+    }
+
+    if (findEmbeddedShader(name.c_str())) {
+        std::cout << "Using the embedded copy of " << name << ", it is not reloaded" << std::endl;
+    }
+    return "";
+}
+
+// Function to read a shader from its file, or take the embedded copy when it has no file
+static bool readShader(const std::string& name, const std::string& path, std::string& text) {
+    if (!path.empty()) {
+        return readFile(path, text);
+    }
+    const char* source = findEmbeddedShader(name.c_str());
+    if (!source) {
+        return false;
+    }
+    text = source;
+    return true;
+}
+
+// Modification time of a file, 0 if it does not exist
+static long long modificationTime(const std::string& path) {
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+shader_asset_options& shaderAssetOptions() {
+    static shader_asset_options options;
+    return options;
+}
+
+shader_asset::shader_asset(const std::string& vertexName, const std::string& fragmentName, const std::string& defines)
+    : vertexName(vertexName), fragmentName(fragmentName), defines(defines) {
+    vertexPath = resolveShaderPath(vertexName);
+    fragmentPath = resolveShaderPath(fragmentName);
+
+#ifdef __linux__
+    // Watch the directories, editors often save by writing a new file and renaming it
+    watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchDescriptor >= 0) {
+        const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+        for (const std::string* path : {&vertexPath, &fragmentPath}) {
+            if (!path->empty()) {
+                inotify_add_watch(watchDescriptor, directoryName(*path).c_str(), mask);
+            }
+        }
+    }
+#endif
+    vertexTime = modificationTime(vertexPath);
+    fragmentTime = modificationTime(fragmentPath);
+    lastPoll = clock::now();
+
+    // The task sets up its buffers while the driver compiles, program() waits for the build on first use
+    sourcesLoaded = submitBuild();
+    firstBuild = sourcesLoaded;
+
+    assets.push_back(this);
+}
+
+shader_asset::~shader_asset() {
+    assets.erase(std::remove(assets.begin(), assets.end(), this), assets.end());
+
+    if (buildPending) {
+        glDeleteProgram(pendingBuild.get());
+    }
+    if (currentProgram) {
+        glDeleteProgram(currentProgram);
+    }
+
+#ifdef __linux__
+    if (watchDescriptor >= 0) {
+        close(watchDescriptor);
+    }
+#endif
+}
+
+bool shader_asset::loaded() const {
+    return sourcesLoaded;
+}
+
+unsigned int shader_asset::program() {
+    if (firstBuild) {
+        takeFirstBuild();
+    }
+    return currentProgram;
+}
+
+int shader_asset::generation() const {
+    return reloads;
+}
+
+bool shader_asset::submitBuild() {
+    std::string vertexSource, fragmentSource;
+    if (!readShader(vertexName, vertexPath, vertexSource)) {
+        std::cerr << "Failed to read the shader " << (vertexPath.empty() ? vertexName : vertexPath) << std::endl;
+        return false;
+    }
+    if (!readShader(fragmentName, fragmentPath, fragmentSource)) {
+        std::cerr << "Failed to read the shader " << (fragmentPath.empty() ? fragmentName : fragmentPath) << std::endl;
+        return false;
+    }
+
+    pendingBuild = queued_program(vertexSource.c_str(), fragmentSource.c_str(), defines.c_str());
+    buildPending = true;
+    return true;
+}
+
+void shader_asset::takeFirstBuild() {
+    // The errors were printed by the build queue, the task draws with the program anyway as before
+    currentProgram = pendingBuild.get();
+    pendingBuild = queued_program();
+    buildPending = false;
+    firstBuild = false;
+}
+
+bool shader_asset::finishBuild() {
+    if (!pendingBuild.ready()) {
+        return false;
+    }
+
+    if (pendingBuild.linked()) {
+        if (currentProgram) {
+            glDeleteProgram(currentProgram);
+        }
+        currentProgram = pendingBuild.get();
+        reloads++;
+        std::cout << "Reloaded " << vertexPath << " and " << fragmentPath << std::endl;
+    } else {
+        // The errors were printed by the build queue
+        glDeleteProgram(pendingBuild.get());
+        std::cerr << "Keeping the previous program of " << vertexPath << " and " << fragmentPath << std::endl;
+    }
+
+    pendingBuild = queued_program();
+    buildPending = false;
+    return true;
+}
+
+bool shader_asset::filesChanged() {
+    bool changed = false;
+
+#ifdef __linux__
+    if (watchDescriptor >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(watchDescriptor, buffer, sizeof(buffer))) > 0) {
+            for (char* pointer = buffer; pointer < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(pointer);
+                if (event->len > 0 && (fileName(vertexPath) == event->name || fileName(fragmentPath) == event->name)) {
+                    changed = true;
+                }
+                pointer += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+
+    auto now = clock::now();
+    if (now - lastPoll < pollInterval) {
+        return false;
+    }
+    lastPoll = now;
+
+    long long newVertexTime = modificationTime(vertexPath);
+    long long newFragmentTime = modificationTime(fragmentPath);
+    changed = newVertexTime != vertexTime || newFragmentTime != fragmentTime;
+    vertexTime = newVertexTime;
+    fragmentTime = newFragmentTime;
+    return changed;
+}
+
+void shader_asset::update() {
+    // A task that did not draw yet still gets its first program before any reload
+    if (firstBuild) {
+        takeFirstBuild();
+    }
+
+    if (filesChanged()) {
+        changePending = true;
+        lastChange = clock::now();
+    }
+
+    // A change during a build restarts it with the newest files
+    if (changePending && clock::now() - lastChange >= settleTime) {
+        changePending = false;
+        if (buildPending) {
+            glDeleteProgram(pendingBuild.get());
+            buildPending = false;
+        }
+        submitBuild();
+    }
+
+    // Never wait for the compiler here, the current program keeps drawing until the new one is done
+    if (buildPending) {
+        finishBuild();
+    }
+}
+
+void updateShaderAssets() {
+    for (shader_asset* asset : assets) {
+        asset->update();
+    }
+}
@@ -0,0 +1,100 @@
+// Shader programs loaded from .glsl files, reloaded while the task runs.
+//
+// A shader_asset watches its two files (inotify on Linux, modification
+// times elsewhere). When one changes it submits the new sources to the
+// shared shader_build_queue and keeps drawing with the current program while the
+// driver compiles. The new program replaces the current one between frames,
+// in pollEvents(), and only if it linked; otherwise the error is printed and
+// the previous program stays in use.
+//
+// The files are named relative to the shader directory. Unless --shader-dir
+// names one, the directory is the source tree the build was configured from,
+// or else the shaders/ copy next to the executable. A file found in neither
+// falls back to the copy embedded at build time, which is never reloaded.
+
+#ifndef OPENGL_TASKS_SHADER_ASSET_H
+#define OPENGL_TASKS_SHADER_ASSET_H
+
+#include "common/shader.h"
+
+#include <chrono>
+#include <string>
+
+struct shader_asset_options {
+    // Directory the .glsl files are loaded from, empty to search the default ones
+    std::string directory;
+
+    // Directory of the running executable, holding the shaders/ copy made by the build
+    std::string executableDirectory;
+};
+
+// Global options for the shader files
+shader_asset_options& shaderAssetOptions();
+
+class shader_asset {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // Loads the two files and submits their build, defines work as in initializeShaders()
+    shader_asset(const std::string& vertexName, const std::string& fragmentName, const std::string& defines = "");
+    ~shader_asset();
+
+    shader_asset(const shader_asset&) = delete;
+    shader_asset& operator=(const shader_asset&) = delete;
+
+    // True if both sources could be read when the asset was created
+    bool loaded() const;
+
+    // The program to draw with, it changes after a successful reload. The first call waits for the first build
+    unsigned int program();
+
+    // Number of successful reloads
+    int generation() const;
+
+    // Checks the files and swaps in a rebuilt program, pollEvents() calls this every frame
+    void update();
+
+private:
+    // Function to read both sources and submit them to the shared build queue
+    bool submitBuild();
+
+    // Function to wait for the build submitted by the constructor and draw with it
+    void takeFirstBuild();
+
+    // Function to take the finished build, returns false while the driver is still compiling
+    bool finishBuild();
+
+    // Function to report whether the files changed since the last call
+    bool filesChanged();
+
+    // Names relative to the shader directory, and the files they were found at (empty when embedded)
+    std::string vertexName;
+    std::string fragmentName;
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;
+
+    unsigned int currentProgram = 0;
+    int reloads = 0;
+    bool sourcesLoaded = false;
+
+    // Build in flight, if any, and whether it is the first one
+    queued_program pendingBuild;
+    bool buildPending = false;
+    bool firstBuild = false;
+
+    // Changes are applied once the files have been quiet for a moment, editors write in several steps
+    bool changePending = false;
+    clock::time_point lastChange;
+
+    // inotify descriptor, or -1 when modification times are polled instead
+    int watchDescriptor = -1;
+    long long vertexTime = 0;
+    long long fragmentTime = 0;
+    clock::time_point lastPoll;
+};
+
+// Function to update all live shader assets, called between frames
+void updateShaderAssets();
+
+#endif // OPENGL_TASKS_SHADER_ASSET_H
@@ -0,0 +1,217 @@
+#include "common/shader_reflection.h"
+
+#include <glad/glad.h>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+// 32-bit FNV-1a hash of a name
+static uint32_t hashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name) {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Arrays are reported as "name[0]", they are looked up without the suffix
+static std::string baseName(const char* name) {
+    std::string text = name;
+    if (text.size() > 3 && text.compare(text.size() - 3, 3, "[0]") == 0) {
+        text.resize(text.size() - 3);
+    }
+    return text;
+}
+
+program_reflection::program_reflection(unsigned int program) : program(program) {
+    GLint count = 0;
+    char name[256];
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, i, sizeof(name), NULL, &size, &type, name);
+
+        // Uniforms of uniform blocks have no location and are not set one by one
+        int location = glGetUniformLocation(program, name);
+        if (location < 0) {
+            continue;
+        }
+
+        shader_variable variable;
+        variable.name = baseName(name);
+        variable.hash = hashName(variable.name.c_str());
+        variable.location = location;
+        variable.type = type;
+        variable.size = size;
+        uniforms.variables.push_back(variable);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    for (GLint i = 0; i < count; ++i) {
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, i, sizeof(name), NULL, &size, &type, name);
+
+        // Built-in inputs such as gl_VertexID are active too but have no location
+        int location = glGetAttribLocation(program, name);
+        if (location < 0) {
+            continue;
+        }
+
+        shader_variable variable;
+        variable.name = baseName(name);
+        variable.hash = hashName(variable.name.c_str());
+        variable.location = location;
+        variable.type = type;
+        variable.size = size;
+        attributes.variables.push_back(variable);
+    }
+
+    buildIndex(uniforms);
+    buildIndex(attributes);
+}
+
+void program_reflection::buildIndex(variable_table& table) {
+    // Keep the table at most half full so probe sequences stay short
+    size_t capacity = 8;
+    while (capacity < table.variables.size() * 2) {
+        capacity *= 2;
+    }
+
+    table.slots.assign(capacity, -1);
+    for (size_t i = 0; i < table.variables.size(); ++i) {
+        size_t slot = table.variables[i].hash & (capacity - 1);
+        while (table.slots[slot] >= 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        table.slots[slot] = static_cast<int>(i);
+    }
+}
+
+const shader_variable* program_reflection::find(const variable_table& table, const char* name) {
+    uint32_t hash = hashName(name);
+    size_t mask = table.slots.size() - 1;
+    for (size_t slot = hash & mask; table.slots[slot] >= 0; slot = (slot + 1) & mask) {
+        const shader_variable& variable = table.variables[table.slots[slot]];
+        if (variable.hash == hash && variable.name == name) {
+            return &variable;
+        }
+    }
+    return nullptr;
+}
+
+int program_reflection::check(const char* kind, const char* name, const shader_variable* variable, bool typeMatches) {
+    if (!variable) {
+        std::cerr << "Program " << program << " has no active " << kind << " '" << name
+                  << "' (misspelled, or unused and optimized out)" << std::endl;
+        failed = true;
+        return -1;
+    }
+    if (!typeMatches) {
+        std::cerr << "The " << kind << " '" << name << "' of program " << program << " has the GL type 0x"
+                  << std::hex << variable->type << std::dec << ", which does not match the handle" << std::endl;
+        failed = true;
+        return -1;
+    }
+    return variable->location;
+}
+
+int program_reflection::attribute(const char* name, unsigned int type) {
+    const shader_variable* variable = find(attributes, name);
+    return check("attribute", name, variable, variable && variable->type == type);
+}
+
+bool program_reflection::valid() const {
+    return !failed;
+}
+
+const std::vector<shader_variable>& program_reflection::activeUniforms() const {
+    return uniforms.variables;
+}
+
+const std::vector<shader_variable>& program_reflection::activeAttributes() const {
+    return attributes.variables;
+}
+
+// Samplers and booleans are set with glUniform1i as well
+template <>
+bool program_reflection::uniformTypeMatches<int>(unsigned int type) {
+    switch (type) {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<float>(unsigned int type) {
+    return type == GL_FLOAT;
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<glm::vec2>(unsigned int type) {
+    return type == GL_FLOAT_VEC2;
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<glm::vec3>(unsigned int type) {
+    return type == GL_FLOAT_VEC3;
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<glm::vec4>(unsigned int type) {
+    return type == GL_FLOAT_VEC4;
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<glm::mat3>(unsigned int type) {
+    return type == GL_FLOAT_MAT3;
+}
+
+template <>
+bool program_reflection::uniformTypeMatches<glm::mat4>(unsigned int type) {
+    return type == GL_FLOAT_MAT4;
+}
+
+void setUniform(uniform_handle<int> handle, int value) {
+    glUniform1i(handle.location, value);
+}
+
+void setUniform(uniform_handle<float> handle, float value) {
+    glUniform1f(handle.location, value);
+}
+
+void setUniform(uniform_handle<glm::vec2> handle, const glm::vec2& value) {
+    glUniform2fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void setUniform(uniform_handle<glm::vec3> handle, const glm::vec3& value) {
+    glUniform3fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void setUniform(uniform_handle<glm::vec4> handle, const glm::vec4& value) {
+    glUniform4fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void setUniform(uniform_handle<glm::mat3> handle, const glm::mat3& value) {
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void setUniform(uniform_handle<glm::mat4> handle, const glm::mat4& value) {
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
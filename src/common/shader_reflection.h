@@ -0,0 +1,99 @@
+// Uniform and attribute reflection of linked programs.
+//
+// program_reflection reads the active uniforms and attributes of a program
+// once, right after it is linked, into a small hash table keyed by name.
+// Tasks look up typed handles while they load; a name that is misspelled,
+// optimized out or of the wrong type is reported right there, and the
+// render loop only uses the stored locations, never a string.
+
+#ifndef OPENGL_TASKS_SHADER_REFLECTION_H
+#define OPENGL_TASKS_SHADER_REFLECTION_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An active uniform or attribute of a program
+struct shader_variable {
+    std::string name;
+    uint32_t hash = 0;
+    int location = -1;
+
+    // GL type such as GL_FLOAT_VEC3 or GL_SAMPLER_2D, and the array size
+    unsigned int type = 0;
+    int size = 0;
+};
+
+// Location of a uniform whose GL type matches T, -1 if the lookup failed
+template <typename T>
+struct uniform_handle {
+    int location = -1;
+};
+
+class program_reflection {
+public:
+    // Reads the active uniforms and attributes of a linked program
+    explicit program_reflection(unsigned int program);
+
+    // Function to look up a uniform, reports missing names and mismatched types
+    template <typename T>
+    uniform_handle<T> uniform(const char* name) {
+        const shader_variable* variable = find(uniforms, name);
+        uniform_handle<T> handle;
+        handle.location = check("uniform", name, variable, variable && uniformTypeMatches<T>(variable->type));
+        return handle;
+    }
+
+    // Function to look up an attribute location, reports missing names and mismatched types
+    int attribute(const char* name, unsigned int type);
+
+    // False once any lookup failed, tasks check it before entering the render loop
+    bool valid() const;
+
+    const std::vector<shader_variable>& activeUniforms() const;
+    const std::vector<shader_variable>& activeAttributes() const;
+
+private:
+    // Variables with an open addressing index over their name hashes
+    struct variable_table {
+        std::vector<shader_variable> variables;
+        std::vector<int> slots;
+    };
+
+    template <typename T>
+    static bool uniformTypeMatches(unsigned int type);
+
+    static void buildIndex(variable_table& table);
+
+    // Function to find a variable by name, nullptr if it is not active
+    static const shader_variable* find(const variable_table& table, const char* name);
+
+    // Function to report a failed lookup, returns the location or -1
+    int check(const char* kind, const char* name, const shader_variable* variable, bool typeMatches);
+
+    unsigned int program;
+    variable_table uniforms;
+    variable_table attributes;
+    bool failed = false;
+};
+
+template <> bool program_reflection::uniformTypeMatches<int>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<float>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<glm::vec2>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<glm::vec3>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<glm::vec4>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<glm::mat3>(unsigned int type);
+template <> bool program_reflection::uniformTypeMatches<glm::mat4>(unsigned int type);
+
+// Functions to set a uniform of the program in use, a failed handle is ignored
+void setUniform(uniform_handle<int> handle, int value);
+void setUniform(uniform_handle<float> handle, float value);
+void setUniform(uniform_handle<glm::vec2> handle, const glm::vec2& value);
+void setUniform(uniform_handle<glm::vec3> handle, const glm::vec3& value);
+void setUniform(uniform_handle<glm::vec4> handle, const glm::vec4& value);
+void setUniform(uniform_handle<glm::mat3> handle, const glm::mat3& value);
+void setUniform(uniform_handle<glm::mat4> handle, const glm::mat4& value);
+
+#endif // OPENGL_TASKS_SHADER_REFLECTION_H
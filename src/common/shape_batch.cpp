@@ -0,0 +1,171 @@
+#include "common/shape_batch.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec4 aColor;
+    out vec4 FragColor;
+    void main() {
+        gl_Position = vec4(aPos, 0.0, 1.0);
+        FragColor = aColor;
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec4 FragColor;
+    out vec4 FinalColor;
+    void main() {
+        FinalColor = FragColor;
+    }
+)";
+
+uint32_t packColor(float r, float g, float b, float a) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+    };
+    // Little-endian, so the bytes are R, G, B, A in memory
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | channel(a) << 24;
+}
+
+shape_batch::shape_batch(size_t maxVertices) : maxVertices(maxVertices), maxIndices(maxVertices * 3) {
+    vertices.reserve(maxVertices);
+    indices.reserve(maxIndices);
+
+    // Only submitted here, the first draw waits for the link
+    shaderProgram = queued_program(vertexShaderSource, fragmentShaderSource);
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+
+    // The storage of the buffers is respecified on every flush
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(batch_vertex), (void*)offsetof(batch_vertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(batch_vertex), (void*)offsetof(batch_vertex, color));
+    glEnableVertexAttribArray(1);
+
+    // The element buffer binding is part of the VAO, so only the vertex buffer is unbound
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+shape_batch::~shape_batch() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteProgram(shaderProgram.get());
+}
+
+bool shape_batch::valid() const {
+    return shaderProgram.submitted() && VAO != 0;
+}
+
+uint32_t shape_batch::reserve(size_t vertexCount, size_t indexCount) {
+    if (vertices.size() + vertexCount > maxVertices || indices.size() + indexCount > maxIndices) {
+        flush();
+    }
+    totals.shapes++;
+    return static_cast<uint32_t>(vertices.size());
+}
+
+void shape_batch::addTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, uint32_t color) {
+    uint32_t base = reserve(3, 3);
+    vertices.push_back({a.x, a.y, color});
+    vertices.push_back({b.x, b.y, color});
+    vertices.push_back({c.x, c.y, color});
+    indices.insert(indices.end(), {base, base + 1, base + 2});
+}
+
+void shape_batch::addRect(glm::vec2 position, glm::vec2 size, uint32_t color) {
+    uint32_t base = reserve(4, 6);
+    vertices.push_back({position.x, position.y, color});
+    vertices.push_back({position.x + size.x, position.y, color});
+    vertices.push_back({position.x + size.x, position.y + size.y, color});
+    vertices.push_back({position.x, position.y + size.y, color});
+    indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+void shape_batch::addCircle(glm::vec2 center, float radius, uint32_t color, int segments) {
+    segments = std::max(segments, 3);
+    uint32_t base = reserve(segments + 1, segments * 3);
+
+    vertices.push_back({center.x, center.y, color});
+
+    // Rotate the rim point instead of calling sin and cos for every segment
+    float angle = 2.0f * 3.1415926f / static_cast<float>(segments);
+    float c = std::cos(angle), s = std::sin(angle);
+    float x = radius, y = 0.0f;
+    for (int i = 0; i < segments; ++i) {
+        vertices.push_back({center.x + x, center.y + y, color});
+        float nextX = x * c - y * s;
+        y = x * s + y * c;
+        x = nextX;
+
+        uint32_t next = (i + 1) % segments;
+        indices.insert(indices.end(), {base, base + 1 + i, base + 1 + next});
+    }
+}
+
+void shape_batch::addLine(glm::vec2 from, glm::vec2 to, float width, uint32_t color) {
+    glm::vec2 direction = to - from;
+    float length = glm::length(direction);
+    if (length <= 0.0f) {
+        return;
+    }
+
+    // Offset both ends by half the width along the normal of the line
+    glm::vec2 normal = glm::vec2(-direction.y, direction.x) * (0.5f * width / length);
+
+    uint32_t base = reserve(4, 6);
+    vertices.push_back({from.x + normal.x, from.y + normal.y, color});
+    vertices.push_back({from.x - normal.x, from.y - normal.y, color});
+    vertices.push_back({to.x - normal.x, to.y - normal.y, color});
+    vertices.push_back({to.x + normal.x, to.y + normal.y, color});
+    indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+}
+
+void shape_batch::flush() {
+    if (indices.empty()) {
+        return;
+    }
+
+    glBindVertexArray(VAO);
+
+    // Respecifying the storage orphans the previous one, so the upload never waits for a draw that still reads it
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(batch_vertex), vertices.data(), GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STREAM_DRAW);
+
+    glUseProgram(shaderProgram.get());
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    totals.drawCalls++;
+    totals.vertices += static_cast<long>(vertices.size());
+    totals.indices += static_cast<long>(indices.size());
+
+    vertices.clear();
+    indices.clear();
+}
+
+batch_stats shape_batch::stats() const {
+    return totals;
+}
+
+void shape_batch::resetStats() {
+    totals = batch_stats();
+}
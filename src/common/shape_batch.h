@@ -0,0 +1,81 @@
+// Batched renderer for flat 2D shapes.
+//
+// Triangles, rectangles, circles and lines are appended as indexed
+// triangles with a per-vertex RGBA8 color into CPU-side arrays. flush()
+// streams them into one vertex and one index buffer and draws everything
+// with a single glDrawElements call, or a few if the batch outgrows its
+// capacity. Positions are in normalized device coordinates.
+
+#ifndef OPENGL_TASKS_SHAPE_BATCH_H
+#define OPENGL_TASKS_SHAPE_BATCH_H
+
+#include "common/shader.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Vertex of a batched shape, the color is RGBA8 in memory order
+struct batch_vertex {
+    float x, y;
+    uint32_t color;
+};
+
+// Draw statistics since the last resetStats()
+struct batch_stats {
+    long drawCalls = 0;
+    long vertices = 0;
+    long indices = 0;
+    long shapes = 0;
+};
+
+// Function to pack a color into the RGBA8 layout of batch_vertex
+uint32_t packColor(float r, float g, float b, float a = 1.0f);
+
+class shape_batch {
+public:
+    // maxVertices bounds the size of one draw call, larger batches are split
+    explicit shape_batch(size_t maxVertices = 1 << 18);
+    ~shape_batch();
+
+    shape_batch(const shape_batch&) = delete;
+    shape_batch& operator=(const shape_batch&) = delete;
+
+    // True if the program and the buffers were created
+    bool valid() const;
+
+    void addTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, uint32_t color);
+
+    // Axis-aligned rectangle from its lower left corner and its size
+    void addRect(glm::vec2 position, glm::vec2 size, uint32_t color);
+
+    // Circle drawn as a fan of segments triangles
+    void addCircle(glm::vec2 center, float radius, uint32_t color, int segments = 32);
+
+    // Line drawn as a quad of the given width
+    void addLine(glm::vec2 from, glm::vec2 to, float width, uint32_t color);
+
+    // Uploads and draws everything added since the last flush
+    void flush();
+
+    batch_stats stats() const;
+    void resetStats();
+
+private:
+    // Function to make room for a shape, flushing first if it would not fit
+    uint32_t reserve(size_t vertexCount, size_t indexCount);
+
+    size_t maxVertices;
+    size_t maxIndices;
+    std::vector<batch_vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    // Submitted by the constructor, linked by the first draw
+    queued_program shaderProgram;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+
+    batch_stats totals;
+};
+
+#endif // OPENGL_TASKS_SHAPE_BATCH_H
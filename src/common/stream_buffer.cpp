@@ -0,0 +1,151 @@
+#include "common/stream_buffer.h"
+#include "common/window.h"
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <iostream>
+
+stream_buffer::stream_buffer(unsigned int target, size_t regionSize, int regionCount)
+    : target(target), regionSize(regionSize), regionCount(regionCount > 0 ? regionCount : 1) {
+    glGenBuffers(1, &bufferObject);
+    glBindBuffer(target, bufferObject);
+
+    // ARB_buffer_storage names the function like OpenGL 4.4 does, but GLAD only loads it for 4.4
+    PFNGLBUFFERSTORAGEPROC bufferStorage = GLAD_GL_VERSION_4_4 ? glBufferStorage : nullptr;
+    if (!bufferStorage && hasExtension("GL_ARB_buffer_storage")) {
+        bufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(getProcAddress("glBufferStorage"));
+    }
+
+    if (bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLsizeiptr size = static_cast<GLsizeiptr>(regionSize * this->regionCount);
+        bufferStorage(target, size, nullptr, flags);
+        mapped = static_cast<char*>(glMapBufferRange(target, 0, size, flags));
+        if (!mapped) {
+            std::cerr << "Failed to map the stream buffer, falling back to orphaning" << std::endl;
+
+            // Immutable storage can't be respecified, start over with a mutable buffer
+            glBindBuffer(target, 0);
+            glDeleteBuffers(1, &bufferObject);
+            glGenBuffers(1, &bufferObject);
+            glBindBuffer(target, bufferObject);
+        }
+    }
+
+    if (mapped) {
+        fences.assign(this->regionCount, nullptr);
+    } else {
+        this->regionCount = 1;
+        staging.resize(regionSize);
+        glBufferData(target, static_cast<GLsizeiptr>(regionSize), nullptr, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(target, 0);
+}
+
+stream_buffer::~stream_buffer() {
+    for (void* fence : fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+
+    if (mapped) {
+        glBindBuffer(target, bufferObject);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+    }
+    glDeleteBuffers(1, &bufferObject);
+}
+
+unsigned int stream_buffer::buffer() const {
+    return bufferObject;
+}
+
+bool stream_buffer::persistent() const {
+    return mapped != nullptr;
+}
+
+void stream_buffer::waitForRegion() {
+    regionReady = true;
+    if (!mapped || !fences[region]) {
+        return;
+    }
+
+    GLsync fence = static_cast<GLsync>(fences[region]);
+
+    // Usually signaled long ago, a zero timeout checks without waiting
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        totals.waits++;
+        totals.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    glDeleteSync(fence);
+    fences[region] = nullptr;
+}
+
+stream_allocation stream_buffer::allocate(size_t size, size_t alignment) {
+    if (!regionReady) {
+        waitForRegion();
+    }
+
+    size_t start = alignment > 1 ? (used + alignment - 1) / alignment * alignment : used;
+    if (start + size > regionSize) {
+        totals.overflows++;
+        return stream_allocation();
+    }
+    used = start + size;
+
+    stream_allocation allocation;
+    if (mapped) {
+        allocation.offset = region * regionSize + start;
+        allocation.data = mapped + allocation.offset;
+    } else {
+        allocation.offset = start;
+        allocation.data = staging.data() + start;
+    }
+    return allocation;
+}
+
+void stream_buffer::commit() {
+    // Coherent mappings need no flush, the fence in endFrame() orders the writes before the draws
+    if (mapped || committed == used) {
+        return;
+    }
+
+    glBindBuffer(target, bufferObject);
+
+    // Orphan at the first upload of a frame, the draws of the previous frame keep the old storage
+    if (committed == 0) {
+        glBufferData(target, static_cast<GLsizeiptr>(regionSize), nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(target, static_cast<GLintptr>(committed), static_cast<GLsizeiptr>(used - committed),
+                    staging.data() + committed);
+
+    glBindBuffer(target, 0);
+    committed = used;
+}
+
+void stream_buffer::endFrame() {
+    commit();
+
+    if (mapped && used > 0) {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    region = (region + 1) % regionCount;
+    used = 0;
+    committed = 0;
+    regionReady = false;
+    totals.frames++;
+}
+
+stream_stats stream_buffer::stats() const {
+    return totals;
+}
@@ -0,0 +1,87 @@
+// Streaming buffer for geometry that changes every frame.
+//
+// On OpenGL 4.4 (or ARB_buffer_storage) the buffer is allocated once with
+// glBufferStorage and stays mapped with GL_MAP_PERSISTENT_BIT and
+// GL_MAP_COHERENT_BIT. It is split into regionCount regions, one per frame
+// in flight: a frame writes only into its own region, and endFrame() puts a
+// fence behind it. A region is reused only after its fence has signaled, so
+// the CPU never writes memory the GPU is still reading and no call waits
+// for the driver to synchronize implicitly.
+//
+// On older contexts writes go to a CPU copy of one region, and commit()
+// uploads them into storage that is orphaned once per frame.
+
+#ifndef OPENGL_TASKS_STREAM_BUFFER_H
+#define OPENGL_TASKS_STREAM_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+// Space handed out by stream_buffer::allocate
+struct stream_allocation {
+    // Where to write the data, valid until the next commit()
+    void* data = nullptr;
+
+    // Byte offset in the buffer object, for vertex attribute offsets or the first vertex of a draw
+    size_t offset = 0;
+};
+
+// Waiting statistics, a well sized buffer never waits
+struct stream_stats {
+    long frames = 0;
+    long waits = 0;
+    double waitMs = 0.0;
+    long overflows = 0;
+};
+
+class stream_buffer {
+public:
+    // regionSize is the most a frame can write, the buffer holds regionCount of them
+    stream_buffer(unsigned int target, size_t regionSize, int regionCount = 3);
+    ~stream_buffer();
+
+    stream_buffer(const stream_buffer&) = delete;
+    stream_buffer& operator=(const stream_buffer&) = delete;
+
+    // The buffer object, bind it to the target before setting up attribute pointers
+    unsigned int buffer() const;
+
+    // True when the buffer is persistently mapped, false on the orphaning fallback
+    bool persistent() const;
+
+    // Reserves size bytes in the region of the current frame, data is nullptr if the region is full
+    stream_allocation allocate(size_t size, size_t alignment = 16);
+
+    // Makes the data written since the last commit visible to draw calls, call it before drawing
+    void commit();
+
+    // Fences the region of this frame and moves on to the next one
+    void endFrame();
+
+    stream_stats stats() const;
+
+private:
+    // Function to wait until the GPU is done with the current region
+    void waitForRegion();
+
+    unsigned int target;
+    unsigned int bufferObject = 0;
+    size_t regionSize;
+    int regionCount;
+
+    // Persistent mapping of the whole buffer, or nullptr on the fallback
+    char* mapped = nullptr;
+    std::vector<void*> fences;
+
+    // CPU copy of the region on the fallback
+    std::vector<char> staging;
+
+    int region = 0;
+    size_t used = 0;
+    size_t committed = 0;
+    bool regionReady = false;
+
+    stream_stats totals;
+};
+
+#endif // OPENGL_TASKS_STREAM_BUFFER_H
@@ -0,0 +1,34 @@
+#include "common/task_registry.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The registry is filled during static initialization, so it must be constructed on first use
+static std::vector<task_entry>& taskList() {
+    static std::vector<task_entry> tasks;
+    return tasks;
+}
+
+bool registerTask(const char* name, const char* description, task_function function) {
+    std::vector<task_entry>& tasks = taskList();
+
+    // Keep the list sorted so --list prints a stable order regardless of link order
+    auto position = std::lower_bound(tasks.begin(), tasks.end(), name,
+        [](const task_entry& entry, const char* key) { return std::strcmp(entry.name, key) < 0; });
+    tasks.insert(position, task_entry{name, description, function});
+
+    return true;
+}
+
+const std::vector<task_entry>& registeredTasks() {
+    return taskList();
+}
+
+const task_entry* findTask(const std::string& name) {
+    for (const task_entry& entry : taskList()) {
+        if (name == entry.name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
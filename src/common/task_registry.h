@@ -0,0 +1,38 @@
+// Registry of the runnable tasks.
+//
+// Every task translation unit registers its entry functions by name with
+// REGISTER_TASK, and main.cpp looks them up from the command line, so all
+// tasks are linked into a single executable.
+
+#ifndef OPENGL_TASKS_TASK_REGISTRY_H
+#define OPENGL_TASKS_TASK_REGISTRY_H
+
+#include <string>
+#include <vector>
+
+// Entry function of a task, returns 0 on success like main()
+typedef int (*task_function)();
+
+struct task_entry {
+    const char* name;
+    const char* description;
+    task_function function;
+};
+
+// Adds a task to the registry, returns true so it can initialize a static variable
+bool registerTask(const char* name, const char* description, task_function function);
+
+// All registered tasks, sorted by name
+const std::vector<task_entry>& registeredTasks();
+
+// Returns the task with the given name, or nullptr if there is none
+const task_entry* findTask(const std::string& name);
+
+#define TASK_REGISTRY_CONCAT_IMPL(a, b) a##b
+#define TASK_REGISTRY_CONCAT(a, b) TASK_REGISTRY_CONCAT_IMPL(a, b)
+
+// Registers a task function under a name when the program starts
+#define REGISTER_TASK(name, description, function) \
+    static const bool TASK_REGISTRY_CONCAT(taskRegistered_, __LINE__) = registerTask(name, description, function)
+
+#endif // OPENGL_TASKS_TASK_REGISTRY_H
@@ -0,0 +1,229 @@
+#include "common/texture.h"
+
+#include "common/window.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// GL_EXT_texture_compression_s3tc and its sRGB variants are not part of the generated loader
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+
+texture_format textureFormat(int channels, bool srgb) {
+    switch (channels) {
+    case 1:
+        return {GL_R8, GL_RED, 1};
+    case 2:
+        return {GL_RG8, GL_RG, 2};
+    case 3:
+        return {static_cast<GLenum>(srgb ? GL_SRGB8 : GL_RGB8), GL_RGB, 3};
+    default:
+        return {static_cast<GLenum>(srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8), GL_RGBA, 4};
+    }
+}
+
+int textureChannels(int fileChannels) {
+    return fileChannels == 3 ? 4 : fileChannels;
+}
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+int unpackAlignment(size_t rowBytes) {
+    for (int alignment = 8; alignment > 1; alignment /= 2) {
+        if (rowBytes % alignment == 0) {
+            return alignment;
+        }
+    }
+    return 1;
+}
+
+unsigned int allocateTexture(const texture_format& format, int width, int height, int levels) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    if (GLAD_GL_VERSION_4_2) {
+        glTexStorage2D(GL_TEXTURE_2D, levels, format.internalFormat, width, height);
+    } else {
+        // Mutable levels with the same sizes, the last level bounds what the sampler reads
+        for (int level = 0; level < levels; ++level) {
+            int levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+            if (format.blockBytes > 0) {
+                GLsizei size = static_cast<GLsizei>((levelWidth + 3) / 4 * ((levelHeight + 3) / 4) * format.blockBytes);
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, levelWidth, levelHeight, 0, size,
+                                       nullptr);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(format.internalFormat), levelWidth, levelHeight,
+                             0, format.format, GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Gray stays gray instead of red, and the second channel of two is the alpha. BC5 holds two independent
+    // channels and keeps them in red and green.
+    bool pixels = format.blockBytes == 0;
+    if (pixels && format.channels == 1) {
+        const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_ONE};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    } else if (pixels && format.channels == 2) {
+        const GLint swizzle[] = {GL_RED, GL_RED, GL_RED, GL_GREEN};
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+unsigned int createTexture(const unsigned char* pixels, int width, int height, int channels, bool srgb) {
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        std::cerr << "Invalid texture data: " << width << "x" << height << " with " << channels << " channels"
+                  << std::endl;
+        return 0;
+    }
+
+    texture_format format = textureFormat(channels, srgb);
+    int levels = mipLevelCount(width, height);
+    unsigned int texture = allocateTexture(format, width, height, levels);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(static_cast<size_t>(width) * channels));
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format.format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (levels > 1) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+texture_format compressedTextureFormat(block_format format, bool srgb) {
+    switch (format) {
+    case block_format::bc1:
+        return {static_cast<GLenum>(srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT),
+                GL_RGBA, 4, 8};
+    case block_format::bc3:
+        return {static_cast<GLenum>(srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT),
+                GL_RGBA, 4, 16};
+    case block_format::bc5:
+        return {GL_COMPRESSED_RG_RGTC2, GL_RG, 2, 16};
+    default:
+        return {static_cast<GLenum>(srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM),
+                GL_RGBA, 4, 16};
+    }
+}
+
+bool compressedFormatSupported(block_format format) {
+    switch (format) {
+    case block_format::bc1:
+    case block_format::bc3:
+        return hasExtension("GL_EXT_texture_compression_s3tc");
+    case block_format::bc5:
+        // RGTC is core since OpenGL 3.0
+        return true;
+    default:
+        return GLAD_GL_VERSION_4_2 || hasExtension("GL_ARB_texture_compression_bptc");
+    }
+}
+
+unsigned int createTextureLevels(const texture_format& format, int width, int height,
+                                 const unsigned char* const* levels, int levelCount) {
+    unsigned int texture = allocateTexture(format, width, height, levelCount);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (int level = 0; level < levelCount; ++level) {
+        int levelWidth = std::max(width >> level, 1), levelHeight = std::max(height >> level, 1);
+        if (format.blockBytes > 0) {
+            GLsizei size = static_cast<GLsizei>((levelWidth + 3) / 4 * ((levelHeight + 3) / 4) * format.blockBytes);
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, format.internalFormat, size,
+                                      levels[level]);
+        } else {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(static_cast<size_t>(levelWidth) * format.channels));
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelWidth, levelHeight, format.format, GL_UNSIGNED_BYTE,
+                            levels[level]);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+unsigned int createCompressedTexture(const compressed_texture& texture) {
+    if (texture.levels.empty() || !compressedFormatSupported(texture.format)) {
+        std::cerr << "Cannot create a " << blockFormatName(texture.format) << " texture of " << texture.levels.size()
+                  << " levels" << std::endl;
+        return 0;
+    }
+
+    std::vector<const unsigned char*> levels;
+    for (const mip_level& level : texture.levels) {
+        levels.push_back(texture.data.data() + level.offset);
+    }
+    return createTextureLevels(compressedTextureFormat(texture.format, texture.srgb), texture.width, texture.height,
+                               levels.data(), static_cast<int>(levels.size()));
+}
+
+unsigned int createPackedTexture(const asset_pack& pack, const asset_pack_entry& entry) {
+    bool srgb = (entry.flags & assetPackSrgb) != 0;
+    texture_format format;
+    if (entry.kind == static_cast<uint32_t>(asset_kind::texture) && entry.format >= 1 && entry.format <= 4) {
+        format = textureFormat(static_cast<int>(entry.format), srgb);
+    } else if (entry.kind == static_cast<uint32_t>(asset_kind::compressed_texture) &&
+               entry.format <= static_cast<uint32_t>(block_format::bc7) &&
+               compressedFormatSupported(static_cast<block_format>(entry.format))) {
+        format = compressedTextureFormat(static_cast<block_format>(entry.format), srgb);
+    } else {
+        std::cerr << "Asset " << entry.name << " is not a texture this context can create" << std::endl;
+        return 0;
+    }
+
+    if (entry.rangeCount == 0 || entry.width == 0 || entry.height == 0) {
+        std::cerr << "Asset " << entry.name << " has no levels" << std::endl;
+        return 0;
+    }
+
+    // A chain never has more levels than halving the larger side down to 1 gives, which also keeps the shifts
+    // below in range
+    if (entry.width > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+        entry.height > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+        entry.rangeCount > static_cast<uint32_t>(mipLevelCount(static_cast<int>(entry.width),
+                                                               static_cast<int>(entry.height)))) {
+        std::cerr << "Asset " << entry.name << " has " << entry.rangeCount << " levels, more than a "
+                  << entry.width << "x" << entry.height << " texture can have" << std::endl;
+        return 0;
+    }
+
+    // Each level must hold exactly the pixels or blocks of its size, the uploads read them in place
+    std::vector<const unsigned char*> levels;
+    for (uint32_t i = 0; i < entry.rangeCount; ++i) {
+        int width = std::max(static_cast<int>(entry.width >> i), 1);
+        int height = std::max(static_cast<int>(entry.height >> i), 1);
+        size_t expected = format.blockBytes > 0
+                              ? compressedSize(static_cast<block_format>(entry.format), width, height)
+                              : static_cast<size_t>(width) * height * format.channels;
+        size_t size = 0;
+        levels.push_back(pack.range(entry, i, &size));
+        if (size != expected) {
+            std::cerr << "Level " << i << " of asset " << entry.name << " has " << size << " bytes instead of "
+                      << expected << std::endl;
+            return 0;
+        }
+    }
+    return createTextureLevels(format, static_cast<int>(entry.width), static_cast<int>(entry.height), levels.data(),
+                               static_cast<int>(levels.size()));
+}
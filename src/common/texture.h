@@ -0,0 +1,74 @@
+// Texture creation that matches the pixel data.
+//
+// textureFormat() maps the channel count of an image to a sized internal
+// format and the matching pixel format: R8, RG8, RGB8 or RGBA8, and
+// SRGB8 / SRGB8_ALPHA8 for color data that is stored in sRGB. One and two
+// channel textures swizzle their first channel into rgb, so grayscale and
+// grayscale with alpha images sample like the RGBA they stand for.
+//
+// Three channel images are best expanded to four when they are decoded
+// (textureChannels()): GPUs store RGB8 with a fourth byte anyway, and
+// uploading tightly packed RGB makes the driver repack every pixel.
+//
+// Storage is immutable (glTexStorage2D, OpenGL 4.2) with the full mip
+// chain, so the driver validates and allocates it once. Older contexts get
+// the same levels from glTexImage2D.
+//
+// Block compressed textures (compressed_texture.h) map to the S3TC, RGTC
+// and BPTC formats and are uploaded level by level with
+// glCompressedTexSubImage2D, GPUs sample them without expanding them.
+// Textures of an asset pack (asset_pack.h) are uploaded straight from the
+// mapped file.
+
+#ifndef OPENGL_TASKS_TEXTURE_H
+#define OPENGL_TASKS_TEXTURE_H
+
+#include "common/asset_pack.h"
+#include "common/compressed_texture.h"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+struct texture_format {
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    int channels = 4;
+    int blockBytes = 0;  // bytes per 4x4 block of compressed formats, 0 for pixels
+};
+
+// Function to pick the formats for 1 to 4 channels of 8-bit data, srgb only applies to 3 and 4 channels
+texture_format textureFormat(int channels, bool srgb = false);
+
+// Function to return the channel count to decode a file with, three channel images get an alpha channel
+int textureChannels(int fileChannels);
+
+// Number of levels of a full mip chain down to 1x1
+int mipLevelCount(int width, int height);
+
+// Largest GL_UNPACK_ALIGNMENT (8, 4, 2 or 1) that tightly packed rows of rowBytes satisfy
+int unpackAlignment(size_t rowBytes);
+
+// Function to allocate the storage of a texture with the given levels and set its sampling, returns the texture
+unsigned int allocateTexture(const texture_format& format, int width, int height, int levels);
+
+// Function to create a texture from tightly packed pixels and generate its mipmaps, returns the texture or 0
+unsigned int createTexture(const unsigned char* pixels, int width, int height, int channels, bool srgb = false);
+
+// Function to pick the compressed internal format of a block format
+texture_format compressedTextureFormat(block_format format, bool srgb = false);
+
+// True if the context can sample the block format
+bool compressedFormatSupported(block_format format);
+
+// Function to create a texture from tightly packed levels, pixels or blocks as the format says, returns the texture
+unsigned int createTextureLevels(const texture_format& format, int width, int height,
+                                 const unsigned char* const* levels, int levelCount);
+
+// Function to create a texture from every level of a compressed texture, returns the texture or 0
+unsigned int createCompressedTexture(const compressed_texture& texture);
+
+// Function to create a texture from a texture or compressed texture asset, returns the texture or 0
+unsigned int createPackedTexture(const asset_pack& pack, const asset_pack_entry& entry);
+
+#endif // OPENGL_TASKS_TEXTURE_H
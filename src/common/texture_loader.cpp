@@ -0,0 +1,314 @@
+#include "common/texture_loader.h"
+
+#include "common/texture.h"
+
+#include <glad/glad.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+texture_loader::texture_loader(int workerCount, size_t uploadBudget) : uploadBudget(uploadBudget) {
+    // A 2x2 gray checker, it repeats over the whole surface until the real texture is there
+    const unsigned char checker[] = {
+        96, 96, 96, 255,   160, 160, 160, 255,
+        160, 160, 160, 255, 96, 96, 96, 255
+    };
+    placeholder = createTexture(checker, 2, 2, 4);
+    glBindTexture(GL_TEXTURE_2D, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // One region of the budget per frame in flight
+    unpackStream = std::make_unique<stream_buffer>(GL_PIXEL_UNPACK_BUFFER, uploadBudget);
+
+    if (workerCount <= 0) {
+        workerCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&texture_loader::decodeLoop, this);
+    }
+}
+
+texture_loader::~texture_loader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (decoded_image& image : decoded) {
+        stbi_image_free(image.pixels);
+    }
+    stbi_image_free(current.pixels);
+
+    for (entry& e : entries) {
+        if (e.fence) {
+            glDeleteSync(static_cast<GLsync>(e.fence));
+        }
+        if (e.texture) {
+            glDeleteTextures(1, &e.texture);
+        }
+    }
+    glDeleteTextures(1, &placeholder);
+    unpackStream.reset();
+}
+
+void texture_loader::decodeLoop() {
+    while (true) {
+        decode_job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        decoded_image image;
+        image.handle = job.handle;
+
+        compressed_texture blocks;
+        if (isCompressedTexturePath(job.path)) {
+            if (readCompressedTexture(job.path, blocks)) {
+                image.compressed = true;
+                image.blockFormat = blocks.format;
+                image.chain.width = blocks.width;
+                image.chain.height = blocks.height;
+                image.chain.srgb = blocks.srgb;
+                image.chain.levels = std::move(blocks.levels);
+                image.chain.data = std::move(blocks.data);
+            } else {
+                image.error = "cannot read it as a BCn texture";
+            }
+        } else if (readCookedTexture(job.path, image.chain)) {
+            image.channels = image.chain.channels;
+        } else {
+            // Gray images stay one or two channels, RGB gets an alpha channel
+            int width = 0, height = 0, fileChannels = 0;
+            if (stbi_info(job.path.c_str(), &width, &height, &fileChannels)) {
+                image.channels = textureChannels(fileChannels);
+                image.pixels = stbi_load(job.path.c_str(), &width, &height, &fileChannels, image.channels);
+            }
+            if (image.pixels) {
+                image.chain = mip_chain();
+                image.chain.width = width;
+                image.chain.height = height;
+                image.chain.channels = image.channels;
+                image.chain.levels.push_back({width, height, 0, static_cast<size_t>(width) * height * image.channels});
+            } else {
+                image.error = stbi_failure_reason();
+            }
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back(std::move(image));
+        decodeMs += ms;
+    }
+}
+
+const unsigned char* texture_loader::decoded_image::level(size_t index) const {
+    return (pixels ? pixels : chain.data.data()) + chain.levels[index].offset;
+}
+
+int texture_loader::load(const std::string& path, bool srgb) {
+    int handle = static_cast<int>(entries.size());
+    entry e;
+    e.path = path;
+    e.srgb = srgb;
+    entries.push_back(e);
+    totals.requested++;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({handle, path});
+    }
+    wake.notify_one();
+    return handle;
+}
+
+size_t texture_loader::uploadRows(size_t budget) {
+    // Compressed levels go up in rows of blocks, four pixel rows each
+    const mip_level& level = current.chain.levels[currentLevel];
+    const texture_format& format = current.format;
+    int rowHeight = format.blockBytes > 0 ? 4 : 1;
+    int levelRows = (level.height + rowHeight - 1) / rowHeight;
+    size_t rowBytes = format.blockBytes > 0 ? static_cast<size_t>((level.width + 3) / 4) * format.blockBytes
+                                            : static_cast<size_t>(level.width) * current.channels;
+    size_t rows = std::min(budget / rowBytes, static_cast<size_t>(levelRows - currentRow));
+    if (rows == 0) {
+        // A row larger than the whole budget still has to go up, alone in its frame
+        if (budget < uploadBudget) {
+            return 0;
+        }
+        rows = 1;
+    }
+
+    size_t size = rows * rowBytes;
+    const unsigned char* source = current.level(currentLevel) + currentRow * rowBytes;
+    GLint levelIndex = static_cast<GLint>(currentLevel);
+    int y = currentRow * rowHeight;
+    GLsizei height = static_cast<GLsizei>(std::min(static_cast<int>(rows) * rowHeight, level.height - y));
+    entry& e = entries[current.handle];
+    glBindTexture(GL_TEXTURE_2D, e.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(rowBytes));
+
+    auto upload = [&](const void* pixels) {
+        if (format.blockBytes > 0) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, levelIndex, 0, y, level.width, height, format.internalFormat,
+                                      static_cast<GLsizei>(size), pixels);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, levelIndex, 0, y, level.width, height, format.format, GL_UNSIGNED_BYTE,
+                            pixels);
+        }
+    };
+
+    stream_allocation allocation = unpackStream->allocate(size, 4);
+    if (allocation.data) {
+        // The upload reads the rows from the unpack buffer, the pointer is an offset into it
+        std::memcpy(allocation.data, source, size);
+        unpackStream->commit();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackStream->buffer());
+        upload((void*)allocation.offset);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+        // The rows don't fit in the rest of the region: a row is wider than the region, or the alignment
+        // padding of allocate() used up what the budget left. They are copied from client memory instead
+        upload(source);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    currentRow += static_cast<int>(rows);
+    if (currentRow == levelRows) {
+        currentLevel++;
+        currentRow = 0;
+    }
+
+    if (currentLevel == current.chain.levels.size()) {
+        // A decoded image only has its first level, cooked ones have them all
+        if (current.pixels) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        e.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fenced.push_back(current.handle);
+
+        stbi_image_free(current.pixels);
+        current = decoded_image();
+        currentLevel = 0;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return size;
+}
+
+void texture_loader::update() {
+    // Promote the textures whose uploads are done, a zero timeout checks without waiting
+    for (size_t i = 0; i < fenced.size();) {
+        entry& e = entries[fenced[i]];
+        GLenum result = glClientWaitSync(static_cast<GLsync>(e.fence), 0, 0);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            glDeleteSync(static_cast<GLsync>(e.fence));
+            e.fence = nullptr;
+            e.state = texture_state::resident;
+            totals.resident++;
+            fenced[i] = fenced.back();
+            fenced.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    size_t remaining = uploadBudget, frameBytes = 0;
+    while (remaining > 0) {
+        if (current.handle < 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (decoded.empty()) {
+                    break;
+                }
+                current = std::move(decoded.front());
+                decoded.pop_front();
+            }
+
+            entry& e = entries[current.handle];
+            if (current.chain.levels.empty()) {
+                std::cerr << "Failed to load texture " << e.path << ". Error: " << current.error << std::endl;
+                e.state = texture_state::failed;
+                totals.failed++;
+                current = decoded_image();
+                continue;
+            }
+
+            const mip_chain& chain = current.chain;
+            if (current.compressed && !compressedFormatSupported(current.blockFormat)) {
+                std::cerr << "Failed to load texture " << e.path << ". Error: " << blockFormatName(current.blockFormat)
+                          << " is not supported by the context" << std::endl;
+                e.state = texture_state::failed;
+                totals.failed++;
+                current = decoded_image();
+                continue;
+            }
+
+            // Immutable storage for the whole mip chain, the rows follow over the next frames
+            bool srgb = e.srgb || chain.srgb;
+            current.format = current.compressed ? compressedTextureFormat(current.blockFormat, srgb)
+                                                : textureFormat(chain.channels, srgb);
+            e.texture = allocateTexture(current.format, chain.width, chain.height,
+                                        current.pixels ? mipLevelCount(chain.width, chain.height)
+                                                       : static_cast<int>(chain.levels.size()));
+            e.state = texture_state::uploading;
+            if (current.compressed) {
+                totals.compressed++;
+            } else if (!current.pixels) {
+                totals.cooked++;
+            }
+        }
+
+        size_t uploaded = uploadRows(remaining);
+        if (uploaded == 0) {
+            break;
+        }
+        remaining -= std::min(uploaded, remaining);
+        frameBytes += uploaded;
+    }
+
+    totals.uploadedBytes += frameBytes;
+    totals.largestFrameBytes = std::max(totals.largestFrameBytes, frameBytes);
+    unpackStream->endFrame();
+}
+
+unsigned int texture_loader::texture(int handle) const {
+    if (handle < 0 || handle >= static_cast<int>(entries.size()) ||
+        entries[handle].state != texture_state::resident) {
+        return placeholder;
+    }
+    return entries[handle].texture;
+}
+
+texture_state texture_loader::state(int handle) const {
+    if (handle < 0 || handle >= static_cast<int>(entries.size())) {
+        return texture_state::failed;
+    }
+    return entries[handle].state;
+}
+
+bool texture_loader::idle() const {
+    return totals.resident + totals.failed == totals.requested;
+}
+
+texture_loader_stats texture_loader::stats() const {
+    texture_loader_stats result = totals;
+    std::lock_guard<std::mutex> lock(mutex);
+    result.decodeMs = decodeMs;
+    return result;
+}
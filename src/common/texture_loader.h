@@ -0,0 +1,144 @@
+// Asynchronous texture loading.
+//
+// load() returns at once with a handle whose texture is a shared
+// placeholder. Worker threads decode the image files with stb_image into
+// as many channels as they have (texture.h adds alpha to RGB), and
+// update(), called once per frame on the GL thread, streams the decoded
+// pixels into their textures through a pixel unpack stream_buffer: rows
+// are copied into the mapped region of the frame and glTexSubImage2D reads
+// them from the buffer, so the driver never copies from client memory and
+// the CPU never waits for the GPU to finish reading a region. At most
+// uploadBudget bytes are uploaded per frame, large images take several
+// frames, which keeps frame times flat while many textures stream in.
+//
+// When a .mips file cooked by texture_cook from the current image sits
+// next to it (mip_chain.h), the worker reads it instead and every level is
+// uploaded as it is. DDS and KTX2 files with BCn blocks
+// (compressed_texture.h) are read as they are too and go up in rows of
+// blocks with glCompressedTexSubImage2D. Otherwise a texture gets its
+// mipmaps from glGenerateMipmap after its last rows. Either way it then
+// gets a fence, and texture() keeps returning the placeholder until the
+// fence has signaled, so drawing with a texture never waits for its
+// upload.
+
+#ifndef OPENGL_TASKS_TEXTURE_LOADER_H
+#define OPENGL_TASKS_TEXTURE_LOADER_H
+
+#include "common/mip_chain.h"
+#include "common/stream_buffer.h"
+#include "common/texture.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class texture_state { queued, uploading, resident, failed };
+
+struct texture_loader_stats {
+    long requested = 0;
+    long resident = 0;
+    long failed = 0;
+    long cooked = 0;
+    long compressed = 0;
+    size_t uploadedBytes = 0;
+    size_t largestFrameBytes = 0;
+    double decodeMs = 0.0;
+};
+
+class texture_loader {
+public:
+    // workerCount 0 uses one thread less than the hardware has, at least one
+    explicit texture_loader(int workerCount = 0, size_t uploadBudget = 4 << 20);
+
+    // Stops the workers and deletes every texture
+    ~texture_loader();
+
+    texture_loader(const texture_loader&) = delete;
+    texture_loader& operator=(const texture_loader&) = delete;
+
+    // Queues an image, DDS or KTX2 file for decoding, returns its handle. srgb marks color data stored in sRGB.
+    // Files that store their own color space are sRGB if either says so.
+    int load(const std::string& path, bool srgb = false);
+
+    // Uploads decoded images within the budget and promotes finished ones, call it once per frame
+    void update();
+
+    // The texture to bind, the placeholder until the image is resident or if it failed
+    unsigned int texture(int handle) const;
+
+    texture_state state(int handle) const;
+
+    // True when every requested texture is resident or failed
+    bool idle() const;
+
+    texture_loader_stats stats() const;
+
+private:
+    struct decode_job {
+        int handle;
+        std::string path;
+    };
+
+    // Levels read by a worker, or the reason why there are none. A decoded image has one level in
+    // pixels, cooked and compressed ones have all of theirs in the chain.
+    struct decoded_image {
+        int handle = -1;
+        int channels = 0;
+        unsigned char* pixels = nullptr;
+        bool compressed = false;
+        block_format blockFormat = block_format::bc1;
+        mip_chain chain;
+        std::string error;
+
+        // Set when its texture is allocated
+        texture_format format;
+
+        const unsigned char* level(size_t index) const;
+    };
+
+    struct entry {
+        std::string path;
+        texture_state state = texture_state::queued;
+        bool srgb = false;
+        unsigned int texture = 0;
+        void* fence = nullptr;
+    };
+
+    // Function run by each worker thread
+    void decodeLoop();
+
+    // Function to upload rows, or rows of blocks, of the current image, returns the bytes uploaded
+    size_t uploadRows(size_t budget);
+
+    std::vector<entry> entries;
+
+    // Textures whose last rows were uploaded, waiting for their fence
+    std::vector<int> fenced;
+
+    std::unique_ptr<stream_buffer> unpackStream;
+    unsigned int placeholder = 0;
+    size_t uploadBudget;
+
+    // Image being uploaded and the next level and row it needs
+    decoded_image current;
+    size_t currentLevel = 0;
+    int currentRow = 0;
+
+    // Shared with the workers
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<decode_job> pending;
+    std::deque<decoded_image> decoded;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    double decodeMs = 0.0;
+
+    texture_loader_stats totals;
+};
+
+#endif // OPENGL_TASKS_TEXTURE_LOADER_H
@@ -0,0 +1,147 @@
+#include "common/vertex_compression.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+const char* vertexDecodeSource = R"(
+    vec3 decodeOctahedral(vec2 encoded) {
+        vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+        if (direction.z < 0.0) {
+            direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0,
+                                                            direction.y >= 0.0 ? 1.0 : -1.0);
+        }
+        return normalize(direction);
+    }
+)";
+
+glm::mat4 position_quantization::dequantize() const {
+    return glm::scale(glm::translate(glm::mat4(1.0f), minimum), extent);
+}
+
+unorm16x4 position_quantization::encode(glm::vec3 position) const {
+    glm::vec3 unit(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] > 0.0f) {
+            unit[axis] = glm::clamp((position[axis] - minimum[axis]) / extent[axis], 0.0f, 1.0f);
+        }
+    }
+    return unorm16x4{glm::packUnorm1x16(unit.x), glm::packUnorm1x16(unit.y), glm::packUnorm1x16(unit.z), 65535};
+}
+
+glm::vec3 position_quantization::decode(unorm16x4 position) const {
+    glm::vec3 unit(glm::unpackUnorm1x16(position.x), glm::unpackUnorm1x16(position.y),
+                   glm::unpackUnorm1x16(position.z));
+    return minimum + unit * extent;
+}
+
+position_quantization positionQuantization(const glm::vec3* positions, size_t count) {
+    position_quantization quantization;
+    if (count == 0) {
+        return quantization;
+    }
+
+    glm::vec3 minimum = positions[0], maximum = positions[0];
+    for (size_t i = 1; i < count; ++i) {
+        minimum = glm::min(minimum, positions[i]);
+        maximum = glm::max(maximum, positions[i]);
+    }
+    quantization.minimum = minimum;
+    quantization.extent = maximum - minimum;
+    return quantization;
+}
+
+// Function to return -1 for negative values and 1 otherwise, zero included
+static glm::vec2 signNotZero(glm::vec2 value) {
+    return glm::vec2(value.x >= 0.0f ? 1.0f : -1.0f, value.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+snorm16x2 encodeOctahedral(glm::vec3 direction) {
+    // Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the diagonals
+    float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (length == 0.0f) {
+        return snorm16x2(glm::vec2(0.0f));
+    }
+    glm::vec2 encoded = glm::vec2(direction.x, direction.y) / length;
+    if (direction.z < 0.0f) {
+        encoded = (1.0f - glm::abs(glm::vec2(encoded.y, encoded.x))) * signNotZero(encoded);
+    }
+    return snorm16x2(encoded);
+}
+
+glm::vec3 decodeOctahedral(snorm16x2 encoded) {
+    glm::vec2 value(glm::unpackSnorm1x16(static_cast<uint16_t>(encoded.x)),
+                    glm::unpackSnorm1x16(static_cast<uint16_t>(encoded.y)));
+    glm::vec3 direction(value, 1.0f - std::abs(value.x) - std::abs(value.y));
+    if (direction.z < 0.0f) {
+        glm::vec2 folded = (1.0f - glm::abs(glm::vec2(direction.y, direction.x))) * signNotZero(value);
+        direction.x = folded.x;
+        direction.y = folded.y;
+    }
+    return glm::normalize(direction);
+}
+
+glm::vec4 decodeColor(unorm8x4 color) {
+    return glm::vec4(color.r, color.g, color.b, color.a) / 255.0f;
+}
+
+glm::vec2 decodeTexCoord(half2 texCoord) {
+    return glm::vec2(glm::unpackHalf1x16(texCoord.x), glm::unpackHalf1x16(texCoord.y));
+}
+
+void compression_report::position(glm::vec3 original, glm::vec3 decoded) {
+    positionError = std::max(positionError, glm::length(original - decoded));
+}
+
+void compression_report::direction(glm::vec3 original, glm::vec3 decoded) {
+    float cosine = glm::clamp(glm::dot(glm::normalize(original), decoded), -1.0f, 1.0f);
+    directionError = std::max(directionError, glm::degrees(std::acos(cosine)));
+}
+
+void compression_report::color(glm::vec4 original, glm::vec4 decoded) {
+    glm::vec4 difference = glm::abs(original - decoded);
+    colorError = std::max(colorError, std::max(std::max(difference.r, difference.g), std::max(difference.b, difference.a)));
+}
+
+void compression_report::texCoord(glm::vec2 original, glm::vec2 decoded) {
+    texCoordError = std::max(texCoordError, glm::length(original - decoded));
+}
+
+void compression_report::vertices(size_t count, size_t originalStride, size_t compressedStride) {
+    vertexCount += count;
+    originalSize += count * originalStride;
+    compressedSize += count * compressedStride;
+}
+
+size_t compression_report::originalBytes() const {
+    return originalSize;
+}
+
+size_t compression_report::compressedBytes() const {
+    return compressedSize;
+}
+
+void compression_report::print(const char* name) const {
+    // Signed, so a format larger than the original shows a negative saving instead of wrapping around
+    double difference = static_cast<double>(originalSize) - static_cast<double>(compressedSize);
+    double saved = originalSize > 0 ? 100.0 * difference / originalSize : 0.0;
+    std::cout << "Compressed " << vertexCount << " vertices of " << name << " from " << originalSize << " to "
+              << compressedSize << " bytes (" << saved << "% saved), max error:";
+    if (positionError >= 0.0f) {
+        std::cout << " position " << positionError;
+    }
+    if (directionError >= 0.0f) {
+        std::cout << " direction " << directionError << " deg";
+    }
+    if (colorError >= 0.0f) {
+        std::cout << " color " << colorError;
+    }
+    if (texCoordError >= 0.0f) {
+        std::cout << " uv " << texCoordError;
+    }
+    std::cout << std::endl;
+}
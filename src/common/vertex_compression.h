@@ -0,0 +1,84 @@
+// Quantization of float vertex attributes into compact encodings.
+//
+// Each attribute has its own encoder, so a mesh picks the ones it needs
+// and lays the results out with vertex_layout:
+//
+//   - positions become unorm16x4 relative to the AABB of the mesh. The
+//     matrix from positionQuantization().dequantize() maps them back and is
+//     meant to be multiplied into the model transform, so the shader reads
+//     them like plain positions
+//   - normals and tangents become snorm16x2 with the octahedral mapping,
+//     vertexDecodeSource has the GLSL function that turns them back
+//   - colors become unorm8x4 and texture coordinates half2, both decoded
+//     by the vertex fetch
+//
+// The encoders need no GL context, so they work the same offline and while
+// loading. compression_report collects the bytes saved and the largest
+// error of every attribute for a log line.
+
+#ifndef OPENGL_TASKS_VERTEX_COMPRESSION_H
+#define OPENGL_TASKS_VERTEX_COMPRESSION_H
+
+#include "common/vertex_layout.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Bounding box the positions of a mesh are quantized in
+struct position_quantization {
+    glm::vec3 minimum = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(0.0f);
+
+    // Maps a decoded position from [0, 1] back to the box, multiply it into the model transform
+    glm::mat4 dequantize() const;
+
+    unorm16x4 encode(glm::vec3 position) const;
+    glm::vec3 decode(unorm16x4 position) const;
+};
+
+// Function to compute the quantization box of count positions
+position_quantization positionQuantization(const glm::vec3* positions, size_t count);
+
+// Functions to encode a unit vector with the octahedral mapping and decode it again
+snorm16x2 encodeOctahedral(glm::vec3 direction);
+glm::vec3 decodeOctahedral(snorm16x2 encoded);
+
+// Functions to decode the packed types the way the vertex fetch does
+glm::vec4 decodeColor(unorm8x4 color);
+glm::vec2 decodeTexCoord(half2 texCoord);
+
+// GLSL for the vertex shader: vec3 decodeOctahedral(vec2 encoded)
+extern const char* vertexDecodeSource;
+
+// Size and error statistics of a compressed mesh
+class compression_report {
+public:
+    // Functions to record an attribute next to its decoded value
+    void position(glm::vec3 original, glm::vec3 decoded);
+    void direction(glm::vec3 original, glm::vec3 decoded);
+    void color(glm::vec4 original, glm::vec4 decoded);
+    void texCoord(glm::vec2 original, glm::vec2 decoded);
+
+    // Records the vertex count and the size of a vertex before and after compression
+    void vertices(size_t count, size_t originalStride, size_t compressedStride);
+
+    size_t originalBytes() const;
+    size_t compressedBytes() const;
+
+    // Prints the bytes saved and the largest error of each recorded attribute
+    void print(const char* name) const;
+
+private:
+    size_t vertexCount = 0;
+    size_t originalSize = 0, compressedSize = 0;
+
+    // Largest distance for positions and texture coordinates, angle in degrees for directions,
+    // and largest channel difference for colors, or -1 if nothing was recorded
+    float positionError = -1.0f;
+    float directionError = -1.0f;
+    float colorError = -1.0f;
+    float texCoordError = -1.0f;
+};
+
+#endif // OPENGL_TASKS_VERTEX_COMPRESSION_H
@@ -0,0 +1,46 @@
+#include "common/vertex_layout.h"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
+
+half2::half2(glm::vec2 value) : x(glm::packHalf1x16(value.x)), y(glm::packHalf1x16(value.y)) {}
+
+half4::half4(glm::vec4 value)
+    : x(glm::packHalf1x16(value.x)), y(glm::packHalf1x16(value.y)),
+      z(glm::packHalf1x16(value.z)), w(glm::packHalf1x16(value.w)) {}
+
+unorm8x4::unorm8x4(glm::vec4 value)
+    : r(glm::packUnorm1x8(value.r)), g(glm::packUnorm1x8(value.g)),
+      b(glm::packUnorm1x8(value.b)), a(glm::packUnorm1x8(value.a)) {}
+
+unorm16x2::unorm16x2(glm::vec2 value) : x(glm::packUnorm1x16(value.x)), y(glm::packUnorm1x16(value.y)) {}
+
+snorm16x2::snorm16x2(glm::vec2 value)
+    : x(static_cast<int16_t>(glm::packSnorm1x16(value.x))), y(static_cast<int16_t>(glm::packSnorm1x16(value.y))) {}
+
+snorm10x3_2::snorm10x3_2(glm::vec4 value) : bits(glm::packSnorm3x10_1x2(value)) {}
+
+void setupVertexAttributes(const vertex_attribute_desc* attributes, size_t count, GLsizei stride,
+                           unsigned int buffer, GLuint firstLocation, GLuint binding) {
+    // Separate formats and buffer bindings are core in OpenGL 4.3
+    if (GLAD_GL_VERSION_4_3) {
+        for (size_t i = 0; i < count; ++i) {
+            GLuint location = firstLocation + static_cast<GLuint>(i);
+            glVertexAttribFormat(location, attributes[i].components, attributes[i].type, attributes[i].normalized,
+                                 attributes[i].offset);
+            glVertexAttribBinding(location, binding);
+            glEnableVertexAttribArray(location);
+        }
+        glBindVertexBuffer(binding, buffer, 0, stride);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (size_t i = 0; i < count; ++i) {
+        GLuint location = firstLocation + static_cast<GLuint>(i);
+        glVertexAttribPointer(location, attributes[i].components, attributes[i].type, attributes[i].normalized,
+                              stride, (void*)static_cast<size_t>(attributes[i].offset));
+        glEnableVertexAttribArray(location);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
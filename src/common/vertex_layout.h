@@ -0,0 +1,168 @@
+// Vertex formats described once, at compile time.
+//
+// A vertex is a plain struct whose members use either float/glm vectors or
+// the packed types below. vertex_layout lists the members in attribute
+// location order:
+//
+//     struct color_vertex {
+//         glm::vec3 position;
+//         unorm8x4 color;
+//     };
+//     typedef vertex_layout<color_vertex,
+//                           VERTEX_ATTRIBUTE(color_vertex, position),
+//                           VERTEX_ATTRIBUTE(color_vertex, color)> color_vertex_layout;
+//
+// The stride, every offset, GL type, component count and normalization
+// follow from the member types as constants, so they can't disagree with
+// the struct. setupVertexLayout<Layout>() issues glVertexAttribFormat and
+// glVertexAttribBinding on OpenGL 4.3 and glVertexAttribPointer before.
+
+#ifndef OPENGL_TASKS_VERTEX_LAYOUT_H
+#define OPENGL_TASKS_VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Two half floats, read as a vec2
+struct half2 {
+    uint16_t x, y;
+
+    half2() = default;
+    constexpr half2(uint16_t x, uint16_t y) : x(x), y(y) {}
+    explicit half2(glm::vec2 value);
+};
+
+// Four half floats, read as a vec4
+struct half4 {
+    uint16_t x, y, z, w;
+
+    half4() = default;
+    explicit half4(glm::vec4 value);
+};
+
+// Four unsigned bytes normalized to [0, 1], for colors
+struct unorm8x4 {
+    uint8_t r, g, b, a;
+
+    unorm8x4() = default;
+    constexpr unorm8x4(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) : r(r), g(g), b(b), a(a) {}
+    explicit unorm8x4(glm::vec4 value);
+};
+
+// Two unsigned shorts normalized to [0, 1]
+struct unorm16x2 {
+    uint16_t x, y;
+
+    unorm16x2() = default;
+    explicit unorm16x2(glm::vec2 value);
+};
+
+// Four unsigned shorts normalized to [0, 1], for quantized positions
+struct unorm16x4 {
+    uint16_t x, y, z, w;
+};
+
+// Two signed shorts normalized to [-1, 1]
+struct snorm16x2 {
+    int16_t x, y;
+
+    snorm16x2() = default;
+    explicit snorm16x2(glm::vec2 value);
+};
+
+// Three signed 10-bit and one 2-bit component normalized to [-1, 1], for normals (GL_INT_2_10_10_10_REV)
+struct snorm10x3_2 {
+    uint32_t bits;
+
+    snorm10x3_2() = default;
+    explicit snorm10x3_2(glm::vec4 value);
+};
+
+// GL description of an attribute type
+template <typename T>
+struct vertex_attribute_type;
+
+#define VERTEX_ATTRIBUTE_TYPE(T, componentCount, glType, isNormalized)  \
+    template <>                                                         \
+    struct vertex_attribute_type<T> {                                   \
+        static constexpr GLint components = componentCount;             \
+        static constexpr GLenum type = glType;                          \
+        static constexpr GLboolean normalized = isNormalized;           \
+    }
+
+VERTEX_ATTRIBUTE_TYPE(float, 1, GL_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(glm::vec2, 2, GL_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(glm::vec3, 3, GL_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(glm::vec4, 4, GL_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(half2, 2, GL_HALF_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(half4, 4, GL_HALF_FLOAT, GL_FALSE);
+VERTEX_ATTRIBUTE_TYPE(unorm8x4, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+VERTEX_ATTRIBUTE_TYPE(unorm16x2, 2, GL_UNSIGNED_SHORT, GL_TRUE);
+VERTEX_ATTRIBUTE_TYPE(unorm16x4, 4, GL_UNSIGNED_SHORT, GL_TRUE);
+VERTEX_ATTRIBUTE_TYPE(snorm16x2, 2, GL_SHORT, GL_TRUE);
+VERTEX_ATTRIBUTE_TYPE(snorm10x3_2, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+
+#undef VERTEX_ATTRIBUTE_TYPE
+
+// Everything glVertexAttribFormat needs for one attribute
+struct vertex_attribute_desc {
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;
+    GLuint size;
+};
+
+// One member of a vertex struct, see VERTEX_ATTRIBUTE
+template <typename T, size_t Offset>
+struct vertex_attribute {
+    static constexpr vertex_attribute_desc desc = {
+        vertex_attribute_type<T>::components, vertex_attribute_type<T>::type,
+        vertex_attribute_type<T>::normalized, static_cast<GLuint>(Offset), static_cast<GLuint>(sizeof(T))};
+};
+
+#define VERTEX_ATTRIBUTE(vertex, member) vertex_attribute<decltype(vertex::member), offsetof(vertex, member)>
+
+// Compile-time description of a vertex struct, attribute i is read at location i
+template <typename Vertex, typename... Attributes>
+struct vertex_layout {
+    typedef Vertex vertex_type;
+
+    static constexpr GLsizei stride = sizeof(Vertex);
+    static constexpr size_t count = sizeof...(Attributes);
+    static constexpr vertex_attribute_desc attributes[] = {Attributes::desc...};
+
+    // True if every attribute lies inside the vertex and none overlaps the next one
+    static constexpr bool fits() {
+        for (size_t i = 0; i < count; ++i) {
+            if (attributes[i].offset + attributes[i].size > stride) {
+                return false;
+            }
+            for (size_t j = 0; j < count; ++j) {
+                if (i != j && attributes[i].offset < attributes[j].offset + attributes[j].size &&
+                    attributes[j].offset < attributes[i].offset + attributes[i].size) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(count > 0, "a vertex layout needs at least one attribute");
+    static_assert(fits(), "vertex attributes overlap or lie outside the vertex");
+};
+
+// Function to set up the attributes of the bound VAO to read the given buffer, starting at location firstLocation
+void setupVertexAttributes(const vertex_attribute_desc* attributes, size_t count, GLsizei stride,
+                           unsigned int buffer, GLuint firstLocation, GLuint binding);
+
+// Function to set up the attributes of the bound VAO from a compile-time layout
+template <typename Layout>
+void setupVertexLayout(unsigned int buffer, GLuint firstLocation = 0, GLuint binding = 0) {
+    setupVertexAttributes(Layout::attributes, Layout::count, Layout::stride, buffer, firstLocation, binding);
+}
+
+#endif // OPENGL_TASKS_VERTEX_LAYOUT_H
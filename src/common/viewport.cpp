@@ -0,0 +1,58 @@
+#include "common/viewport.h"
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+const char* viewportBlockSource = R"(
+    layout (std140) uniform Viewport {
+        mat4 projection;
+        vec4 size;
+        float aspect;
+    } viewport;
+)";
+
+static unsigned int viewportBuffer = 0;
+static viewport_block viewportValues;
+
+void updateViewport(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        // Minimized windows report a zero size, keep the last block
+        return;
+    }
+
+    float aspect = static_cast<float>(width) / static_cast<float>(height);
+    viewportValues.projection = glm::ortho(-1.0f, 1.0f, -1.0f / aspect, 1.0f / aspect);
+    viewportValues.size = glm::vec4(width, height, 1.0f / width, 1.0f / height);
+    viewportValues.aspect = aspect;
+
+    if (viewportBuffer == 0) {
+        glGenBuffers(1, &viewportBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, viewportBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(viewport_block), &viewportValues, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, viewportBinding, viewportBuffer);
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, viewportBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(viewport_block), &viewportValues);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+bool bindViewportBlock(unsigned int program) {
+    unsigned int index = glGetUniformBlockIndex(program, "Viewport");
+    if (index == GL_INVALID_INDEX) {
+        return false;
+    }
+    glUniformBlockBinding(program, index, viewportBinding);
+    return true;
+}
+
+const viewport_block& currentViewport() {
+    return viewportValues;
+}
+
+void releaseViewport() {
+    if (viewportBuffer != 0) {
+        glDeleteBuffers(1, &viewportBuffer);
+        viewportBuffer = 0;
+    }
+}
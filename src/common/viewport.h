@@ -0,0 +1,47 @@
+// Viewport uniform block shared by all programs.
+//
+// The window backend keeps one uniform buffer bound to binding point
+// viewportBinding. It holds the size of the framebuffer, its aspect ratio
+// and an orthographic projection that keeps shapes round: x spans [-1, 1]
+// across the width and y as much as the aspect ratio allows. Resizes are
+// coalesced, pollEvents() writes the block at most once per frame with the
+// last size the window reported, so geometry can stay static in GPU memory
+// and shaders apply the aspect correction:
+//
+//     gl_Position = viewport.projection * vec4(aPos, 0.0, 1.0);
+//
+// Programs get the block declaration from viewportBlockSource and are
+// connected to the binding point with bindViewportBlock().
+
+#ifndef OPENGL_TASKS_VIEWPORT_H
+#define OPENGL_TASKS_VIEWPORT_H
+
+#include <glm/glm.hpp>
+
+// Uniform buffer binding point of the Viewport block
+static const unsigned int viewportBinding = 0;
+
+// std140 layout of the Viewport block
+struct viewport_block {
+    glm::mat4 projection;
+    glm::vec4 size;  // width, height, 1 / width, 1 / height in pixels
+    float aspect;    // width / height
+    float padding[3];
+};
+
+// GLSL declaration of the block, paste it after the #version line
+extern const char* viewportBlockSource;
+
+// Function to write the block for a framebuffer of the given size, creating its buffer on first use
+void updateViewport(int width, int height);
+
+// Function to connect the Viewport block of a program to the shared buffer, returns false if it has none
+bool bindViewportBlock(unsigned int program);
+
+// The values last written by updateViewport()
+const viewport_block& currentViewport();
+
+// Function to delete the buffer of the block, called before the context goes away
+void releaseViewport();
+
+#endif // OPENGL_TASKS_VIEWPORT_H
@@ -0,0 +1,400 @@
+#include "common/window.h"
+
+#include "common/frame_benchmark.h"
+#include "common/gpu_profiler.h"
+#include "common/shader.h"
+#include "common/shader_asset.h"
+#include "common/viewport.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#ifdef OPENGL_TASKS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#endif
+
+// Frame limit used by headless runs that did not ask for a specific count
+static const long defaultHeadlessFrames = 600;
+
+// Extensions of the current context, read by the first hasExtension() call
+static std::unordered_set<std::string> contextExtensions;
+static bool contextExtensionsRead = false;
+
+window_options& windowOptions() {
+    static window_options options;
+    return options;
+}
+
+#ifdef OPENGL_TASKS_EGL
+// Function to create a surfaceless EGL context with an FBO as render target
+static window_context* setupHeadlessContext(int width, int height, int glMajor, int glMinor) {
+    // Prefer the Mesa surfaceless platform, it needs neither a display server nor a GPU
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return nullptr;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+        eglTerminate(display);
+        return nullptr;
+    }
+
+    // No surface is ever created, so the context does not need a config
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, glMajor,
+        EGL_CONTEXT_MINOR_VERSION, glMinor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        eglTerminate(display);
+        return nullptr;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "Failed to make the EGL context current" << std::endl;
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return nullptr;
+    }
+
+    // Initialize GLAD
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return nullptr;
+    }
+
+    auto* window = new window_context;
+    window->eglDisplay = display;
+    window->eglContext = context;
+    window->width = width;
+    window->height = height;
+    window->pendingWidth = width;
+    window->pendingHeight = height;
+
+    // Offscreen framebuffer standing in for the default framebuffer of a window
+    glGenRenderbuffers(1, &window->colorRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->colorRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &window->depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &window->FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, window->FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->colorRBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, window->depthRBO);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer is not complete" << std::endl;
+        terminateWindow(window);
+        return nullptr;
+    }
+
+    std::cout << "Headless context: " << glGetString(GL_RENDERER) << ", OpenGL " << glGetString(GL_VERSION) << std::endl;
+
+    return window;
+}
+#endif
+
+#ifdef OPENGL_TASKS_GLFW
+// Records the size, a window drag reports many of them and only the last one per frame is applied
+static void recordFramebufferSize(GLFWwindow* glfwWindow, int width, int height) {
+    auto* window = static_cast<window_context*>(glfwGetWindowUserPointer(glfwWindow));
+    window->pendingWidth = width;
+    window->pendingHeight = height;
+}
+
+// Function to create a GLFW window and make its context current
+static window_context* setupGlfwWindow(int width, int height, const char* title, int glMajor, int glMinor) {
+    // Initialize GLFW
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return nullptr;
+    }
+
+    // Configure GLFW
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glMajor);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glMinor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Create a GLFW windowed mode window and its OpenGL context
+    GLFWwindow* glfwWindow = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    if (!glfwWindow) {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+
+    // Make the window's context current
+    glfwMakeContextCurrent(glfwWindow);
+
+    // Initialize GLAD
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+
+    auto* window = new window_context;
+    window->window = glfwWindow;
+    window->width = width;
+    window->height = height;
+    window->pendingWidth = width;
+    window->pendingHeight = height;
+
+    glfwSetWindowUserPointer(glfwWindow, window);
+    glfwSetFramebufferSizeCallback(glfwWindow, recordFramebufferSize);
+
+    return window;
+}
+#endif
+
+window_context* setupWindow(int width, int height, [[maybe_unused]] const char* title, int glMajor, int glMinor) {
+    window_context* window = nullptr;
+
+    if (windowOptions().headless) {
+#ifdef OPENGL_TASKS_EGL
+        window = setupHeadlessContext(width, height, glMajor, glMinor);
+#else
+        std::cerr << "This build has no headless (EGL) backend" << std::endl;
+#endif
+    } else {
+#ifdef OPENGL_TASKS_GLFW
+        window = setupGlfwWindow(width, height, title, glMajor, glMinor);
+#else
+        std::cerr << "This build has no GLFW backend, run the task with --headless" << std::endl;
+#endif
+    }
+
+    if (!window) {
+        return nullptr;
+    }
+
+    // Set up viewport and the Viewport block
+    glViewport(0, 0, width, height);
+    updateViewport(width, height);
+
+    // Benchmark runs measure the raw frame time, so VSync stays off
+    if (benchmarkOptions().enabled) {
+        setSwapInterval(window, 0);
+    }
+
+    benchmarkBegin();
+    profilerBegin();
+
+    window->startTime = std::chrono::steady_clock::now();
+
+    return window;
+}
+
+bool windowShouldClose(window_context* window) {
+    long maxFrames = windowOptions().maxFrames;
+    if (benchmarkFrameLimit() > 0) {
+        maxFrames = benchmarkFrameLimit();
+    }
+    if (!window->window && maxFrames <= 0) {
+        maxFrames = defaultHeadlessFrames;
+    }
+
+    if (maxFrames > 0 && window->frameCount >= maxFrames) {
+        return true;
+    }
+
+#ifdef OPENGL_TASKS_GLFW
+    if (window->window) {
+        return glfwWindowShouldClose(window->window);
+    }
+#endif
+
+    return false;
+}
+
+void swapBuffers(window_context* window) {
+    profilerBeforeSwap();
+    benchmarkBeforeSwap();
+
+#ifdef OPENGL_TASKS_GLFW
+    if (window->window) {
+        glfwSwapBuffers(window->window);
+    }
+#endif
+
+    // There is no presentation to wait for, finishing the frame keeps the frame rate honest
+    if (!window->window) {
+        glFinish();
+    }
+
+    benchmarkAfterSwap();
+    profilerAfterSwap();
+
+    // The shaders a task needs are built before its first frame
+    if (window->frameCount == 0) {
+        reportShaderBuildTime();
+    }
+
+    window->frameCount++;
+}
+
+void pollEvents(window_context* window) {
+#ifdef OPENGL_TASKS_GLFW
+    if (window->window) {
+        glfwPollEvents();
+    }
+#endif
+
+    // Apply the last reported size, however many resize events came in since the previous frame
+    if (window->pendingWidth != window->width || window->pendingHeight != window->height) {
+        window->width = window->pendingWidth;
+        window->height = window->pendingHeight;
+        glViewport(0, 0, window->width, window->height);
+        updateViewport(window->width, window->height);
+
+        if (window->framebufferSizeCallback) {
+            window->framebufferSizeCallback(window->window, window->width, window->height);
+        }
+    }
+
+    // Swap in the shaders that were edited, the next frame draws with them
+    updateShaderAssets();
+}
+
+void setSwapInterval([[maybe_unused]] window_context* window, [[maybe_unused]] int interval) {
+    if (benchmarkOptions().enabled) {
+        interval = 0;
+    }
+
+#ifdef OPENGL_TASKS_GLFW
+    if (window->window) {
+        glfwSwapInterval(interval);
+    }
+#endif
+}
+
+void setFramebufferSizeCallback(window_context* window, GLFWframebuffersizefun callback) {
+    window->framebufferSizeCallback = callback;
+}
+
+void* getProcAddress(const char* name) {
+    if (windowOptions().headless) {
+#ifdef OPENGL_TASKS_EGL
+        return (void*)eglGetProcAddress(name);
+#endif
+    } else {
+#ifdef OPENGL_TASKS_GLFW
+        return (void*)glfwGetProcAddress(name);
+#endif
+    }
+    return nullptr;
+}
+
+bool hasExtension(const char* name) {
+    if (!contextExtensionsRead) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+            if (extension) {
+                contextExtensions.insert(reinterpret_cast<const char*>(extension));
+            }
+        }
+        contextExtensionsRead = true;
+    }
+    return contextExtensions.count(name) > 0;
+}
+
+// Function to write the current color buffer to a binary PPM file
+static void saveScreenshot(window_context* window, const std::string& path) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(window->width) * window->height * 3);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window->width, window->height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return;
+    }
+
+    // OpenGL rows start at the bottom, PPM rows at the top
+    std::fprintf(file, "P6\n%d %d\n255\n", window->width, window->height);
+    const size_t rowSize = static_cast<size_t>(window->width) * 3;
+    for (int y = window->height - 1; y >= 0; --y) {
+        std::fwrite(pixels.data() + y * rowSize, 1, rowSize, file);
+    }
+    std::fclose(file);
+}
+
+void terminateWindow(window_context* window) {
+    if (!window) {
+        return;
+    }
+
+    // Report the average frame rate of the whole run
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - window->startTime).count();
+    if (window->frameCount > 0 && seconds > 0.0) {
+        std::cout << "Rendered " << window->frameCount << " frames in " << seconds << " s, FPS: "
+                  << window->frameCount / seconds << std::endl;
+    }
+
+    if (!windowOptions().screenshotPath.empty() && window->frameCount > 0) {
+        saveScreenshot(window, windowOptions().screenshotPath);
+    }
+
+    benchmarkEnd();
+    profilerEnd();
+    releaseViewport();
+    releaseSharedShaderQueue();
+
+    // The next context may expose other extensions
+    contextExtensions.clear();
+    contextExtensionsRead = false;
+
+#ifdef OPENGL_TASKS_EGL
+    if (window->eglContext) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &window->FBO);
+        glDeleteRenderbuffers(1, &window->colorRBO);
+        glDeleteRenderbuffers(1, &window->depthRBO);
+
+        eglMakeCurrent(window->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(window->eglDisplay, window->eglContext);
+        eglTerminate(window->eglDisplay);
+    }
+#endif
+
+#ifdef OPENGL_TASKS_GLFW
+    if (window->window) {
+        // Terminate GLFW
+        glfwTerminate();
+    }
+#endif
+
+    delete window;
+}
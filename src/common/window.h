@@ -0,0 +1,93 @@
+// Window and context setup shared by all tasks.
+//
+// A task asks for a window with setupWindow() and drives its main loop with
+// windowShouldClose()/swapBuffers()/pollEvents(). Depending on the options
+// chosen in main.cpp, the returned window is either a regular GLFW window or
+// a headless EGL context that renders into an offscreen framebuffer object,
+// so the same task code runs on machines without a display or a GPU
+// (for example Mesa llvmpipe on a render farm node).
+
+#ifndef OPENGL_TASKS_WINDOW_H
+#define OPENGL_TASKS_WINDOW_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <string>
+
+// Options for the window backend, filled in by main.cpp before a task starts
+struct window_options {
+    // Render with an EGL surfaceless context into an FBO instead of a window
+    bool headless = false;
+
+    // Number of frames after which windowShouldClose() returns true (0 = unlimited).
+    // Headless runs always stop, so they fall back to 600 frames when this is 0.
+    // Benchmark runs use their warmup and measured frame counts instead.
+    long maxFrames = 0;
+
+    // Write the last rendered frame to a binary PPM file on terminateWindow()
+    std::string screenshotPath;
+};
+
+// Window or offscreen surface a task renders into
+struct window_context {
+    // GLFW window, nullptr for headless contexts
+    GLFWwindow* window = nullptr;
+
+    // EGL display and context for headless contexts
+    void* eglDisplay = nullptr;
+    void* eglContext = nullptr;
+
+    // Offscreen framebuffer and its attachments for headless contexts
+    unsigned int FBO = 0;
+    unsigned int colorRBO = 0;
+    unsigned int depthRBO = 0;
+
+    int width = 0;
+    int height = 0;
+
+    // Latest framebuffer size reported by GLFW, applied once per frame by pollEvents()
+    int pendingWidth = 0;
+    int pendingHeight = 0;
+
+    // Task callback for size changes, called by pollEvents() after the viewport was updated
+    GLFWframebuffersizefun framebufferSizeCallback = nullptr;
+
+    // Frame counting for the frames-per-second report
+    long frameCount = 0;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// Global options for the window backend
+window_options& windowOptions();
+
+// Function to set up the window (or the headless context) and initialize GLAD
+window_context* setupWindow(int width, int height, const char* title, int glMajor = 3, int glMinor = 3);
+
+// Returns true when the main loop of a task should stop
+bool windowShouldClose(window_context* window);
+
+// Presents the frame (or finishes it for headless contexts) and counts it
+void swapBuffers(window_context* window);
+
+// Processes pending window events, a resize updates the viewport and the Viewport block once
+void pollEvents(window_context* window);
+
+// Sets the swap interval, 0 disables VSync (always 0 while benchmarking)
+void setSwapInterval(window_context* window, int interval);
+
+// Registers a callback for framebuffer size changes, called at most once per frame from pollEvents()
+// with the last size (never called for headless contexts)
+void setFramebufferSizeCallback(window_context* window, GLFWframebuffersizefun callback);
+
+// Returns the address of an OpenGL function from the active context backend
+void* getProcAddress(const char* name);
+
+// Returns true if the current context exposes the named extension, the list is read once per context
+bool hasExtension(const char* name);
+
+// Reports the frame rate, destroys the window or context and releases the backend
+void terminateWindow(window_context* window);
+
+#endif // OPENGL_TASKS_WINDOW_H
@@ -1,5 +1,151 @@
-#include "tasks/task5/task_5.cpp"
+#include "common/frame_benchmark.h"
+#include "common/gpu_profiler.h"
+#include "common/shader.h"
+#include "common/shader_asset.h"
+#include "common/task_registry.h"
+#include "common/window.h"
 
-int main() {
-    return main_task_5();
-}
\ No newline at end of file
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Function to print the command line usage and the registered tasks
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " <task>... [options]\n"
+              << "\n"
+              << "Runs the given tasks one after another, 'all' runs every task.\n"
+              << "\n"
+              << "Options:\n"
+              << "  --list              list the registered tasks\n"
+              << "  --headless          render offscreen with EGL instead of opening a window\n"
+              << "  --frames <count>    stop after the given number of frames (measured frames when benchmarking)\n"
+              << "  --screenshot <path> save the last frame as a PPM image\n"
+              << "  --benchmark <path>  benchmark the tasks with VSync off and write the statistics as JSON\n"
+              << "  --warmup <count>    frames rendered before a benchmark starts measuring (default 60)\n"
+              << "  --profile           print CPU and GPU time per profiled zone every second\n"
+              << "  --shader-cache <dir> directory of the program binary cache (default shader_cache)\n"
+              << "  --no-shader-cache   always compile shaders from source\n"
+              << "  --shader-dir <dir>  directory of the task .glsl files (default the source tree, then shaders/)\n"
+              << "\n"
+              << "Tasks:\n";
+
+    // Keep the descriptions aligned with the options unless a task name is longer
+    size_t width = 20;
+    for (const task_entry& entry : registeredTasks()) {
+        width = std::max(width, std::strlen(entry.name) + 1);
+    }
+
+    for (const task_entry& entry : registeredTasks()) {
+        std::cout << "  " << std::left << std::setw(static_cast<int>(width)) << entry.name << entry.description << "\n";
+    }
+}
+
+// Function to parse a positive frame count, returns false on anything else
+static bool parseCount(const char* text, long& count) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value <= 0) {
+        return false;
+    }
+    count = value;
+    return true;
+}
+
+// Function to find the directory of the running executable, the build copies the shaders next to it
+static std::string executableDirectory(const char* program) {
+    std::error_code error;
+#ifdef __linux__
+    std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (!error) {
+        return path.parent_path().string();
+    }
+#endif
+    return std::filesystem::absolute(program, error).parent_path().string();
+}
+
+int main(int argc, char** argv) {
+    std::vector<const task_entry*> tasks;
+    shaderAssetOptions().executableDirectory = executableDirectory(argv[0]);
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--list") == 0 || std::strcmp(argv[i], "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            windowOptions().headless = true;
+        } else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            long frames = 0;
+            if (!parseCount(argv[++i], frames)) {
+                std::cerr << "--frames needs a positive count, got " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+            windowOptions().maxFrames = frames;
+            benchmarkOptions().measuredFrames = frames;
+        } else if (std::strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) {
+            windowOptions().screenshotPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+            benchmarkOptions().enabled = true;
+            benchmarkOptions().outputPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            long warmup = 0;
+            if (!parseCount(argv[++i], warmup)) {
+                std::cerr << "--warmup needs a positive count, got " << argv[i] << std::endl;
+                printUsage(argv[0]);
+                return -1;
+            }
+            benchmarkOptions().warmupFrames = warmup;
+        } else if (std::strcmp(argv[i], "--profile") == 0) {
+            profilerOptions().enabled = true;
+        } else if (std::strcmp(argv[i], "--shader-cache") == 0 && i + 1 < argc) {
+            shaderCacheOptions().directory = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-shader-cache") == 0) {
+            shaderCacheOptions().enabled = false;
+        } else if (std::strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc) {
+            shaderAssetOptions().directory = argv[++i];
+        } else if (std::strcmp(argv[i], "all") == 0) {
+            for (const task_entry& entry : registeredTasks()) {
+                tasks.push_back(&entry);
+            }
+        } else if (argv[i][0] != '-' && findTask(argv[i])) {
+            tasks.push_back(findTask(argv[i]));
+        } else {
+            std::cerr << "Unknown task or option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (tasks.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    // Run the tasks back to back, each one creates and destroys its own window
+    int result = 0;
+    for (const task_entry* task : tasks) {
+        if (tasks.size() > 1) {
+            std::cout << "== " << task->name << std::endl;
+        }
+
+        benchmarkOptions().taskName = task->name;
+
+        if (task->function() != 0) {
+            std::cerr << "Task " << task->name << " failed" << std::endl;
+            result = -1;
+        }
+    }
+
+    if (benchmarkOptions().enabled && !writeBenchmarkResults(benchmarkOptions().outputPath)) {
+        result = -1;
+    }
+
+    return result;
+}
@@ -11,67 +11,44 @@
 // * The window's OpenGL context is set as the current context with `glfwMakeContextCurrent()`.
 // 2. Initialize GLAD:
 // * GLAD is initialized with `gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)`.
+// These steps live in `setupWindow()` in src/common/window.cpp, which can also
+// create a headless EGL context instead of a window. Resizes are applied by
+// `pollEvents()`, which updates the viewport once per frame.
 
 // https://learnopengl.com/Getting-started/Hello-Window
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
-
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
+#include "common/task_registry.h"
+#include "common/window.h"
 
 int main_task_1() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // Create a GLFW windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Window", nullptr, nullptr);
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
 
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
-
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Rendering commands go here
         // Clear the color buffer with the specified clear color
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
-    glfwTerminate();
+    terminateWindow(window);
     return 0;
 }
+
+REGISTER_TASK("task_1", "Task 1: an empty window", main_task_1);
@@ -1,73 +1,50 @@
 // This is a modified version of task_1.cpp
-// with a maximum frame rate of 60 fps.
+// with a maximum frame rate of 60 fps (120 and 144 fps variants are registered too).
 
-// The result frame rate may be lower than 60 fps
-// due to the accuracy of the sleep mechanism or other reasons.
+// The frames are paced by frame_pacer (src/common/frame_pacer.h): it targets
+// absolute deadlines, so the time spent rendering does not add up as drift,
+// and it spins for the last stretch before a deadline because sleep_for alone
+// tends to overshoot.
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "common/frame_pacer.h"
+#include "common/task_registry.h"
+#include "common/window.h"
 #include <iostream>
 
 #include <chrono>
-#include <thread>
 
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
-int main_task_1() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // Create a GLFW windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Window", nullptr, nullptr);
+static int runFrameRateTask(double targetFps) {
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
-
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
         return -1;
     }
 
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Disnable VSync
-    glfwSwapInterval(0);
+    setSwapInterval(window, 0);
 
     // Variables for FPS calculation
     int frameCount = 0;
     auto lastTime = std::chrono::high_resolution_clock::now();
-    auto start = std::chrono::high_resolution_clock::now();
+
+    // Limit the frame rate
+    frame_pacer pacer(targetFps);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
 
         // Rendering commands go here
         // Clear the color buffer with the specified clear color
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
 
         // Calculate FPS
         frameCount++;
@@ -76,29 +53,40 @@ int main_task_1() {
 
         if (elapsedTime >= 1) {
             double fps = frameCount / static_cast<double>(elapsedTime);
-            std::cout << "FPS: " << fps << std::endl;
+            pacing_stats stats = pacer.stats();
+            std::cout << "FPS: " << fps
+                      << ", interval " << stats.meanIntervalMs << " ms"
+                      << " (jitter " << stats.intervalStdDevMs << " ms"
+                      << ", max late " << stats.maxLateMs << " ms"
+                      << ", missed " << stats.missedDeadlines << ")" << std::endl;
 
             // Reset variables
             frameCount = 0;
             lastTime = currentTime;
+            pacer.resetStats();
         }
 
-        // Calculate the time to wait for the next frame
-        double frameTime = 1.0 / 60.0;
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-
-        double sleepTime = frameTime - duration.count() * 1e-6;
-
-        if (sleepTime > 0.0) {
-            std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
-        }
-
-        start = std::chrono::high_resolution_clock::now();
+        // Wait for the deadline of the next frame
+        pacer.waitForNextFrame();
     }
 
     // Cleanup
-    glfwTerminate();
+    terminateWindow(window);
     return 0;
 }
+
+int main_task_frame_rate() {
+    return runFrameRateTask(60.0);
+}
+
+int main_task_frame_rate_120() {
+    return runFrameRateTask(120.0);
+}
+
+int main_task_frame_rate_144() {
+    return runFrameRateTask(144.0);
+}
+
+REGISTER_TASK("task_frame_rate", "Task 1 limited to 60 frames per second", main_task_frame_rate);
+REGISTER_TASK("task_frame_rate_120", "Task 1 limited to 120 frames per second", main_task_frame_rate_120);
+REGISTER_TASK("task_frame_rate_144", "Task 1 limited to 144 frames per second", main_task_frame_rate_144);
@@ -10,169 +10,84 @@
 // Modularize the process by creating a function for shader initialization
 // and another function for rendering a shape.
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
-
-const char* vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec2 aPos;
-    void main() {
-        gl_Position = vec4(aPos, 0.0, 1.0);
-    }
-)";
-
-const char* fragmentShaderSource = R"(
-    #version 330 core
-    out vec4 FragColor;
-    void main() {
-        FragColor = vec4(1.0, 0.5, 0.2, 1.0);
-    }
-)";
-
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
+#include "common/buffer_allocator.h"
+#include "common/gpu_profiler.h"
+#include "common/shader_asset.h"
+#include "common/task_registry.h"
+#include "common/window.h"
 
-// Function to set up the window
-GLFWwindow* setupWindow() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return nullptr;
-    }
-
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    const int width = 800, height = 600;
-
-    // Create a GLFW windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(width, height, "OpenGL Window", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return nullptr;
-    }
+#include <iostream>
+#include <memory>
 
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
+// The shaders are loaded from task2/*.glsl in the shader directory and reloaded when the files are edited
+static const char* vertexShaderPath = "task2/vertex_shader.glsl";
+static const char* fragmentShaderPath = "task2/fragment_shader.glsl";
 
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return nullptr;
-    }
+// Size of the vertex buffer block the shapes are sub-allocated from
+static const size_t shapeBufferSize = 64 * 1024;
 
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    return window;
+// A shape is a range of the shared vertex buffer, drawn through the shared VAO
+struct shape_output
+{
+    int allocation;
+    int verticesCount;
 };
 
-// Function to initialize shaders
-unsigned int initializeShaders(const char* vertexShaderSource, const char* fragmentShaderSource) {
-    // Load and compile shaders
-    unsigned int vertexShader, fragmentShader;
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Vertex shader compilation failed:\n" << infoLog << std::endl;
-    }
+// Function to set up the VAO shared by all shapes, renderShape() points its attribute at the shape
+static unsigned int setupShapeArray() {
+    unsigned int VAO;
+    glGenVertexArrays(1, &VAO);
 
-    // Fragment Shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    glBindVertexArray(VAO);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
 
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "Fragment shader compilation failed:\n" << infoLog << std::endl;
-    }
+    return VAO;
+}
 
-    // Shader Program
-    unsigned int shaderProgram;
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
+// Function to copy the vertices of a shape into the shared vertex buffer
+static shape_output setupShape(buffer_allocator& buffers, const float* vertices, int verticesCount) {
+    // Each vertex is an x, y pair
+    size_t size = verticesCount * sizeof(float);
+    int allocation = buffers.allocate(size, 2 * sizeof(float));
+    if (allocation >= 0) {
+        buffers.upload(allocation, vertices, size);
     }
 
-    // Delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
+    return shape_output{allocation, verticesCount / 2};
 }
 
 // Function to render a shape
-void renderShape(unsigned int VAO, unsigned int shaderProgram, int verticesCount) {
+static void renderShape(unsigned int VAO, const buffer_allocator& buffers, const shape_output& shape,
+                        unsigned int shaderProgram) {
+    // Measure the CPU and GPU time of drawing the shape
+    PROFILE_ZONE("renderShape");
+
+    if (shape.allocation < 0) {
+        return;
+    }
+
     // Use the shader program
     glUseProgram(shaderProgram);
 
-    // Bind the VAO
+    // Bind the VAO and point it at the range of the shape
     glBindVertexArray(VAO);
+    const buffer_range& range = buffers.range(shape.allocation);
+    glBindBuffer(GL_ARRAY_BUFFER, range.buffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)range.offset);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     // Draw the shape
-    glDrawArrays(GL_TRIANGLE_FAN, 0, verticesCount);
+    glDrawArrays(GL_TRIANGLE_FAN, 0, shape.verticesCount);
 
     // Unbind the VAO
     glBindVertexArray(0);
 }
 
-struct shape_output
-{
-    unsigned int VAO;
-    unsigned int VBO;
-};
-
-// Function to set up a VAO and VBO for a shape
-shape_output setupShape(const float* vertices, int verticesCount) {
-    // Vertex Array Object (VAO) and Vertex Buffer Object (VBO)
-    unsigned int VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    // Bind the VAO
-    glBindVertexArray(VAO);
-
-    // Bind and set vertex buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesCount * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    // Set the vertex attribute pointers
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0);
-
-    // Unbind VAO and VBO
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return shape_output{VAO, VBO};
-}
-
 // Main function to display a triangle
 int main_triangle() {
-    GLFWwindow* window = setupWindow();
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
         return -1;
     }
@@ -184,43 +99,52 @@ int main_triangle() {
     };
 
     // Create shader program and VAO, VBO for the triangle
-    unsigned int shaderProgram = initializeShaders(vertexShaderSource, fragmentShaderSource);
-    auto [VAO_triangle, VBO_triangle] = setupShape(vertices_triangle, 6);
+    auto shader = std::make_unique<shader_asset>(vertexShaderPath, fragmentShaderPath);
+    if (!shader->loaded()) {
+        terminateWindow(window);
+        return -1;
+    }
+    // Shapes share one vertex buffer block and one VAO
+    auto buffers = std::make_unique<buffer_allocator>(GL_ARRAY_BUFFER, shapeBufferSize);
+    unsigned int VAO = setupShapeArray();
+    shape_output triangle = setupShape(*buffers, vertices_triangle, 6);
 
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Render the triangle
-        renderShape(VAO_triangle, shaderProgram, 3);
+        renderShape(VAO, *buffers, triangle, shader->program());
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
-    glDeleteVertexArrays(1, &VAO_triangle);
-    glDeleteBuffers(1, &VBO_triangle);
+    glDeleteVertexArrays(1, &VAO);
+    buffers.reset();
+    shader.reset();
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
 
 // Main function to display a rectangle
 int main_rectangle() {
-    GLFWwindow* window = setupWindow();
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
         return -1;
     }
@@ -233,43 +157,52 @@ int main_rectangle() {
     };
 
     // Create shader program and VAO, VBO for the rectangle
-    unsigned int shaderProgram = initializeShaders(vertexShaderSource, fragmentShaderSource);
-    auto [VAO_rectangle, VBO_rectangle] = setupShape(vertices_rectangle, 8);
+    auto shader = std::make_unique<shader_asset>(vertexShaderPath, fragmentShaderPath);
+    if (!shader->loaded()) {
+        terminateWindow(window);
+        return -1;
+    }
+    // Shapes share one vertex buffer block and one VAO
+    auto buffers = std::make_unique<buffer_allocator>(GL_ARRAY_BUFFER, shapeBufferSize);
+    unsigned int VAO = setupShapeArray();
+    shape_output rectangle = setupShape(*buffers, vertices_rectangle, 8);
 
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Render the rectangle
-        renderShape(VAO_rectangle, shaderProgram, 4);
+        renderShape(VAO, *buffers, rectangle, shader->program());
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
-    glDeleteVertexArrays(1, &VAO_rectangle);
-    glDeleteBuffers(1, &VBO_rectangle);
+    glDeleteVertexArrays(1, &VAO);
+    buffers.reset();
+    shader.reset();
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
 
 // Main function to display a triangle and a rectangle side by side
 int main_two_shapes() {
-    GLFWwindow* window = setupWindow();
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
         return -1;
     }
@@ -288,46 +221,56 @@ int main_two_shapes() {
     };
 
     // Create shader program
-    unsigned int shaderProgram = initializeShaders(vertexShaderSource, fragmentShaderSource);
+    auto shader = std::make_unique<shader_asset>(vertexShaderPath, fragmentShaderPath);
+    if (!shader->loaded()) {
+        terminateWindow(window);
+        return -1;
+    }
 
-    // create VAO, VBO for the triangle
-    auto [VAO_triangle, VBO_triangle] = setupShape(vertices_triangle, 6);
-    
-    // create VAO, VBO for the rectangle
-    auto [VAO_rectangle, VBO_rectangle] = setupShape(vertices_rectangle, 8);
+    // Shapes share one vertex buffer block and one VAO
+    auto buffers = std::make_unique<buffer_allocator>(GL_ARRAY_BUFFER, shapeBufferSize);
+    unsigned int VAO = setupShapeArray();
+
+    // Copy the triangle into the shared buffer
+    shape_output triangle = setupShape(*buffers, vertices_triangle, 6);
+
+    // Copy the rectangle into the shared buffer
+    shape_output rectangle = setupShape(*buffers, vertices_rectangle, 8);
 
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
         // Render the triangle
-        renderShape(VAO_triangle, shaderProgram, 3);
+        renderShape(VAO, *buffers, triangle, shader->program());
 
         // Render the rectangle
-        renderShape(VAO_rectangle, shaderProgram, 4);
+        renderShape(VAO, *buffers, rectangle, shader->program());
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
-    glDeleteVertexArrays(1, &VAO_triangle);
-    glDeleteBuffers(1, &VBO_triangle);
-    glDeleteVertexArrays(1, &VAO_rectangle);
-    glDeleteBuffers(1, &VBO_rectangle);
+    buffer_allocator_stats stats = buffers->stats();
+    std::cout << "Shape buffers: " << stats.allocations << " shapes, " << stats.usedBytes << " of "
+              << stats.reservedBytes << " bytes used in " << stats.blocks << " block(s)" << std::endl;
+    glDeleteVertexArrays(1, &VAO);
+    buffers.reset();
+    shader.reset();
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
@@ -340,3 +283,7 @@ int main_task_2() {
 
     return 0;
 }
+
+REGISTER_TASK("task_2", "Task 2: a triangle and a rectangle side by side", main_task_2);
+REGISTER_TASK("task_2_triangle", "Task 2: a triangle using the shared helper functions", main_triangle);
+REGISTER_TASK("task_2_rectangle", "Task 2: a rectangle using the shared helper functions", main_rectangle);
@@ -10,11 +10,11 @@
 // Drawing a triangle:
 // https://learnopengl.com/Getting-started/Hello-Triangle
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
+#include "common/shader.h"
+#include "common/task_registry.h"
+#include "common/window.h"
 
-const char* vertexShaderSource = R"(
+static const char* vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec2 aPos;
     void main() {
@@ -22,7 +22,7 @@ const char* vertexShaderSource = R"(
     }
 )";
 
-const char* fragmentShaderSource = R"(
+static const char* fragmentShaderSource = R"(
     #version 330 core
     out vec4 FragColor;
     void main() {
@@ -30,88 +30,16 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
 int main_task_2_1() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Create a GLFW windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Window", nullptr, nullptr);
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
 
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
-
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // Load and compile shaders
-    unsigned int vertexShader, fragmentShader;
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Vertex shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Fragment Shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "Fragment shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Shader Program
-    unsigned int shaderProgram;
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
-    }
-
-    // Delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Submit the compile and link of the shaders (or the load from the program binary cache), the driver
+    // works on them while the buffers are set up
+    queued_program program(vertexShaderSource, fragmentShaderSource);
 
     // Vertex data for a triangle
     float vertices_triangle[] = {
@@ -140,14 +68,17 @@ int main_task_2_1() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // The first use of the program waits for its link
+    unsigned int shaderProgram = program.get();
+
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -162,18 +93,21 @@ int main_task_2_1() {
         glBindVertexArray(0);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
     glDeleteVertexArrays(1, &VAO_triangle);
     glDeleteBuffers(1, &VBO_triangle);
+    glDeleteProgram(shaderProgram);
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
+
+REGISTER_TASK("task_2_1", "Task 2.1: a triangle", main_task_2_1);
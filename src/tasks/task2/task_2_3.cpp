@@ -7,20 +7,27 @@
 // 3. Drawing Basic Shapes:
 // Experiment with drawing other basic shapes like circles or lines.
 
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
-#include <cmath>
-
-const char* vertexShaderSource = R"(
-    #version 330 core
+#include "common/procedural_mesh.h"
+#include "common/sdf_renderer.h"
+#include "common/shape_batch.h"
+#include "common/shader.h"
+#include "common/task_registry.h"
+#include "common/viewport.h"
+#include "common/window.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// The Viewport block corrects the aspect ratio, so the vertices never change with the window size
+static const char* vertexShaderSource = R"(
     layout (location = 0) in vec2 aPos;
     void main() {
-        gl_Position = vec4(aPos, 0.0, 1.0);
+        gl_Position = viewport.projection * vec4(aPos, 0.0, 1.0);
     }
 )";
 
-const char* fragmentShaderSource = R"(
+static const char* fragmentShaderSource = R"(
     #version 330 core
     out vec4 FragColor;
     void main() {
@@ -28,126 +35,68 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
-// Vertex data for circle lines
-const unsigned int numSegments = 36;
-float vertices_circle_lines[numSegments * 2];
-unsigned int VAO_circle_lines, VBO_circle_lines;
+// Vertex buffer of the circle lines, sized for the most detailed circle
+static unsigned int VBO_circle_lines = 0;
+static int numSegments = 0;
 
-void updateVertexDate(int width, int height) {
-    const float ratio = static_cast<float>(width) / static_cast<float>(height);
+// Circle outlines by level of detail, a resize back to an earlier size generates nothing
+static procedural_mesh_cache circleMeshes;
+
+// Function to upload the circle lines for the window width, only when the level of detail changes
+static void updateVertexDate(int width) {
+    // The circle spans half of the window width, so the segments follow its radius in pixels
+    const procedural_mesh& circle = circleMeshes.get(procedural_shape::circle, procedural_params{0.5f},
+                                                     0.25f * static_cast<float>(width));
+    if (circle.segments == numSegments) {
+        return;
+    }
 
-    for (int i = 0; i < numSegments; ++i) {
-        float theta = 2.0f * 3.1415926f * static_cast<float>(i) / static_cast<float>(numSegments);
-        vertices_circle_lines[i * 2] = 0.5f * cos(theta); // X coordinate
-        vertices_circle_lines[i * 2 + 1] = 0.5f * sin(theta) * ratio; // Y coordinate
+    std::vector<float> vertices_circle_lines;
+    for (const glm::vec3& position : circle.positions) {
+        vertices_circle_lines.push_back(position.x); // X coordinate
+        vertices_circle_lines.push_back(position.y); // Y coordinate
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, VBO_circle_lines);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices_circle_lines), vertices_circle_lines);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_circle_lines.size() * sizeof(float), vertices_circle_lines.data());
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    numSegments = circle.segments;
 }
 
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-    updateVertexDate(width, height);
+// Callback function for handling framebuffer size changes, called at most once per frame
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    updateVertexDate(width);
 }
 
 int main_task_2_3() {
-    // Initialize GLFW
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // Configure GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
     const int width = 800, height = 600;
 
-    // Create a GLFW windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(width, height, "OpenGL Window", nullptr, nullptr);
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(width, height, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
 
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
-
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Set up viewport and resize callback
-    glViewport(0, 0, width, height);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // Load and compile shaders
-    unsigned int vertexShader, fragmentShader;
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Vertex shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Fragment Shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "Fragment shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Shader Program
-    unsigned int shaderProgram;
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
-    }
-
-    // Delete the shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Set up resize callback
+    setFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // Vertex data for circle lines
-    updateVertexDate(width, height);    
+    // Submit the compile and link of the shaders (or the load from the program binary cache), the driver
+    // works on them while the buffers are set up. The vertex shader starts with the declaration of the
+    // Viewport block
+    std::string vertexShader = std::string("#version 330 core\n") + viewportBlockSource + vertexShaderSource;
+    queued_program program(vertexShader.c_str(), fragmentShaderSource);
 
     // Vertex Array Object (VAO) and Vertex Buffer Object (VBO) for circle lines
+    unsigned int VAO_circle_lines;
     glGenVertexArrays(1, &VAO_circle_lines);
     glGenBuffers(1, &VBO_circle_lines);
 
     // Bind the VAO for circle lines
     glBindVertexArray(VAO_circle_lines);
 
-    // Bind and set vertex buffer for circle lines
+    // Reserve room for the most detailed circle and set the vertex attribute pointers for circle lines
     glBindBuffer(GL_ARRAY_BUFFER, VBO_circle_lines);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_circle_lines), vertices_circle_lines, GL_STATIC_DRAW);
-
-    // Set the vertex attribute pointers for circle lines
+    glBufferData(GL_ARRAY_BUFFER, maxProceduralSegments * 2 * sizeof(float), nullptr, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
@@ -155,6 +104,13 @@ int main_task_2_3() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // Vertex data for circle lines
+    updateVertexDate(width);
+
+    // The first use of the program waits for its link
+    unsigned int shaderProgram = program.get();
+    bindViewportBlock(shaderProgram);
+
     // Set the line width
     glLineWidth(2.0f);
 
@@ -162,14 +118,14 @@ int main_task_2_3() {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Use the shader program for the rectangle
+        // Use the shader program for the circle
         glUseProgram(shaderProgram);
 
         // Bind the VAO for circle lines
@@ -182,18 +138,71 @@ int main_task_2_3() {
         glBindVertexArray(0);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
-        // Poll for and process events
-        glfwPollEvents();
+        // Poll for and process events, a resize updates the Viewport block here
+        pollEvents(window);
     }
 
     // Cleanup
     glDeleteVertexArrays(1, &VAO_circle_lines);
     glDeleteBuffers(1, &VBO_circle_lines);
+    glDeleteProgram(shaderProgram);
+    circleMeshes.clear();
+    numSegments = 0;
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
+
+// The same circle as an anti-aliased ring, its outline stays 2 pixels wide at any window size
+int main_task_2_3_sdf() {
+    const int width = 800, height = 600;
+
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(width, height, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    // The renderer draws the ring as one quad, its fragment shader finds the edges
+    auto renderer = std::make_unique<sdf_renderer>(16);
+    uint32_t color = packColor(1.0f, 0.5f, 0.2f);
+
+    // Set the clear color
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+    // Enable VSync to limit the frame rate
+    setSwapInterval(window, 1);
+
+    // Main rendering loop
+    while (!windowShouldClose(window)) {
+        // Clear the color buffer
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // One pixel is 2 / width units of the Viewport block
+        float pixel = 2.0f * currentViewport().size.z;
+        renderer->addRing(glm::vec2(0.0f), 0.5f, 2.0f * pixel, color);
+        renderer->flush();
+        renderer->endFrame();
+
+        // Swap front and back buffers
+        swapBuffers(window);
+
+        // Poll for and process events, a resize updates the Viewport block here
+        pollEvents(window);
+    }
+
+    // Cleanup
+    renderer.reset();
+
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
+
+    return 0;
+}
+
+REGISTER_TASK("task_2_3", "Task 2.3: a circle drawn with lines", main_task_2_3);
+REGISTER_TASK("task_2_3_sdf", "Task 2.3: the circle as an anti-aliased ring", main_task_2_3_sdf);
@@ -0,0 +1,228 @@
+// Task 2 at scale: thousands of basic shapes.
+// The batched tasks redraw every shape each frame through shape_batch, the
+// unbatched tasks draw the same shapes the way task_2.cpp does, with one
+// VAO, VBO and draw call per shape. Run them with --benchmark to compare.
+
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/shape_batch.h"
+#include "common/task_registry.h"
+#include "common/window.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+enum class shape_type { triangle, rect, circle, line };
+
+// A shape of the test scene, sizes are in normalized device coordinates
+struct scene_shape {
+    shape_type type;
+    glm::vec2 position;
+    glm::vec2 size;
+    glm::vec4 color;
+};
+
+static const int circleSegments = 16;
+
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    void main() {
+        gl_Position = vec4(aPos, 0.0, 1.0);
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    uniform vec4 shapeColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = shapeColor;
+    }
+)";
+
+// Function to create the same pseudo-random mix of shapes on every run
+static std::vector<scene_shape> createScene(int count) {
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> position(-1.0f, 0.95f);
+    std::uniform_real_distribution<float> size(0.005f, 0.05f);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+
+    std::vector<scene_shape> scene(count);
+    for (int i = 0; i < count; ++i) {
+        scene[i].type = static_cast<shape_type>(i % 4);
+        scene[i].position = glm::vec2(position(generator), position(generator));
+        scene[i].size = glm::vec2(size(generator), size(generator));
+        scene[i].color = glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f);
+    }
+    return scene;
+}
+
+// Function to compute the outline of a shape as a triangle fan, as task_2.cpp would store it
+static std::vector<float> shapeFan(const scene_shape& shape) {
+    glm::vec2 p = shape.position, s = shape.size;
+    switch (shape.type) {
+    case shape_type::triangle:
+        return {p.x, p.y, p.x + s.x, p.y, p.x + 0.5f * s.x, p.y + s.y};
+    case shape_type::rect:
+        return {p.x, p.y, p.x + s.x, p.y, p.x + s.x, p.y + s.y, p.x, p.y + s.y};
+    case shape_type::circle: {
+        std::vector<float> fan;
+        for (int i = 0; i < circleSegments; ++i) {
+            float theta = 2.0f * 3.1415926f * static_cast<float>(i) / static_cast<float>(circleSegments);
+            fan.push_back(p.x + s.x * std::cos(theta));
+            fan.push_back(p.y + s.x * std::sin(theta));
+        }
+        return fan;
+    }
+    case shape_type::line:
+    default: {
+        glm::vec2 to = p + s * 2.0f;
+        glm::vec2 normal = glm::normalize(glm::vec2(-s.y, s.x)) * 0.002f;
+        return {p.x + normal.x, p.y + normal.y, p.x - normal.x, p.y - normal.y,
+                to.x - normal.x, to.y - normal.y, to.x + normal.x, to.y + normal.y};
+    }
+    }
+}
+
+// Function to add a scene shape to the batch
+static void addShape(shape_batch& batch, const scene_shape& shape) {
+    uint32_t color = packColor(shape.color.r, shape.color.g, shape.color.b, shape.color.a);
+    glm::vec2 p = shape.position, s = shape.size;
+    switch (shape.type) {
+    case shape_type::triangle:
+        batch.addTriangle(p, glm::vec2(p.x + s.x, p.y), glm::vec2(p.x + 0.5f * s.x, p.y + s.y), color);
+        break;
+    case shape_type::rect:
+        batch.addRect(p, s, color);
+        break;
+    case shape_type::circle:
+        batch.addCircle(p, s.x, color, circleSegments);
+        break;
+    case shape_type::line:
+        batch.addLine(p, p + s * 2.0f, 0.004f, color);
+        break;
+    }
+}
+
+// Function to draw the scene with shape_batch, all shapes are appended again every frame
+static int runBatched(int shapeCount) {
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<scene_shape> scene = createScene(shapeCount);
+    auto batch = std::make_unique<shape_batch>();
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (const scene_shape& shape : scene) {
+            addShape(*batch, shape);
+        }
+        batch->flush();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        batch_stats stats = batch->stats();
+        std::cout << "Batched " << shapeCount << " shapes: " << stats.drawCalls / frames << " draw calls and "
+                  << stats.vertices / frames << " vertices per frame" << std::endl;
+    }
+
+    batch.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the scene with one VAO, VBO and draw call per shape
+static int runUnbatched(int shapeCount) {
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    // The driver compiles while the buffers are set up
+    queued_program program(vertexShaderSource, fragmentShaderSource);
+
+    std::vector<scene_shape> scene = createScene(shapeCount);
+    std::vector<unsigned int> VAOs(shapeCount), VBOs(shapeCount);
+    std::vector<int> counts(shapeCount);
+    glGenVertexArrays(shapeCount, VAOs.data());
+    glGenBuffers(shapeCount, VBOs.data());
+
+    for (int i = 0; i < shapeCount; ++i) {
+        std::vector<float> fan = shapeFan(scene[i]);
+        counts[i] = static_cast<int>(fan.size() / 2);
+
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBOs[i]);
+        glBufferData(GL_ARRAY_BUFFER, fan.size() * sizeof(float), fan.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    unsigned int shaderProgram = program.get();
+    program_reflection reflection(shaderProgram);
+    uniform_handle<glm::vec4> shapeColor = reflection.uniform<glm::vec4>("shapeColor");
+    if (!reflection.valid()) {
+        glDeleteVertexArrays(shapeCount, VAOs.data());
+        glDeleteBuffers(shapeCount, VBOs.data());
+        glDeleteProgram(shaderProgram);
+        terminateWindow(window);
+        return -1;
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // The same calls as renderShape() in task_2.cpp, plus the color of the shape
+        for (int i = 0; i < shapeCount; ++i) {
+            glUseProgram(shaderProgram);
+            setUniform(shapeColor, scene[i].color);
+            glBindVertexArray(VAOs[i]);
+            glDrawArrays(GL_TRIANGLE_FAN, 0, counts[i]);
+            glBindVertexArray(0);
+        }
+
+        swapBuffers(window);
+        pollEvents(window);
+    }
+
+    glDeleteVertexArrays(shapeCount, VAOs.data());
+    glDeleteBuffers(shapeCount, VBOs.data());
+    glDeleteProgram(shaderProgram);
+
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_batch_1k() { return runBatched(1000); }
+static int main_batch_10k() { return runBatched(10000); }
+static int main_batch_100k() { return runBatched(100000); }
+static int main_unbatched_1k() { return runUnbatched(1000); }
+static int main_unbatched_10k() { return runUnbatched(10000); }
+static int main_unbatched_100k() { return runUnbatched(100000); }
+
+REGISTER_TASK("task_2_batch_1k", "Task 2 at scale: 1k shapes batched, 256k vertices per draw", main_batch_1k);
+REGISTER_TASK("task_2_batch_10k", "Task 2 at scale: 10k shapes batched, 256k vertices per draw", main_batch_10k);
+REGISTER_TASK("task_2_batch_100k", "Task 2 at scale: 100k shapes batched, 256k vertices per draw", main_batch_100k);
+REGISTER_TASK("task_2_unbatched_1k", "Task 2 at scale: 1k shapes, one draw per shape", main_unbatched_1k);
+REGISTER_TASK("task_2_unbatched_10k", "Task 2 at scale: 10k shapes, one draw per shape", main_unbatched_10k);
+REGISTER_TASK("task_2_unbatched_100k", "Task 2 at scale: 100k shapes, one draw per shape", main_unbatched_100k);
@@ -0,0 +1,193 @@
+// Task 2 with thick lines: polylines expanded on the GPU.
+// task_2_polyline draws the joins and caps polyline_renderer supports next to
+// a track that grows by one point per frame. The benchmark tasks draw random
+// walk tracks with 100k or 1M segments: the polyline tasks upload the points
+// once and expand them in the vertex shader, the CPU tasks tessellate every
+// segment into shape_batch again each frame.
+// Run them with --benchmark to compare.
+
+#include "common/polyline_renderer.h"
+#include "common/shape_batch.h"
+#include "common/task_registry.h"
+#include "common/viewport.h"
+#include "common/window.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+static const int windowWidth = 800, windowHeight = 600;
+
+// Function to create the same pseudo-random tracks on every run, positions are in the units of the Viewport block
+static std::vector<std::vector<polyline_point>> createTracks(int trackCount, int pointsPerTrack, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> start(-0.9f, 0.9f);
+    std::uniform_real_distribution<float> turn(-0.4f, 0.4f);
+    std::uniform_real_distribution<float> width(1.5f, 3.0f);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+    const float step = 0.004f;
+
+    std::vector<std::vector<polyline_point>> tracks(trackCount);
+    for (std::vector<polyline_point>& track : tracks) {
+        glm::vec2 position(start(generator), 0.7f * start(generator));
+        float heading = 0.0f;
+        float trackWidth = width(generator);
+        uint32_t color = packColor(channel(generator), channel(generator), channel(generator));
+        for (int i = 0; i < pointsPerTrack; ++i) {
+            track.push_back({position, trackWidth, color});
+            heading += turn(generator);
+            position += step * glm::vec2(std::cos(heading), std::sin(heading));
+        }
+    }
+    return tracks;
+}
+
+// Function to create a zigzag of the given number of points, from left to right around height y
+static std::vector<polyline_point> zigzag(float y, int points, float width, uint32_t from, uint32_t to) {
+    std::vector<polyline_point> line;
+    for (int i = 0; i < points; ++i) {
+        float t = static_cast<float>(i) / static_cast<float>(points - 1);
+        glm::vec2 position(-0.8f + 1.6f * t, y + (i % 2 == 0 ? -0.08f : 0.08f) * (0.5f + t));
+        line.push_back({position, width * (0.5f + t), i < points / 2 ? from : to});
+    }
+    return line;
+}
+
+int main_task_2_polyline() {
+    window_context* window = setupWindow(windowWidth, windowHeight, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    auto renderer = std::make_unique<polyline_renderer>();
+
+    // Miter joins with butt caps, round joins and caps, miter joins with square caps
+    std::vector<polyline_point> miter = zigzag(0.45f, 9, 12.0f, packColor(1.0f, 0.5f, 0.2f), packColor(0.9f, 0.9f, 0.3f));
+    std::vector<polyline_point> round = zigzag(0.2f, 9, 12.0f, packColor(0.3f, 0.8f, 1.0f), packColor(0.6f, 0.4f, 1.0f));
+    std::vector<polyline_point> square = zigzag(-0.05f, 9, 12.0f, packColor(0.4f, 1.0f, 0.5f), packColor(1.0f, 1.0f, 1.0f));
+    renderer->create(miter.data(), miter.size(), {polyline_join::miter, polyline_cap::butt});
+    renderer->create(round.data(), round.size(), {polyline_join::round, polyline_cap::round});
+    renderer->create(square.data(), square.size(), {polyline_join::miter, polyline_cap::square});
+
+    // The track is appended in place, one point per frame
+    std::vector<polyline_point> walk = createTracks(1, 600, 99)[0];
+    for (polyline_point& point : walk) {
+        point.position = glm::vec2(0.5f * point.position.x, 0.5f * point.position.y - 0.4f);
+        point.width = 3.0f;
+    }
+    int track = renderer->create(walk.data(), 2, {polyline_join::round, polyline_cap::round});
+    size_t shown = 2;
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if (shown < walk.size()) {
+            renderer->append(track, &walk[shown], 1);
+            shown++;
+        }
+        renderer->draw();
+
+        swapBuffers(window);
+        pollEvents(window);
+    }
+
+    renderer.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the tracks from points uploaded once
+static int runPolylines(int trackCount, int pointsPerTrack) {
+    window_context* window = setupWindow(windowWidth, windowHeight, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    auto renderer = std::make_unique<polyline_renderer>();
+    for (const std::vector<polyline_point>& track : createTracks(trackCount, pointsPerTrack, 1357)) {
+        renderer->create(track.data(), track.size());
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer->draw();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        polyline_stats stats = renderer->stats();
+        std::cout << "Polylines " << stats.segments / frames << " segments: " << stats.drawCalls / frames
+                  << " draw calls per frame, " << stats.uploadedBytes << " bytes uploaded in total" << std::endl;
+    }
+
+    renderer.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the same tracks as one quad per segment, tessellated on the CPU every frame
+static int runTessellatedLines(int trackCount, int pointsPerTrack) {
+    window_context* window = setupWindow(windowWidth, windowHeight, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<std::vector<polyline_point>> tracks = createTracks(trackCount, pointsPerTrack, 1357);
+    auto batch = std::make_unique<shape_batch>();
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // shape_batch works in normalized device coordinates, so the projection is applied here
+        const viewport_block& viewport = currentViewport();
+        for (const std::vector<polyline_point>& track : tracks) {
+            for (size_t i = 0; i + 1 < track.size(); ++i) {
+                glm::vec2 from = glm::vec2(viewport.projection * glm::vec4(track[i].position, 0.0f, 1.0f));
+                glm::vec2 to = glm::vec2(viewport.projection * glm::vec4(track[i + 1].position, 0.0f, 1.0f));
+                batch->addLine(from, to, track[i].width * 2.0f * viewport.size.z, track[i].color);
+            }
+        }
+        batch->flush();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        batch_stats stats = batch->stats();
+        std::cout << "Tessellated " << stats.shapes / frames << " segments: " << stats.drawCalls / frames
+                  << " draw calls and " << stats.vertices / frames << " vertices per frame" << std::endl;
+    }
+
+    batch.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_polyline_100k() { return runPolylines(100, 1001); }
+static int main_polyline_1m() { return runPolylines(1000, 1001); }
+static int main_polyline_cpu_100k() { return runTessellatedLines(100, 1001); }
+static int main_polyline_cpu_1m() { return runTessellatedLines(1000, 1001); }
+
+REGISTER_TASK("task_2_polyline", "Task 2: thick polylines with miter and round joins and a growing track", main_task_2_polyline);
+REGISTER_TASK("task_2_polyline_100k", "Task 2 at scale: 100k polyline segments expanded on the GPU", main_polyline_100k);
+REGISTER_TASK("task_2_polyline_1m", "Task 2 at scale: 1M polyline segments expanded on the GPU", main_polyline_1m);
+REGISTER_TASK("task_2_polyline_cpu_100k", "Task 2 at scale: 100k line segments tessellated on the CPU", main_polyline_cpu_100k);
+REGISTER_TASK("task_2_polyline_cpu_1m", "Task 2 at scale: 1M line segments tessellated on the CPU", main_polyline_cpu_1m);
@@ -0,0 +1,153 @@
+// Task 2 at scale: round markers drawn analytically.
+// The SDF tasks draw every marker as one quad through sdf_renderer, the
+// fragment shader computes the anti-aliased edge of the disc. The
+// tessellated tasks draw the same markers as instanced triangle fans with
+// enough segments for the largest marker to look round.
+// Run them with --benchmark to compare.
+
+#include "common/instanced_mesh.h"
+#include "common/procedural_mesh.h"
+#include "common/sdf_renderer.h"
+#include "common/shape_batch.h"
+#include "common/task_registry.h"
+#include "common/viewport.h"
+#include "common/window.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// A round marker, sizes are in the units of the Viewport block
+struct round_marker {
+    glm::vec2 position;
+    float radius;
+    glm::vec4 color;
+};
+
+static const int windowWidth = 800, windowHeight = 600;
+
+// Radius of the markers in pixels
+static const float minMarkerPixels = 2.0f;
+static const float maxMarkerPixels = 12.0f;
+
+// Function to create the same pseudo-random markers on every run
+static std::vector<round_marker> createMarkers(int count) {
+    std::mt19937 generator(2468);
+    float aspect = static_cast<float>(windowWidth) / static_cast<float>(windowHeight);
+    std::uniform_real_distribution<float> x(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> y(-1.0f / aspect, 1.0f / aspect);
+    std::uniform_real_distribution<float> radius(minMarkerPixels, maxMarkerPixels);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+
+    // One pixel is 2 / width units of the Viewport block
+    std::vector<round_marker> markers(count);
+    for (round_marker& m : markers) {
+        m.position = glm::vec2(x(generator), y(generator));
+        m.radius = radius(generator) * 2.0f / windowWidth;
+        m.color = glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f);
+    }
+    return markers;
+}
+
+// Function to draw the markers as signed distance quads
+static int runSdf(int markerCount) {
+    window_context* window = setupWindow(windowWidth, windowHeight, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<round_marker> markers = createMarkers(markerCount);
+    std::vector<uint32_t> colors(markerCount);
+    for (int i = 0; i < markerCount; ++i) {
+        colors[i] = packColor(markers[i].color.r, markers[i].color.g, markers[i].color.b, markers[i].color.a);
+    }
+    auto renderer = std::make_unique<sdf_renderer>();
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (int i = 0; i < markerCount; ++i) {
+            renderer->addCircle(markers[i].position, markers[i].radius, colors[i]);
+        }
+        renderer->flush();
+        renderer->endFrame();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        std::cout << "SDF " << markerCount << " markers: " << renderer->drawCalls() / frames << " draw calls and "
+                  << 4 * renderer->primitives() / frames << " vertices per frame" << std::endl;
+    }
+
+    renderer.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the markers as instanced discs, tessellated for the largest one
+static int runTessellated(int markerCount) {
+    window_context* window = setupWindow(windowWidth, windowHeight, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<round_marker> markers = createMarkers(markerCount);
+    std::vector<instance_data> instances(markerCount);
+
+    procedural_mesh disc = generateMesh(procedural_shape::disc, procedural_params{1.0f},
+                                        segmentsForRadius(maxMarkerPixels));
+    auto mesh = std::make_unique<instanced_mesh>(&disc.positions[0].x, static_cast<int>(disc.positions.size()), 3,
+                                                 disc.indices.data(), static_cast<int>(disc.indices.size()));
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // instanced_mesh has no Viewport block, so the projection goes into every transform
+        const glm::mat4& projection = currentViewport().projection;
+        for (int i = 0; i < markerCount; ++i) {
+            glm::mat4 transform = glm::translate(projection, glm::vec3(markers[i].position, 0.0f));
+            instances[i].transform = glm::scale(transform, glm::vec3(markers[i].radius));
+            instances[i].color = markers[i].color;
+        }
+        mesh->draw(instances.data(), instances.size());
+        mesh->endFrame();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        std::cout << "Tessellated " << markerCount << " markers: " << mesh->drawCalls() / frames
+                  << " draw calls and " << disc.indices.size() * markerCount << " vertices per frame ("
+                  << disc.segments << " segments each)" << std::endl;
+    }
+
+    mesh.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_sdf_10k() { return runSdf(10000); }
+static int main_sdf_100k() { return runSdf(100000); }
+static int main_tessellated_10k() { return runTessellated(10000); }
+static int main_tessellated_100k() { return runTessellated(100000); }
+
+REGISTER_TASK("task_2_sdf_10k", "Task 2 at scale: 10k anti-aliased discs, one quad each", main_sdf_10k);
+REGISTER_TASK("task_2_sdf_100k", "Task 2 at scale: 100k anti-aliased discs, one quad each", main_sdf_100k);
+REGISTER_TASK("task_2_tessellated_10k", "Task 2 at scale: 10k instanced triangle fan discs", main_tessellated_10k);
+REGISTER_TASK("task_2_tessellated_100k", "Task 2 at scale: 100k instanced triangle fan discs", main_tessellated_100k);
@@ -0,0 +1,196 @@
+// Task 3 at scale: one triangle mesh drawn with many transforms.
+// The instanced tasks stream every transform and color of a frame into one
+// buffer and draw them with a single instanced call through instanced_mesh.
+// The uniform tasks draw the same markers the way tasks 3.1 and 3.2 do,
+// setting the transform uniform before one draw call per marker.
+// Run them with --benchmark to compare.
+
+#include "common/instanced_mesh.h"
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/task_registry.h"
+#include "common/window.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// A map marker, it spins around its position
+struct marker {
+    glm::vec2 position;
+    float scale;
+    float spin;
+    glm::vec4 color;
+};
+
+// Vertex data for a triangle
+static const float vertices_triangle[] = {
+    -0.5f, -0.5f,
+     0.5f, -0.5f,
+     0.0f,  0.5f
+};
+
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    uniform mat4 transform; // Transformation matrix
+    void main() {
+        gl_Position = transform * vec4(aPos, 0.0, 1.0);
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    uniform vec4 markerColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = markerColor;
+    }
+)";
+
+// Function to create the same pseudo-random markers on every run
+static std::vector<marker> createMarkers(int count) {
+    std::mt19937 generator(4321);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.005f, 0.03f);
+    std::uniform_real_distribution<float> spin(-3.0f, 3.0f);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+
+    std::vector<marker> markers(count);
+    for (marker& m : markers) {
+        m.position = glm::vec2(position(generator), position(generator));
+        m.scale = scale(generator);
+        m.spin = spin(generator);
+        m.color = glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f);
+    }
+    return markers;
+}
+
+// Function to compute the transform of a marker at the given time, as task 3.2 does for its triangle
+static glm::mat4 markerTransform(const marker& m, float time) {
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(m.position, 0.0f));
+    transform = glm::rotate(transform, m.spin * time, glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(transform, glm::vec3(m.scale));
+}
+
+// Function to draw the markers with one instanced draw call per frame
+static int runInstanced(int markerCount) {
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<marker> markers = createMarkers(markerCount);
+    std::vector<instance_data> instances(markerCount);
+    auto mesh = std::make_unique<instanced_mesh>(vertices_triangle, 3);
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        float time = frames / 60.0f;
+        for (int i = 0; i < markerCount; ++i) {
+            instances[i].transform = markerTransform(markers[i], time);
+            instances[i].color = markers[i].color;
+        }
+        mesh->draw(instances.data(), instances.size());
+        mesh->endFrame();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        std::cout << "Instanced " << markerCount << " markers: " << mesh->drawCalls() / frames
+                  << " draw calls per frame" << std::endl;
+    }
+
+    mesh.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the markers with a transform uniform and a draw call each
+static int runUniforms(int markerCount) {
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    // The driver compiles while the markers and the buffers are set up
+    queued_program program(vertexShaderSource, fragmentShaderSource);
+
+    std::vector<marker> markers = createMarkers(markerCount);
+
+    // Vertex Array Object (VAO) and Vertex Buffer Object (VBO) for the triangle
+    unsigned int VAO_triangle, VBO_triangle;
+    glGenVertexArrays(1, &VAO_triangle);
+    glGenBuffers(1, &VBO_triangle);
+    glBindVertexArray(VAO_triangle);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_triangle);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_triangle), vertices_triangle, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    unsigned int shaderProgram = program.get();
+    program_reflection reflection(shaderProgram);
+    uniform_handle<glm::mat4> transform = reflection.uniform<glm::mat4>("transform");
+    uniform_handle<glm::vec4> markerColor = reflection.uniform<glm::vec4>("markerColor");
+    if (!reflection.valid()) {
+        glDeleteVertexArrays(1, &VAO_triangle);
+        glDeleteBuffers(1, &VBO_triangle);
+        glDeleteProgram(shaderProgram);
+        terminateWindow(window);
+        return -1;
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glUseProgram(shaderProgram);
+        glBindVertexArray(VAO_triangle);
+
+        float time = frames / 60.0f;
+        for (const marker& m : markers) {
+            setUniform(transform, markerTransform(m, time));
+            setUniform(markerColor, m.color);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        glBindVertexArray(0);
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    glDeleteVertexArrays(1, &VAO_triangle);
+    glDeleteBuffers(1, &VBO_triangle);
+    glDeleteProgram(shaderProgram);
+
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_instanced_10k() { return runInstanced(10000); }
+static int main_instanced_100k() { return runInstanced(100000); }
+static int main_uniforms_10k() { return runUniforms(10000); }
+static int main_uniforms_100k() { return runUniforms(100000); }
+
+REGISTER_TASK("task_3_instanced_10k", "Task 3 at scale: 10k transformed triangles in one instanced draw", main_instanced_10k);
+REGISTER_TASK("task_3_instanced_100k", "Task 3 at scale: 100k transformed triangles in one instanced draw", main_instanced_100k);
+REGISTER_TASK("task_3_uniforms_10k", "Task 3 at scale: 10k transformed triangles, one uniform and draw each", main_uniforms_10k);
+REGISTER_TASK("task_3_uniforms_100k", "Task 3 at scale: 100k transformed triangles, one uniform and draw each", main_uniforms_100k);
@@ -1,111 +1,45 @@
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <iostream>
+#include "common/shader_asset.h"
+#include "common/task_registry.h"
+#include "common/vertex_layout.h"
+#include "common/window.h"
 
-// Vertex data with position and color attributes
-float vertices[] = {
-    -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, // Vertex 1
-     0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, // Vertex 2
-     0.0f,  0.5f, 0.0f, 0.0f, 0.0f, 1.0f  // Vertex 3
-};
+#include <memory>
 
-// Vertex Shader
-const char* vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec3 aPos;
-    layout (location = 1) in vec3 aColor; // Input color attribute
-    out vec4 FragColor; // Output variable for passing color to the fragment shader
-
-    void main() {
-        gl_Position = vec4(aPos, 1.0);
-        FragColor = vec4(aColor, 1.0);
-    }
-)";
+// Vertex with a position and an 8-bit normalized color, 16 bytes
+struct color_vertex {
+    glm::vec3 position;
+    unorm8x4 color;
+};
 
-// Fragment Shader
-const char* fragmentShaderSource = R"(
-    #version 330 core
-    in vec4 FragColor; // Input color from the vertex shader
-    out vec4 FinalColor; // Output variable for the final color
+typedef vertex_layout<color_vertex,
+                      VERTEX_ATTRIBUTE(color_vertex, position),
+                      VERTEX_ATTRIBUTE(color_vertex, color)> color_vertex_layout;
 
-    void main() {
-        FinalColor = FragColor;
-    }
-)";
+// Vertex data with position and color attributes
+static const color_vertex vertices[] = {
+    {glm::vec3(-0.5f, -0.5f, 0.0f), unorm8x4(255, 0, 0)}, // Vertex 1
+    {glm::vec3( 0.5f, -0.5f, 0.0f), unorm8x4(0, 255, 0)}, // Vertex 2
+    {glm::vec3( 0.0f,  0.5f, 0.0f), unorm8x4(0, 0, 255)}  // Vertex 3
+};
 
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
+// The shaders are loaded from task4/*.glsl in the shader directory and reloaded when the files are edited
+static const char* vertexShaderPath = "task4/vertex_shader.glsl";
+static const char* fragmentShaderPath = "task4/fragment_shader.glsl";
 
 int main_task_4() {
-    // GLFW initialization
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // GLFW window creation and OpenGL context setup
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Window", nullptr, nullptr);
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
 
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
+    // Load, compile and link the shaders (or load them from the program binary cache)
+    auto shader = std::make_unique<shader_asset>(vertexShaderPath, fragmentShaderPath);
+    if (!shader->loaded()) {
+        terminateWindow(window);
         return -1;
     }
 
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // Load and compile shaders
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader Compilation
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Vertex shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Fragment Shader Compilation
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "Fragment shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Shader Program Linking
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
     // Vertex Array Object (VAO) and Vertex Buffer Object (VBO) setup
     unsigned int VAO, VBO;
     glGenVertexArrays(1, &VAO);
@@ -115,12 +49,8 @@ int main_task_4() {
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    // Set up vertex attributes pointers
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Set up the vertex attributes from the layout of color_vertex
+    setupVertexLayout<color_vertex_layout>(VBO);
 
     // Unbind VAO and VBO
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -130,15 +60,15 @@ int main_task_4() {
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Use the shader program for the triangle
-        glUseProgram(shaderProgram);
+        // Use the shader program for the triangle, it changes when the files are edited
+        glUseProgram(shader->program());
 
         // Draw the transformed triangle
         glBindVertexArray(VAO);
@@ -148,19 +78,21 @@ int main_task_4() {
         glBindVertexArray(0);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    shader.reset();
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
+
+REGISTER_TASK("task_4", "Task 4: color interpolation in shaders", main_task_4);
@@ -1,19 +1,38 @@
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/task_registry.h"
+#include "common/texture_loader.h"
+#include "common/vertex_compression.h"
+#include "common/vertex_layout.h"
+#include "common/window.h"
 #include <iostream>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <memory>
 
 // Vertex data with position, color and texture coordinates
-float vertices[] = {
+static const float vertices[] = {
     -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // Vertex 1
      0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // Vertex 2
      0.0f,  0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 0.5f, 1.0f  // Vertex 3
 };
 
+static const size_t vertexCount = 3;
+static const size_t vertexFloats = 8;
+
+// The vertices as uploaded: a position quantized in the bounding box, an 8-bit normalized color and
+// half float texture coordinates, 16 bytes instead of 32
+struct textured_vertex {
+    unorm16x4 position;
+    unorm8x4 color;
+    half2 texCoord;
+};
+
+typedef vertex_layout<textured_vertex,
+                      VERTEX_ATTRIBUTE(textured_vertex, position),
+                      VERTEX_ATTRIBUTE(textured_vertex, color),
+                      VERTEX_ATTRIBUTE(textured_vertex, texCoord)> textured_vertex_layout;
+
 // Vertex Shader
-const char* vertexShaderSource = R"(
+static const char* vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec3 aColor;
@@ -22,8 +41,11 @@ const char* vertexShaderSource = R"(
     out vec4 FragColor;
     out vec2 TexCoord;
 
+    // The model transform with the position dequantization folded in
+    uniform mat4 model;
+
     void main() {
-        gl_Position = vec4(aPos, 1.0);
+        gl_Position = model * vec4(aPos, 1.0);
         FragColor = vec4(aColor, 1.0);
 
         TexCoord = aTexCoord;
@@ -31,7 +53,7 @@ const char* vertexShaderSource = R"(
 )";
 
 // Fragment Shader
-const char* fragmentShaderSource = R"(
+static const char* fragmentShaderSource = R"(
     #version 330 core
     in vec4 FragColor;
     in vec2 TexCoord;
@@ -45,78 +67,16 @@ const char* fragmentShaderSource = R"(
     }
 )";
 
-// Callback function for handling framebuffer size changes
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
 int main_task_5() {
-    // GLFW initialization
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW" << std::endl;
-        return -1;
-    }
-
-    // GLFW window creation and OpenGL context setup
-    GLFWwindow* window = glfwCreateWindow(800, 600, "OpenGL Window", nullptr, nullptr);
+    // Create the window (or the headless context) and initialize GLAD
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
     if (!window) {
-        std::cerr << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
-
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    // Set up viewport and resize callback
-    glViewport(0, 0, 800, 600);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-    // Load and compile shaders
-    int success;
-    char infoLog[512];
-
-    // Vertex Shader Compilation
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cerr << "Vertex shader compilation failed:\n" << infoLog << std::endl;
-    }
 
-    // Fragment Shader Compilation
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cerr << "Fragment shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    // Shader Program Linking
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Submit the compile and link of the shaders (or the load from the program binary cache), the driver
+    // works on them while the vertices are compressed and the texture starts loading
+    queued_program program(vertexShaderSource, fragmentShaderSource);
 
     // Generate VAO and VBO
     unsigned int VAO, VBO;
@@ -126,63 +86,100 @@ int main_task_5() {
     // Bind the VAO
     glBindVertexArray(VAO);
 
+    // Compress the float vertices and report what it saved and cost
+    glm::vec3 positions[vertexCount];
+    for (size_t i = 0; i < vertexCount; ++i) {
+        positions[i] = glm::vec3(vertices[i * vertexFloats], vertices[i * vertexFloats + 1], vertices[i * vertexFloats + 2]);
+    }
+    position_quantization quantization = positionQuantization(positions, vertexCount);
+
+    textured_vertex compressed[vertexCount];
+    compression_report report;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* vertex = vertices + i * vertexFloats;
+        glm::vec4 color(vertex[3], vertex[4], vertex[5], 1.0f);
+        glm::vec2 texCoord(vertex[6], vertex[7]);
+
+        compressed[i].position = quantization.encode(positions[i]);
+        compressed[i].color = unorm8x4(color);
+        compressed[i].texCoord = half2(texCoord);
+
+        report.position(positions[i], quantization.decode(compressed[i].position));
+        report.color(color, decodeColor(compressed[i].color));
+        report.texCoord(texCoord, decodeTexCoord(compressed[i].texCoord));
+    }
+    report.vertices(vertexCount, vertexFloats * sizeof(float), sizeof(textured_vertex));
+    report.print("task 5");
+
     // Bind and set vertex buffer
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // Set the vertex attribute pointers for position, color, and texture coordinates
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(compressed), compressed, GL_STATIC_DRAW);
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // Set the vertex attributes for position, color, and texture coordinates from the layout of textured_vertex
+    setupVertexLayout<textured_vertex_layout>(VBO);
 
     // Unbind VAO and VBO
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    // Load texture
-    int tex_width, tex_height, nrChannels;
-    unsigned char* texture_data = stbi_load("texture.png", &tex_width, &tex_height, &nrChannels, 0);
-
-    unsigned int texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Load texture, a worker thread decodes it and the triangle shows a placeholder until it is resident
+    auto textures = std::make_unique<texture_loader>(1);
+    int texture = textures->load("texture.png");
+
+    // Look up the attributes and the sampler once, the first use of the program waits for its link. A wrong
+    // name stops the task here
+    unsigned int shaderProgram = program.get();
+    program_reflection reflection(shaderProgram);
+    int positionLocation = reflection.attribute("aPos", GL_FLOAT_VEC3);
+    int colorLocation = reflection.attribute("aColor", GL_FLOAT_VEC3);
+    int texCoordLocation = reflection.attribute("aTexCoord", GL_FLOAT_VEC2);
+    uniform_handle<int> mainTexture = reflection.uniform<int>("mainTexture");
+    uniform_handle<glm::mat4> model = reflection.uniform<glm::mat4>("model");
+
+    if (!reflection.valid()) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteProgram(shaderProgram);
+        textures.reset();
+        terminateWindow(window);
+        return -1;
+    }
 
-    if (texture_data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, tex_width, tex_height, 0, GL_RGB, GL_UNSIGNED_BYTE, texture_data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cerr << "Failed to load texture. Error: " << stbi_failure_reason() << std::endl;
+    // The layout feeds the locations in member order
+    if (positionLocation != 0 || colorLocation != 1 || texCoordLocation != 2) {
+        std::cerr << "The attributes of task 5 don't match the members of textured_vertex" << std::endl;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteProgram(shaderProgram);
+        textures.reset();
+        terminateWindow(window);
+        return -1;
     }
-    stbi_image_free(texture_data);
 
     // Set the clear color
     glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
     // Enable VSync to limit the frame rate
-    glfwSwapInterval(1);
+    setSwapInterval(window, 1);
 
     // Main rendering loop
-    while (!glfwWindowShouldClose(window)) {
+    while (!windowShouldClose(window)) {
         // Clear the color buffer
         glClear(GL_COLOR_BUFFER_BIT);
 
+        // Upload the decoded texture rows that fit in the budget of this frame
+        textures->update();
+
         // Use the shader program for the triangle
         glUseProgram(shaderProgram);
 
-        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindTexture(GL_TEXTURE_2D, textures->texture(texture));
 
         // Set the texture unit index to the sampler uniform
-        glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0); 
+        setUniform(mainTexture, 0);
+
+        // The triangle has no model transform of its own, only the dequantization
+        setUniform(model, quantization.dequantize());
 
         // Draw the transformed triangle
         glBindVertexArray(VAO);
@@ -195,19 +192,22 @@ int main_task_5() {
         glBindTexture(GL_TEXTURE_2D, 0);
 
         // Swap front and back buffers
-        glfwSwapBuffers(window);
+        swapBuffers(window);
 
         // Poll for and process events
-        glfwPollEvents();
+        pollEvents(window);
     }
 
     // Cleanup
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
+    textures.reset();
 
-    // Terminate GLFW
-    glfwTerminate();
+    // Destroy the window and terminate GLFW
+    terminateWindow(window);
 
     return 0;
 }
+
+REGISTER_TASK("task_5", "Task 5: a textured triangle", main_task_5);
@@ -0,0 +1,276 @@
+// Task 5 at scale: a grid of textured quads, each with its own texture.
+// The streaming tasks queue every image on texture_loader and start drawing
+// at once with placeholders, the blocking tasks decode and upload all of
+// them on the render thread before the first frame, as task 5 used to. The
+// pack tasks also create every texture before the first frame, but from
+// the "texture" asset of a memory-mapped asset pack, with nothing to read
+// or decode (build it with pack_assets assets.pack texture.png). All of
+// them print when the first frame was shown. Run them with --benchmark to
+// compare.
+
+#include "common/asset_pack.h"
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/task_registry.h"
+#include "common/texture.h"
+#include "common/texture_loader.h"
+#include "common/window.h"
+
+#include <stb_image.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static const char* texturePath = "texture.png";
+static const char* packPath = "assets.pack";
+
+// The quad comes from gl_VertexID, rect holds its lower left corner and size
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    uniform vec4 rect;
+    out vec2 TexCoord;
+    void main() {
+        TexCoord = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        gl_Position = vec4(rect.xy + TexCoord * rect.zw, 0.0, 1.0);
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec2 TexCoord;
+    out vec4 FragColor;
+    uniform sampler2D mainTexture;
+    void main() {
+        FragColor = texture(mainTexture, TexCoord);
+    }
+)";
+
+typedef std::chrono::steady_clock benchmark_clock;
+
+static double millisecondsSince(benchmark_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(benchmark_clock::now() - start).count();
+}
+
+// Uniform of the grid program, looked up once the program has linked
+struct grid_uniforms {
+    bool ready = false;
+    uniform_handle<glm::vec4> rect;
+};
+
+// Function to draw one quad per texture in a square grid
+static void drawGrid(queued_program& program, grid_uniforms& uniforms, const std::vector<unsigned int>& textures) {
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(textures.size()))));
+    float size = 2.0f / static_cast<float>(columns);
+
+    // The first frame waits for the link of the program and looks up its uniform
+    if (!uniforms.ready) {
+        program_reflection reflection(program.get());
+        uniforms.rect = reflection.uniform<glm::vec4>("rect");
+        uniforms.ready = true;
+    }
+    glUseProgram(program.get());
+    for (size_t i = 0; i < textures.size(); ++i) {
+        float x = -1.0f + size * static_cast<float>(i % columns);
+        float y = 1.0f - size * static_cast<float>(i / columns + 1);
+        setUniform(uniforms.rect, glm::vec4(x, y, size, size));
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Function to set up the window and the grid program, returns nullptr if the file the textures come from is missing
+static window_context* setupGrid(const char* sourcePath, queued_program& program, unsigned int& VAO) {
+    if (!std::ifstream(sourcePath)) {
+        std::cerr << "The grid needs " << sourcePath << " in the working directory" << std::endl;
+        return nullptr;
+    }
+
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return nullptr;
+    }
+
+    // Only submitted here, the driver compiles while the textures start loading
+    program = queued_program(vertexShaderSource, fragmentShaderSource);
+
+    // Core profiles draw nothing without a vertex array, even when no attribute is read
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+    return window;
+}
+
+// Function to stream the textures while the grid is drawn
+static int runStreaming(int textureCount) {
+    auto start = benchmark_clock::now();
+    queued_program program;
+    unsigned int VAO = 0;
+    grid_uniforms uniforms;
+    window_context* window = setupGrid(texturePath, program, VAO);
+    if (!window) {
+        return -1;
+    }
+
+    auto loader = std::make_unique<texture_loader>();
+    std::vector<int> handles;
+    for (int i = 0; i < textureCount; ++i) {
+        handles.push_back(loader->load(texturePath));
+    }
+
+    std::vector<unsigned int> textures(textureCount);
+    double firstFrameMs = 0.0, residentMs = 0.0;
+    bool resident = false;
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        loader->update();
+        for (int i = 0; i < textureCount; ++i) {
+            textures[i] = loader->texture(handles[i]);
+        }
+        drawGrid(program, uniforms, textures);
+
+        swapBuffers(window);
+        pollEvents(window);
+
+        if (frames++ == 0) {
+            firstFrameMs = millisecondsSince(start);
+        }
+        if (!resident && loader->idle()) {
+            resident = true;
+            residentMs = millisecondsSince(start);
+        }
+    }
+
+    // A run cut short by --frames may end before the last upload
+    texture_loader_stats stats = loader->stats();
+    std::cout << "Streamed " << stats.resident << " of " << textureCount << " textures: first frame after "
+              << firstFrameMs << " ms, ";
+    if (resident) {
+        std::cout << "all in after " << residentMs << " ms";
+    } else {
+        std::cout << "not all resident after " << frames << " frames";
+    }
+    std::cout << ", decoding took " << stats.decodeMs << " ms on the workers (" << stats.cooked
+              << " cooked), at most " << stats.largestFrameBytes << " bytes uploaded per frame" << std::endl;
+
+    loader.reset();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(program.get());
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to decode and upload every texture before the first frame
+static int runBlocking(int textureCount) {
+    auto start = benchmark_clock::now();
+    queued_program program;
+    unsigned int VAO = 0;
+    grid_uniforms uniforms;
+    window_context* window = setupGrid(texturePath, program, VAO);
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<unsigned int> textures(textureCount);
+    for (unsigned int& texture : textures) {
+        int width = 0, height = 0, fileChannels = 0;
+        stbi_info(texturePath, &width, &height, &fileChannels);
+        int channels = textureChannels(fileChannels);
+        unsigned char* data = stbi_load(texturePath, &width, &height, &fileChannels, channels);
+        texture = data ? createTexture(data, width, height, channels) : 0;
+        stbi_image_free(data);
+    }
+
+    double firstFrameMs = 0.0;
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawGrid(program, uniforms, textures);
+
+        swapBuffers(window);
+        pollEvents(window);
+
+        if (frames++ == 0) {
+            firstFrameMs = millisecondsSince(start);
+        }
+    }
+
+    std::cout << "Loaded " << textureCount << " textures before the first frame, shown after " << firstFrameMs
+              << " ms" << std::endl;
+
+    glDeleteTextures(textureCount, textures.data());
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(program.get());
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to create every texture from the mapped asset pack before the first frame
+static int runPacked(int textureCount) {
+    auto start = benchmark_clock::now();
+    queued_program program;
+    unsigned int VAO = 0;
+    grid_uniforms uniforms;
+    window_context* window = setupGrid(packPath, program, VAO);
+    if (!window) {
+        return -1;
+    }
+
+    asset_pack pack;
+    const asset_pack_entry* entry = pack.open(packPath) ? pack.find("texture") : nullptr;
+    if (!entry) {
+        std::cerr << packPath << " has no \"texture\" asset, build it with pack_assets " << packPath << " "
+                  << texturePath << std::endl;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteProgram(program.get());
+        terminateWindow(window);
+        return -1;
+    }
+
+    pack.prefetch(*entry);
+    std::vector<unsigned int> textures(textureCount);
+    for (unsigned int& texture : textures) {
+        texture = createPackedTexture(pack, *entry);
+    }
+    size_t mappedBytes = pack.mappedBytes();
+    pack.close();
+
+    double firstFrameMs = 0.0;
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawGrid(program, uniforms, textures);
+
+        swapBuffers(window);
+        pollEvents(window);
+
+        if (frames++ == 0) {
+            firstFrameMs = millisecondsSince(start);
+        }
+    }
+
+    std::cout << "Created " << textureCount << " textures from " << packPath << " (" << mappedBytes
+              << " bytes mapped) before the first frame, shown after " << firstFrameMs << " ms" << std::endl;
+
+    glDeleteTextures(textureCount, textures.data());
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteProgram(program.get());
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_streaming_256() { return runStreaming(256); }
+static int main_blocking_256() { return runBlocking(256); }
+static int main_pack_256() { return runPacked(256); }
+
+REGISTER_TASK("task_5_streaming_256", "Task 5 at scale: 256 textures decoded by workers and streamed in", main_streaming_256);
+REGISTER_TASK("task_5_blocking_256", "Task 5 at scale: 256 textures loaded before the first frame", main_blocking_256);
+REGISTER_TASK("task_5_pack_256", "Task 5 at scale: 256 textures created from a memory-mapped asset pack", main_pack_256);
@@ -0,0 +1,146 @@
+// Task 5 upload throughput: the same image size in every texture format.
+// Every frame uploads a 1024x1024 image once per format and waits for the
+// upload to finish. The immutable formats are allocated once with
+// texture.h and updated with glTexSubImage2D, the first case respecifies a
+// GL_RGB texture with glTexImage2D every time, as task 5 used to. The
+// block compressed formats upload the image encoded once at start with
+// glCompressedTexSubImage2D. The throughput of each format is printed at
+// the end, in bytes and in pixels.
+
+#include "common/block_compression.h"
+#include "common/task_registry.h"
+#include "common/texture.h"
+#include "common/window.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static const int uploadSize = 1024;
+
+struct upload_case {
+    const char* name;
+    int channels;
+    bool srgb;
+    bool respecify;
+    int blockFormat;  // -1 for pixels, else a block_format
+
+    unsigned int texture;
+    double totalMs;
+    std::vector<unsigned char> blocks;
+};
+
+int main_task_5_upload() {
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    std::vector<upload_case> cases = {
+        {"GL_RGB, glTexImage2D", 3, false, true, -1, 0, 0.0, {}},
+        {"R8", 1, false, false, -1, 0, 0.0, {}},
+        {"RG8", 2, false, false, -1, 0, 0.0, {}},
+        {"RGB8", 3, false, false, -1, 0, 0.0, {}},
+        {"RGBA8", 4, false, false, -1, 0, 0.0, {}},
+        {"SRGB8_ALPHA8", 4, true, false, -1, 0, 0.0, {}},
+        {"BC1", 4, false, false, static_cast<int>(block_format::bc1), 0, 0.0, {}},
+        {"BC3", 4, false, false, static_cast<int>(block_format::bc3), 0, 0.0, {}},
+        {"BC5", 2, false, false, static_cast<int>(block_format::bc5), 0, 0.0, {}},
+        {"BC7", 4, false, false, static_cast<int>(block_format::bc7), 0, 0.0, {}},
+    };
+
+    // Noise, so no driver can take a shortcut on uniform data
+    std::vector<unsigned char> pixels(static_cast<size_t>(uploadSize) * uploadSize * 4);
+    std::mt19937 generator(42);
+    for (unsigned char& value : pixels) {
+        value = static_cast<unsigned char>(generator());
+    }
+
+    // Formats the context cannot sample are left out
+    for (size_t i = 0; i < cases.size();) {
+        if (cases[i].blockFormat >= 0 && !compressedFormatSupported(static_cast<block_format>(cases[i].blockFormat))) {
+            std::cout << cases[i].name << " is not supported, skipped" << std::endl;
+            cases.erase(cases.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            ++i;
+        }
+    }
+
+    for (upload_case& c : cases) {
+        if (c.respecify) {
+            glGenTextures(1, &c.texture);
+        } else if (c.blockFormat >= 0) {
+            block_format format = static_cast<block_format>(c.blockFormat);
+            c.blocks = compressBlocks(pixels.data(), uploadSize, uploadSize, format, block_quality::fast);
+            c.texture = allocateTexture(compressedTextureFormat(format), uploadSize, uploadSize,
+                                        mipLevelCount(uploadSize, uploadSize));
+        } else {
+            c.texture = allocateTexture(textureFormat(c.channels, c.srgb), uploadSize, uploadSize,
+                                        mipLevelCount(uploadSize, uploadSize));
+        }
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (upload_case& c : cases) {
+            texture_format format = textureFormat(c.channels, c.srgb);
+            auto start = std::chrono::steady_clock::now();
+
+            glBindTexture(GL_TEXTURE_2D, c.texture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, unpackAlignment(static_cast<size_t>(uploadSize) * c.channels));
+            if (c.respecify) {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, uploadSize, uploadSize, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                             pixels.data());
+            } else if (c.blockFormat >= 0) {
+                GLenum internalFormat = compressedTextureFormat(static_cast<block_format>(c.blockFormat)).internalFormat;
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uploadSize, uploadSize, internalFormat,
+                                          static_cast<GLsizei>(c.blocks.size()), c.blocks.data());
+            } else {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uploadSize, uploadSize, format.format, GL_UNSIGNED_BYTE,
+                                pixels.data());
+            }
+            glFinish();
+
+            c.totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << "Uploads of " << uploadSize << "x" << uploadSize << " images over " << frames << " frames:"
+                  << std::endl;
+        for (const upload_case& c : cases) {
+            double pixelCount = static_cast<double>(uploadSize) * uploadSize * frames;
+            double bytes = c.blockFormat >= 0 ? static_cast<double>(c.blocks.size()) * frames : pixelCount * c.channels;
+            std::cout << "  " << std::left << std::setw(22) << c.name << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(9) << c.totalMs / frames << " ms, " << std::setw(9)
+                      << std::setprecision(1) << bytes / (c.totalMs * 1000.0) << " MB/s, " << std::setw(9)
+                      << pixelCount / (c.totalMs * 1000.0) << " Mpixels/s" << std::endl;
+        }
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+
+    for (upload_case& c : cases) {
+        glDeleteTextures(1, &c.texture);
+    }
+    terminateWindow(window);
+    return 0;
+}
+
+REGISTER_TASK("task_5_upload", "Task 5: texture upload throughput of every format", main_task_5_upload);
@@ -0,0 +1,207 @@
+// Task 8: Buffers and Meshes
+// 1. Vertex Buffer Objects (VBOs):
+// Implement and use VBOs for efficient rendering.
+// 2. Index Buffer Objects (IBOs):
+// Learn to use IBOs for indexed rendering.
+
+// A scene of many objects built from a handful of different meshes. All
+// meshes share one VBO and one IBO in a mesh_registry. The indirect tasks
+// submit the whole scene with one glMultiDrawElementsIndirect call, the
+// direct tasks draw the same objects with a uniform update and a
+// glDrawElementsBaseVertex call each. Run them with --benchmark to compare.
+
+#include "common/mesh_registry.h"
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/task_registry.h"
+#include "common/window.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// An object of the scene
+struct scene_object {
+    int mesh;
+    glm::mat4 transform;
+    glm::vec4 color;
+};
+
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    uniform mat4 transform;
+    void main() {
+        gl_Position = transform * vec4(aPos, 1.0);
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    uniform vec4 objectColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = objectColor;
+    }
+)";
+
+// Function to add a regular polygon with the given number of sides to the registry
+static int addPolygon(mesh_registry& registry, int sides) {
+    std::vector<float> positions = {0.0f, 0.0f, 0.0f};
+    std::vector<uint32_t> indices;
+    for (int i = 0; i < sides; ++i) {
+        float theta = 2.0f * 3.1415926f * static_cast<float>(i) / static_cast<float>(sides);
+        positions.insert(positions.end(), {0.5f * std::cos(theta), 0.5f * std::sin(theta), 0.0f});
+        indices.insert(indices.end(), {0u, static_cast<uint32_t>(1 + i), static_cast<uint32_t>(1 + (i + 1) % sides)});
+    }
+    return registry.addMesh(positions.data(), static_cast<int>(positions.size() / 3), indices.data(),
+                            static_cast<int>(indices.size()));
+}
+
+// Function to fill the registry with meshes and place the same pseudo-random objects on every run,
+// returns an empty scene if a mesh doesn't fit
+static std::vector<scene_object> createScene(mesh_registry& registry, int count) {
+    std::vector<int> meshes;
+    for (int sides : {3, 4, 5, 6, 8, 12, 24, 48}) {
+        int mesh = addPolygon(registry, sides);
+        if (mesh < 0) {
+            return {};
+        }
+        meshes.push_back(mesh);
+    }
+
+    std::mt19937 generator(2468);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.005f, 0.04f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+    std::uniform_int_distribution<size_t> mesh(0, meshes.size() - 1);
+
+    std::vector<scene_object> scene(count);
+    for (scene_object& object : scene) {
+        object.mesh = meshes[mesh(generator)];
+        object.transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(generator), position(generator), 0.0f));
+        object.transform = glm::rotate(object.transform, angle(generator), glm::vec3(0.0f, 0.0f, 1.0f));
+        object.transform = glm::scale(object.transform, glm::vec3(scale(generator)));
+        object.color = glm::vec4(channel(generator), channel(generator), channel(generator), 1.0f);
+    }
+    return scene;
+}
+
+// Function to draw the scene with one multi-draw indirect call per frame
+static int runIndirect(int objectCount) {
+    // Multi-draw indirect needs OpenGL 4.3, older contexts use the fallback of the registry
+    window_context* window = setupWindow(800, 600, "OpenGL Window", 4, 3);
+    if (!window) {
+        return -1;
+    }
+
+    auto registry = std::make_unique<mesh_registry>(1 << 12, 1 << 13);
+    std::vector<scene_object> scene = createScene(*registry, objectCount);
+    if (scene.empty()) {
+        registry.reset();
+        terminateWindow(window);
+        return -1;
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (const scene_object& object : scene) {
+            registry->addDraw(object.mesh, draw_data{object.transform, object.color});
+        }
+        registry->submit();
+        registry->endFrame();
+
+        swapBuffers(window);
+        pollEvents(window);
+        frames++;
+    }
+
+    if (frames > 0) {
+        std::cout << (registry->indirect() ? "Multi-draw indirect: " : "Instanced fallback: ") << objectCount
+                  << " objects in " << registry->drawCalls() / frames << " draw calls per frame" << std::endl;
+    }
+
+    registry.reset();
+    terminateWindow(window);
+    return 0;
+}
+
+// Function to draw the scene from the same buffers with one draw call per object
+static int runDirect(int objectCount) {
+    window_context* window = setupWindow(800, 600, "OpenGL Window", 4, 3);
+    if (!window) {
+        return -1;
+    }
+
+    // The driver compiles while the registry and the scene are set up
+    queued_program program(vertexShaderSource, fragmentShaderSource);
+
+    auto registry = std::make_unique<mesh_registry>(1 << 12, 1 << 13);
+    std::vector<scene_object> scene = createScene(*registry, objectCount);
+
+    unsigned int shaderProgram = program.get();
+    if (scene.empty()) {
+        registry.reset();
+        glDeleteProgram(shaderProgram);
+        terminateWindow(window);
+        return -1;
+    }
+    program_reflection reflection(shaderProgram);
+    uniform_handle<glm::mat4> transform = reflection.uniform<glm::mat4>("transform");
+    uniform_handle<glm::vec4> objectColor = reflection.uniform<glm::vec4>("objectColor");
+    if (!reflection.valid()) {
+        registry.reset();
+        glDeleteProgram(shaderProgram);
+        terminateWindow(window);
+        return -1;
+    }
+
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glUseProgram(shaderProgram);
+        glBindVertexArray(registry->vertexArray());
+
+        for (const scene_object& object : scene) {
+            const mesh_range& range = registry->mesh(object.mesh);
+            setUniform(transform, object.transform);
+            setUniform(objectColor, object.color);
+            glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+                                     (void*)(range.firstIndex * sizeof(uint32_t)), range.baseVertex);
+        }
+
+        glBindVertexArray(0);
+
+        swapBuffers(window);
+        pollEvents(window);
+    }
+
+    registry.reset();
+    glDeleteProgram(shaderProgram);
+
+    terminateWindow(window);
+    return 0;
+}
+
+static int main_indirect_10k() { return runIndirect(10000); }
+static int main_indirect_100k() { return runIndirect(100000); }
+static int main_direct_10k() { return runDirect(10000); }
+static int main_direct_100k() { return runDirect(100000); }
+
+REGISTER_TASK("task_8_indirect_10k", "Task 8: 10k objects of 8 meshes in one multi-draw indirect call", main_indirect_10k);
+REGISTER_TASK("task_8_indirect_100k", "Task 8: 100k objects of 8 meshes in one multi-draw indirect call", main_indirect_100k);
+REGISTER_TASK("task_8_direct_10k", "Task 8: 10k objects of 8 meshes, one draw call each", main_direct_10k);
+REGISTER_TASK("task_8_direct_100k", "Task 8: 100k objects of 8 meshes, one draw call each", main_direct_100k);
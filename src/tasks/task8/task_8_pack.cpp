@@ -0,0 +1,141 @@
+// Task 8: Buffers and Meshes
+// A textured cube whose vertex and index buffers, and texture, are created
+// straight from the memory-mapped asset pack: the mapped ranges go to
+// glBufferData and glTexSubImage2D as they are. Build the pack from the
+// cube.obj and texture.png at the root of the repository with
+//     pack_assets assets.pack texture.png cube.obj
+
+#include "common/asset_pack.h"
+#include "common/packed_mesh.h"
+#include "common/shader.h"
+#include "common/shader_reflection.h"
+#include "common/task_registry.h"
+#include "common/texture.h"
+#include "common/window.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+static const char* packPath = "assets.pack";
+
+static const char* vertexShaderSource = R"(
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    layout (location = 2) in vec2 aTexCoord;
+    uniform mat4 model;
+    uniform mat4 viewProjection;
+    out vec3 Normal;
+    out vec2 TexCoord;
+    void main() {
+        gl_Position = viewProjection * model * vec4(aPos, 1.0);
+        Normal = mat3(model) * aNormal;
+        TexCoord = aTexCoord;
+    }
+)";
+
+static const char* fragmentShaderSource = R"(
+    #version 330 core
+    in vec3 Normal;
+    in vec2 TexCoord;
+    uniform sampler2D texture1;
+    out vec4 FragColor;
+    void main() {
+        float light = 0.3 + 0.7 * max(dot(normalize(Normal), normalize(vec3(0.4, 0.8, 1.0))), 0.0);
+        FragColor = vec4(texture(texture1, TexCoord).rgb * light, 1.0);
+    }
+)";
+
+int main_task_8_pack() {
+    if (!std::ifstream(packPath)) {
+        std::cerr << "The cube needs " << packPath << " in the working directory, build it with pack_assets "
+                  << packPath << " texture.png cube.obj" << std::endl;
+        return -1;
+    }
+
+    window_context* window = setupWindow(800, 600, "OpenGL Window");
+    if (!window) {
+        return -1;
+    }
+
+    // The driver compiles while the pack is mapped and the buffers are created
+    queued_program program(vertexShaderSource, fragmentShaderSource);
+
+    auto start = std::chrono::steady_clock::now();
+    asset_pack pack;
+    const asset_pack_entry* meshEntry = pack.open(packPath) ? pack.find("cube") : nullptr;
+    const asset_pack_entry* textureEntry = pack.isOpen() ? pack.find("texture") : nullptr;
+    packed_mesh cube;
+    unsigned int texture = 0;
+    if (meshEntry && textureEntry) {
+        pack.prefetch(*meshEntry);
+        pack.prefetch(*textureEntry);
+        if (createPackedMesh(pack, *meshEntry, cube)) {
+            texture = createPackedTexture(pack, *textureEntry);
+        }
+    }
+    double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t mappedBytes = pack.mappedBytes();
+    pack.close();
+
+    unsigned int shaderProgram = program.get();
+    program_reflection reflection(shaderProgram);
+    uniform_handle<glm::mat4> model = reflection.uniform<glm::mat4>("model");
+    uniform_handle<glm::mat4> viewProjection = reflection.uniform<glm::mat4>("viewProjection");
+    uniform_handle<int> sampler = reflection.uniform<int>("texture1");
+    if (texture == 0 || !reflection.valid()) {
+        if (texture == 0) {
+            std::cerr << packPath << " has no usable \"cube\" mesh and \"texture\" texture, build it with pack_assets "
+                      << packPath << " texture.png cube.obj" << std::endl;
+        }
+        deletePackedMesh(cube);
+        glDeleteTextures(1, &texture);
+        glDeleteProgram(shaderProgram);
+        terminateWindow(window);
+        return -1;
+    }
+
+    std::cout << "Created the cube (" << cube.vertexCount << " vertices, " << cube.indexCount / 3
+              << " triangles) and its texture from " << packPath << " (" << mappedBytes << " bytes mapped) in "
+              << createMs << " ms" << std::endl;
+
+    // The cube is convex, so culling the faces turned away is enough without a depth buffer
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 10.0f);
+    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+    glUseProgram(shaderProgram);
+    setUniform(viewProjection, projection * view);
+    setUniform(sampler, 0);
+    glEnable(GL_CULL_FACE);
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    setSwapInterval(window, 1);
+
+    long frames = 0;
+    while (!windowShouldClose(window)) {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        float angle = 0.02f * static_cast<float>(frames++);
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.3f, 1.0f, 0.1f));
+        glUseProgram(shaderProgram);
+        setUniform(model, glm::rotate(rotation, 0.6f, glm::vec3(1.0f, 0.0f, 0.0f)));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindVertexArray(cube.VAO);
+        glDrawElements(GL_TRIANGLES, cube.indexCount, GL_UNSIGNED_INT, nullptr);
+        glBindVertexArray(0);
+
+        swapBuffers(window);
+        pollEvents(window);
+    }
+
+    glDisable(GL_CULL_FACE);
+    deletePackedMesh(cube);
+    glDeleteTextures(1, &texture);
+    glDeleteProgram(shaderProgram);
+    terminateWindow(window);
+    return 0;
+}
+
+REGISTER_TASK("task_8_pack", "Task 8: a textured cube created from the memory-mapped asset pack", main_task_8_pack);
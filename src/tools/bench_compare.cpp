@@ -0,0 +1,245 @@
+// Compares two benchmark result files written by `main --benchmark`.
+//
+// Usage: bench_compare <baseline.json> <current.json> [--threshold <percent>] [--min-delta <ms>]
+//
+// For every task present in both files, the median, p95 and p99 of the frame,
+// CPU and GPU times are compared. A task run more than once is matched run by
+// run, its second run is reported as task#2 and so on. A metric regresses when it grew by more than
+// the threshold (default 5%) and by more than the minimum delta (default
+// 0.01 ms, which hides noise on very short frames). The exit code is 1 if any
+// metric regressed, so the tool can gate a CI job.
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Flattened view of a result file: "task/metric/statistic" -> value
+typedef std::map<std::string, double> benchmark_values;
+
+// Minimal parser for the JSON subset written by writeBenchmarkResults()
+struct json_parser {
+    const std::string& text;
+    size_t position = 0;
+    bool failed = false;
+
+    explicit json_parser(const std::string& text) : text(text) {}
+
+    void skipSpace() {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    std::string parseString() {
+        std::string value;
+        if (!consume('"')) {
+            failed = true;
+            return value;
+        }
+        while (position < text.size() && text[position] != '"') {
+            if (text[position] == '\\' && position + 1 < text.size()) {
+                position++;
+            }
+            value += text[position++];
+        }
+        position++;
+        return value;
+    }
+
+    double parseNumber() {
+        skipSpace();
+        const char* start = text.c_str() + position;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start) {
+            failed = true;
+        }
+        position += end - start;
+        return value;
+    }
+
+    // Number of runs seen so far for each task name
+    std::map<std::string, int> taskRuns;
+
+    // Parses any value, numbers are stored in values under the given path
+    void parseValue(const std::string& path, benchmark_values& values, std::string& task) {
+        skipSpace();
+        if (failed || position >= text.size()) {
+            failed = true;
+            return;
+        }
+
+        char c = text[position];
+        if (c == '{') {
+            position++;
+            if (consume('}')) {
+                return;
+            }
+            do {
+                std::string key = parseString();
+                if (!consume(':')) {
+                    failed = true;
+                    return;
+                }
+                if (key == "task") {
+                    task = parseString();
+                } else {
+                    parseValue(path + "/" + key, values, task);
+                }
+            } while (!failed && consume(','));
+            if (!consume('}')) {
+                failed = true;
+            }
+        } else if (c == '[') {
+            position++;
+            if (consume(']')) {
+                return;
+            }
+            do {
+                // Every run is a new task scope, the task name may come after its statistics
+                benchmark_values run;
+                std::string runTask;
+                parseValue("", run, runTask);
+                if (runTask.empty()) {
+                    failed = true;
+                    return;
+                }
+
+                // Repeated runs of a task are told apart as task#2, task#3 and so on
+                int count = ++taskRuns[runTask];
+                std::string prefix = count == 1 ? runTask : runTask + "#" + std::to_string(count);
+                for (const auto& [key, value] : run) {
+                    values[prefix + key] = value;
+                }
+            } while (!failed && consume(','));
+            if (!consume(']')) {
+                failed = true;
+            }
+        } else if (c == '"') {
+            parseString();
+        } else {
+            double value = parseNumber();
+            values[path] = value;
+        }
+    }
+};
+
+static bool loadResults(const char* path, benchmark_values& values) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    // The runs array is the only content of the top level object
+    json_parser parser(text);
+    std::string task;
+    if (!parser.consume('{') || parser.parseString() != "runs" || !parser.consume(':')) {
+        std::cerr << path << " is not a benchmark result file" << std::endl;
+        return false;
+    }
+    parser.parseValue("", values, task);
+
+    if (parser.failed) {
+        std::cerr << "Failed to parse " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <baseline.json> <current.json> [--threshold <percent>] [--min-delta <ms>]" << std::endl;
+        return 2;
+    }
+
+    double threshold = 5.0;
+    double minDelta = 0.01;
+    for (int i = 3; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--min-delta") == 0 && i + 1 < argc) {
+            minDelta = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    benchmark_values baseline, current;
+    if (!loadResults(argv[1], baseline) || !loadResults(argv[2], current)) {
+        return 2;
+    }
+
+    const char* metrics[] = {"frame_ms", "cpu_ms", "gpu_ms"};
+    const char* statistics[] = {"median", "p95", "p99"};
+
+    int regressions = 0;
+    int compared = 0;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const auto& [key, before] : baseline) {
+        // Only compare the selected statistics, e.g. "task_5/frame_ms/median"
+        size_t statisticStart = key.rfind('/');
+        size_t metricStart = key.rfind('/', statisticStart - 1);
+        if (statisticStart == std::string::npos || metricStart == std::string::npos) {
+            continue;
+        }
+
+        std::string metric = key.substr(metricStart + 1, statisticStart - metricStart - 1);
+        std::string statistic = key.substr(statisticStart + 1);
+
+        bool selected = false;
+        for (const char* m : metrics) {
+            for (const char* s : statistics) {
+                selected = selected || (metric == m && statistic == s);
+            }
+        }
+
+        auto match = current.find(key);
+        if (!selected || match == current.end()) {
+            continue;
+        }
+
+        double after = match->second;
+        double change = before > 0.0 ? (after - before) / before * 100.0 : 0.0;
+        bool regressed = change > threshold && after - before > minDelta;
+
+        compared++;
+        if (regressed) {
+            regressions++;
+        }
+
+        std::cout << (regressed ? "REGRESSION " : "           ") << std::left << std::setw(36) << key << std::right
+                  << std::setw(10) << before << " ms -> " << std::setw(10) << after << " ms  "
+                  << std::showpos << change << std::noshowpos << "%" << std::endl;
+    }
+
+    if (compared == 0) {
+        std::cerr << "No common tasks to compare" << std::endl;
+        return 2;
+    }
+
+    std::cout << regressions << " of " << compared << " metrics regressed by more than " << threshold << "%" << std::endl;
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,258 @@
+// Packs textures and meshes into an asset pack for asset_pack.h.
+//
+// Usage: pack_assets <output.pack> <file>... [--filter box|kaiser] [--srgb]
+//
+// Each file becomes an asset named after it without directory and
+// extension, texture.png becomes "texture":
+//   - images are decoded with stb_image (gray stays one or two channels,
+//     RGB gets alpha) and stored with their full mip chain, taken from the
+//     cooked .mips file next to them if there is one (mip_chain.h) and it
+//     was cooked for the same color space
+//   - .dds and .ktx2 files are stored with their BCn levels as they are
+//   - .obj meshes are stored as interleaved float positions, normals and
+//     texture coordinates (32 bytes per vertex) with 32-bit indices
+// --srgb marks the images as sRGB color.
+
+#include "common/asset_pack.h"
+#include "common/compressed_texture.h"
+#include "common/mip_chain.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <output.pack> <file>... [--filter box|kaiser] [--srgb]" << std::endl;
+}
+
+// The file name without its directory and extension
+static std::string assetName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+static std::string lowercaseExtension(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    std::string extension = dot == std::string::npos ? std::string() : name.substr(dot + 1);
+    for (char& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return extension;
+}
+
+// Vertex of a packed OBJ mesh, read back as packed_mesh_vertex (packed_mesh.h)
+struct obj_vertex {
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+};
+
+// Function to read the positions, normals and texture coordinates of an OBJ file, faces are fanned into triangles
+static bool readObj(const std::string& path, std::vector<obj_vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::array<float, 3>> positions, normals;
+    std::vector<std::array<float, 2>> texCoords;
+    std::map<std::array<int, 3>, uint32_t> unique;
+
+    // OBJ indices start at 1, negative ones count back from the last element
+    auto resolve = [](int index, size_t count) { return index < 0 ? static_cast<int>(count) + index : index - 1; };
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        if (type == "v") {
+            std::array<float, 3> p = {};
+            stream >> p[0] >> p[1] >> p[2];
+            positions.push_back(p);
+        } else if (type == "vn") {
+            std::array<float, 3> n = {};
+            stream >> n[0] >> n[1] >> n[2];
+            normals.push_back(n);
+        } else if (type == "vt") {
+            std::array<float, 2> t = {};
+            stream >> t[0] >> t[1];
+            texCoords.push_back(t);
+        } else if (type == "f") {
+            std::vector<uint32_t> face;
+            std::string corner;
+            while (stream >> corner) {
+                // v, v/vt, v//vn or v/vt/vn, -1 marks an element the corner leaves out
+                std::array<int, 3> key = {-1, -1, -1};
+                bool hasTexCoord = false, hasNormal = false;
+                size_t first = corner.find('/');
+                key[0] = resolve(std::atoi(corner.c_str()), positions.size());
+                if (first != std::string::npos) {
+                    size_t second = corner.find('/', first + 1);
+                    if (second != first + 1) {
+                        hasTexCoord = true;
+                        key[1] = resolve(std::atoi(corner.c_str() + first + 1), texCoords.size());
+                    }
+                    if (second != std::string::npos) {
+                        hasNormal = true;
+                        key[2] = resolve(std::atoi(corner.c_str() + second + 1), normals.size());
+                    }
+                }
+
+                // An index that is given must name an element, even a negative one counting back too far
+                auto outOfRange = [](int index, size_t count) { return index < 0 || index >= static_cast<int>(count); };
+                if (outOfRange(key[0], positions.size()) || (hasTexCoord && outOfRange(key[1], texCoords.size())) ||
+                    (hasNormal && outOfRange(key[2], normals.size()))) {
+                    std::cerr << path << ":" << lineNumber << ": index out of range" << std::endl;
+                    return false;
+                }
+
+                auto found = unique.find(key);
+                if (found == unique.end()) {
+                    obj_vertex vertex = {};
+                    std::memcpy(vertex.position, positions[key[0]].data(), sizeof(vertex.position));
+                    if (key[1] >= 0) {
+                        std::memcpy(vertex.texCoord, texCoords[key[1]].data(), sizeof(vertex.texCoord));
+                    }
+                    if (key[2] >= 0) {
+                        std::memcpy(vertex.normal, normals[key[2]].data(), sizeof(vertex.normal));
+                    }
+                    found = unique.emplace(key, static_cast<uint32_t>(vertices.size())).first;
+                    vertices.push_back(vertex);
+                }
+                face.push_back(found->second);
+            }
+            for (size_t i = 2; i < face.size(); ++i) {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+    }
+
+    if (indices.empty()) {
+        std::cerr << path << " has no faces" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string output;
+    std::vector<std::string> inputs;
+    mip_filter filter = mip_filter::box;
+    bool srgb = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "box") {
+                filter = mip_filter::box;
+            } else if (name == "kaiser") {
+                filter = mip_filter::kaiser;
+            } else {
+                std::cerr << "Unknown filter: " << name << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--srgb") == 0) {
+            srgb = true;
+        } else if (argv[i][0] != '-' && output.empty()) {
+            output = argv[i];
+        } else if (argv[i][0] != '-') {
+            inputs.push_back(argv[i]);
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (output.empty() || inputs.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    asset_pack_writer writer;
+    for (const std::string& input : inputs) {
+        std::string name = assetName(input);
+        std::string extension = lowercaseExtension(input);
+        bool added = false;
+
+        if (isCompressedTexturePath(input)) {
+            compressed_texture texture;
+            added = readCompressedTexture(input, texture) && writer.addCompressedTexture(name, texture);
+            if (added) {
+                std::cout << name << ": " << blockFormatName(texture.format) << " texture, " << texture.width << "x"
+                          << texture.height << ", " << texture.levels.size() << " levels" << std::endl;
+            }
+        } else if (extension == "obj") {
+            std::vector<obj_vertex> vertices;
+            std::vector<uint32_t> indices;
+            added = readObj(input, vertices, indices) &&
+                    writer.addMesh(name, vertices.data(), vertices.size(), sizeof(obj_vertex), indices.data(),
+                                   indices.size());
+            if (added) {
+                std::cout << name << ": mesh, " << vertices.size() << " vertices, " << indices.size() / 3
+                          << " triangles" << std::endl;
+            }
+        } else {
+            mip_chain chain;
+            bool cooked = readCookedTexture(input, chain);
+            if (cooked && chain.srgb != srgb) {
+                // Its levels were filtered in the other color space, so the image is cooked again
+                std::cerr << cookedTexturePath(input) << " was cooked " << (chain.srgb ? "with" : "without")
+                          << " --srgb, ignoring it" << std::endl;
+                chain = mip_chain();
+                cooked = false;
+            }
+            if (!cooked) {
+                int width = 0, height = 0, fileChannels = 0;
+                unsigned char* pixels = nullptr;
+                int channels = 0;
+                if (stbi_info(input.c_str(), &width, &height, &fileChannels)) {
+                    channels = fileChannels == 3 ? 4 : fileChannels;
+                    pixels = stbi_load(input.c_str(), &width, &height, &fileChannels, channels);
+                }
+                if (!pixels) {
+                    std::cerr << "Failed to decode " << input << ". Error: " << stbi_failure_reason() << std::endl;
+                    return 1;
+                }
+                chain = generateMipChain(pixels, width, height, channels, srgb, filter);
+                stbi_image_free(pixels);
+            }
+            added = writer.addTexture(name, chain);
+            if (added) {
+                std::cout << name << ": texture, " << chain.width << "x" << chain.height << " with " << chain.channels
+                          << " channels, " << chain.levels.size() << " levels" << (cooked ? " (cooked)" : "")
+                          << std::endl;
+            }
+        }
+
+        if (!added) {
+            return 1;
+        }
+    }
+
+    if (!writer.write(output)) {
+        return 1;
+    }
+    std::cout << "Packed " << writer.size() << " assets into " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Compresses images into BC1, BC3, BC5 or BC7 textures for texture_loader.
+//
+// Usage: texture_compress <image> [--output <file.dds|file.ktx2>] [--format bc1|bc3|bc5|bc7]
+//                         [--quality fast|normal|high] [--mips] [--srgb] [--threads <count>]
+//
+// The image is decoded to RGBA with stb_image and compressed with the
+// encoder of block_compression.h, by default to BC7 at normal quality in a
+// DDS file next to the image. --mips also filters the mip chain
+// (mip_chain.h) and compresses every level. The compression time and the
+// PSNR of the first level against the image are printed.
+
+#include "common/block_compression.h"
+#include "common/compressed_texture.h"
+#include "common/mip_chain.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <image> [--output <file.dds|file.ktx2>] [--format bc1|bc3|bc5|bc7] [--quality fast|normal|high]"
+                 " [--mips] [--srgb] [--threads <count>]"
+              << std::endl;
+}
+
+// Function to measure the peak signal to noise ratio of channels [first, first + count) in dB
+static double psnr(const unsigned char* a, const unsigned char* b, size_t pixels, int first, int count) {
+    double squared = 0.0;
+    for (size_t i = 0; i < pixels; ++i) {
+        for (int c = first; c < first + count; ++c) {
+            double d = static_cast<double>(a[i * 4 + c]) - static_cast<double>(b[i * 4 + c]);
+            squared += d * d;
+        }
+    }
+    double mse = squared / (static_cast<double>(pixels) * count);
+    return mse == 0.0 ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+int main(int argc, char** argv) {
+    std::string input, output;
+    block_format format = block_format::bc7;
+    block_quality quality = block_quality::normal;
+    bool mips = false, srgb = false;
+    int threads = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "bc1") {
+                format = block_format::bc1;
+            } else if (name == "bc3") {
+                format = block_format::bc3;
+            } else if (name == "bc5") {
+                format = block_format::bc5;
+            } else if (name == "bc7") {
+                format = block_format::bc7;
+            } else {
+                std::cerr << "Unknown format: " << name << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "fast") {
+                quality = block_quality::fast;
+            } else if (name == "normal") {
+                quality = block_quality::normal;
+            } else if (name == "high") {
+                quality = block_quality::high;
+            } else {
+                std::cerr << "Unknown quality: " << name << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--mips") == 0) {
+            mips = true;
+        } else if (std::strcmp(argv[i], "--srgb") == 0) {
+            srgb = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && input.empty()) {
+            input = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (input.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (output.empty()) {
+        size_t slash = input.find_last_of("/\\"), dot = input.find_last_of('.');
+        bool extension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+        output = (extension ? input.substr(0, dot) : input) + ".dds";
+    }
+
+    int width = 0, height = 0, fileChannels = 0;
+    unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &fileChannels, 4);
+    if (!pixels) {
+        std::cerr << "Failed to decode " << input << ". Error: " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    // Every level in RGBA, the image alone without --mips
+    mip_chain chain;
+    if (mips) {
+        chain = generateMipChain(pixels, width, height, 4, srgb, mip_filter::kaiser, threads);
+    } else {
+        size_t size = static_cast<size_t>(width) * height * 4;
+        chain.width = width;
+        chain.height = height;
+        chain.channels = 4;
+        chain.levels.push_back({width, height, 0, size});
+        chain.data.assign(pixels, pixels + size);
+    }
+    stbi_image_free(pixels);
+
+    compressed_texture texture;
+    texture.format = format;
+    texture.srgb = srgb && format != block_format::bc5;
+    texture.width = width;
+    texture.height = height;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const mip_level& level : chain.levels) {
+        std::vector<unsigned char> blocks = compressBlocks(chain.data.data() + level.offset, level.width,
+                                                           level.height, format, quality, threads);
+        texture.levels.push_back({level.width, level.height, texture.data.size(), blocks.size()});
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (!writeCompressedTexture(output, texture)) {
+        return 1;
+    }
+
+    // Error of the first level, alpha only counts where the image has some
+    const unsigned char* original = chain.data.data();
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<unsigned char> decoded(pixelCount * 4);
+    decompressBlocks(texture.data.data(), width, height, format, decoded.data());
+    bool translucent = false;
+    for (size_t i = 0; i < pixelCount && !translucent; ++i) {
+        translucent = original[i * 4 + 3] != 255;
+    }
+
+    static const char* qualityNames[] = {"fast", "normal", "high"};
+    // The levels of a generated chain are aligned, so the padding between them doesn't count
+    size_t uncompressed = 0;
+    for (const mip_level& level : chain.levels) {
+        uncompressed += level.size;
+    }
+    std::cout << input << ": " << width << "x" << height << ", " << texture.levels.size() << " levels in "
+              << blockFormatName(format) << " (" << qualityNames[static_cast<int>(quality)] << "), "
+              << texture.data.size() << " bytes instead of " << uncompressed << " ("
+              << static_cast<double>(uncompressed) / texture.data.size() << "x smaller) in " << ms << " ms, "
+              << static_cast<double>(uncompressed / 4) / (ms * 1000.0) << " Mpixels/s" << std::endl;
+    std::cout << "PSNR " << (format == block_format::bc5 ? "rg " : "rgb ")
+              << psnr(original, decoded.data(), pixelCount, 0, format == block_format::bc5 ? 2 : 3) << " dB";
+    if (translucent && format != block_format::bc5) {
+        std::cout << ", alpha " << psnr(original, decoded.data(), pixelCount, 3, 1) << " dB";
+    }
+    std::cout << ", written to " << output << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Cooks images into mip chains for texture_loader.
+//
+// Usage: texture_cook <image> [--output <file.mips>] [--filter box|kaiser] [--srgb] [--threads <count>]
+//
+// The image is decoded with stb_image, gray images keep one or two channels
+// and RGB gets an alpha channel, as texture_loader would upload them. Every
+// mip level is filtered on the CPU (see mip_chain.h) and the chain is
+// written next to the image, texture.png becomes texture.mips, unless
+// --output names another file.
+
+#include "common/mip_chain.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " <image> [--output <file.mips>] [--filter box|kaiser] [--srgb] [--threads <count>]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string input, output;
+    mip_filter filter = mip_filter::kaiser;
+    bool srgb = false;
+    int threads = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "box") {
+                filter = mip_filter::box;
+            } else if (name == "kaiser") {
+                filter = mip_filter::kaiser;
+            } else {
+                std::cerr << "Unknown filter: " << name << std::endl;
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--srgb") == 0) {
+            srgb = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && input.empty()) {
+            input = argv[i];
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (input.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (output.empty()) {
+        output = cookedTexturePath(input);
+    }
+
+    int width = 0, height = 0, fileChannels = 0;
+    if (!stbi_info(input.c_str(), &width, &height, &fileChannels)) {
+        std::cerr << "Failed to read " << input << ". Error: " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+    int channels = fileChannels == 3 ? 4 : fileChannels;
+    unsigned char* pixels = stbi_load(input.c_str(), &width, &height, &fileChannels, channels);
+    if (!pixels) {
+        std::cerr << "Failed to decode " << input << ". Error: " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    mip_chain chain = generateMipChain(pixels, width, height, channels, srgb, filter, threads);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stbi_image_free(pixels);
+
+    // Stamped with the image, so the loaders ignore the file once the image changes
+    if (chain.levels.empty() || !stampMipChain(input, chain) || !writeMipChain(output, chain)) {
+        return 1;
+    }
+
+    std::cout << input << ": " << width << "x" << height << " with " << channels << " channels, "
+              << chain.levels.size() << " levels filtered with " << (filter == mip_filter::box ? "box" : "kaiser")
+              << (srgb ? " in linear light" : "") << " in " << ms << " ms (" << mipFilterInstructionSet()
+              << "), written to " << output << std::endl;
+    return 0;
+}